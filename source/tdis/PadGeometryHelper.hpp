@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>   // For std::max
+#include <array>
 #include <cmath>       // For std::cos, std::sin, M_PI
+#include <cstdint>
 #include <stdexcept>   // For std::invalid_argument
+#include <string>
+#include <tuple>
 #include <utility>     // For std::pair
 
 // Constants
@@ -26,6 +31,12 @@ namespace tdis {
         return r * 2 * M_PI / num_pads_per_ring;
     }
 
+    inline double getPadXYVariance(const int ring) {
+        /** variance of hit x and y taken as uniform distribution RMS (size / sqrt(12)) over the larger pad dimension */
+        const double size = std::max(getPadApproxWidth(ring), getPadHight());
+        return size * size / 12.0;
+    }
+
     inline double getRingCenterRadius(const int ring) {
         /*
         Compute the X and Y coordinates of the center of a pad given its ring and pad indices.
@@ -48,6 +59,26 @@ namespace tdis {
         return r_center;
     }
 
+    inline double getPadCenterPhi(const int ring, const int pad) {
+        /** angle of the pad center in [0, 2π]. Ring and pad indexes are not checked */
+
+        // Determine the angular offset for odd rings
+        const double theta_offset = (ring % 2 == 0) ? 0.0 : delta_theta / 2.0;
+
+        // Compute the angular center of the pad (in radians)
+        const double theta_clockwise = pad * delta_theta + theta_offset + delta_theta / 2.0;
+
+        // Convert to counterclockwise angle for standard coordinate system
+        //double theta_center = 2 * M_PI - theta_clockwise;
+        double theta_center = theta_clockwise;
+
+        // Ensure theta_center is within [0, 2π]
+        if (theta_center < 0) {
+            theta_center += 2 * M_PI;
+        }
+        return theta_center;
+    }
+
     inline std::tuple<double, double> getPadCenter(const int ring, const int pad) {
         /*
         Compute the X and Y coordinates of the center of a pad given its ring and pad indices.
@@ -71,20 +102,8 @@ namespace tdis {
         // Compute radial center of the ring
         const double r_center = getRingCenterRadius(ring);
 
-        // Determine the angular offset for odd rings
-        const double theta_offset = (ring % 2 == 0) ? 0.0 : delta_theta / 2.0;
-
-        // Compute the angular center of the pad (in radians)
-        const double theta_clockwise = pad * delta_theta + theta_offset + delta_theta / 2.0;
-
-        // Convert to counterclockwise angle for standard coordinate system
-        //double theta_center = 2 * M_PI - theta_clockwise;
-        double theta_center = theta_clockwise;
-
-        // Ensure theta_center is within [0, 2π]
-        if (theta_center < 0) {
-            theta_center += 2 * M_PI;
-        }
+        // Angular center of the pad (in radians)
+        const double theta_center = getPadCenterPhi(ring, pad);
 
         // Convert from polar to Cartesian coordinates
         double x = r_center * std::cos(theta_center);
@@ -93,4 +112,62 @@ namespace tdis {
         return { x, y };
     }
 
-}
\ No newline at end of file
+
+    /** Pad geometry of all num_rings x num_pads_per_ring pads computed once with the functions above,
+     *  so hit reconstruction takes positions, widths and covariances from tables instead of
+     *  trigonometry and throwing range checks for every hit */
+    struct PadGeometryTable {
+        struct Pad {
+            double x;               // Pad center
+            double y;
+            double phi;             // Pad center angle in [0, 2π]
+            uint32_t cell_id;       // Ring and pad part of hit cellID (see GetCellId)
+        };
+
+        struct Ring {
+            double radius;          // Ring center radius
+            double pad_width;       // Approximate pad width (getPadApproxWidth)
+            double xy_variance;     // Hit x and y variance (getPadXYVariance)
+        };
+
+        std::array<Ring, num_rings> rings;
+        std::array<Pad, num_rings * num_pads_per_ring> pads;
+
+        static bool IsValid(const int ring, const int pad) {
+            return static_cast<unsigned>(ring) < num_rings && static_cast<unsigned>(pad) < num_pads_per_ring;
+        }
+
+        /// Ring and pad must be valid (see IsValid)
+        const Pad& GetPad(const int ring, const int pad) const { return pads[ring * num_pads_per_ring + pad]; }
+
+        const Ring& GetRing(const int ring) const { return rings[ring]; }
+
+        /// Hit cellID: 1'000'000 * plane + 1'000 * ring + pad
+        uint32_t GetCellId(const int plane, const int ring, const int pad) const {
+            return 1'000'000u * static_cast<uint32_t>(plane) + GetPad(ring, pad).cell_id;
+        }
+
+        /// Plane, ring and pad of a hit cellID made by GetCellId
+        static std::tuple<int, int, int> DecodeCellId(const uint64_t cell_id) {
+            return {static_cast<int>(cell_id / 1'000'000), static_cast<int>(cell_id / 1'000 % 1'000), static_cast<int>(cell_id % 1'000)};
+        }
+    };
+
+    inline PadGeometryTable buildPadGeometryTable() {
+        PadGeometryTable table{};
+        for (int ring = 0; ring < num_rings; ring++) {
+            table.rings[ring] = {getRingCenterRadius(ring), getPadApproxWidth(ring), getPadXYVariance(ring)};
+            for (int pad = 0; pad < num_pads_per_ring; pad++) {
+                auto [x, y] = getPadCenter(ring, pad);
+                table.pads[ring * num_pads_per_ring + pad] = {x, y, getPadCenterPhi(ring, pad), static_cast<uint32_t>(1'000 * ring + pad)};
+            }
+        }
+        return table;
+    }
+
+    inline const PadGeometryTable& getPadGeometryTable() {
+        /** the table is built on the first call */
+        static const PadGeometryTable table = buildPadGeometryTable();
+        return table;
+    }
+}
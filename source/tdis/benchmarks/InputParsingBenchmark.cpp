@@ -0,0 +1,306 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  tdis_input_benchmark - measures speed of digitized text input, so input optimizations can be compared by numbers
+ *
+ *  Generates digitized .txt corpora in both column layouts (6 columns and 9 columns with true X Y Z) with short
+ *  and long tracks (hits per track are spread around the corpus mean). Real files given as arguments are
+ *  measured too. For each corpus MB/s and events/s are reported for:
+ *
+ *    SplitDataString       - std::string tokens of every line (std::getline path)
+ *    ParseTrackHitTokens   - tokenizing of hit lines with per hit column count detection
+ *    ParseHitLine          - layout specialized hit parser (used by the sources)
+ *    ReadNextEventLines    - std::getline event reading (io:use_mmap=false)
+ *    Emit mmap             - DigitizedDataEventSource::Emit, reading and parsing of memory mapped file
+ *    Emit getline          - the same with io:use_mmap=false
+ *
+ *  Emit is measured with io:parallel_parse=false and io:prefetch_events=0, so all the work is done in Emit.
+ *  Each measurement is repeated and the best time is taken.
+ *
+ *  Usage:
+ *      tdis_input_benchmark [--events 20000] [--repeat 3] [--dir /tmp/tdis_input_benchmark] [--keep] [files...]
+ **/
+
+#include <JANA/JApplication.h>
+#include <JANA/JEvent.h>
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include <Acts/Definitions/Units.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "PadGeometryHelper.hpp"
+#include "io/DigitizedDataEventSource.hpp"
+#include "io/DigitizedTextParser.hpp"
+#include "services/InputFilesService.hpp"
+#include "services/LogService.hpp"
+
+namespace {
+
+    using namespace tdis::io;
+
+    /** Generated corpus: layout and hits per track spread */
+    struct CorpusConfig {
+        std::string name;
+        HitLayout layout;
+        size_t min_hits;
+        size_t max_hits;
+    };
+
+    /** Writes a digitized text file with the same formatting as the digitizer output */
+    void GenerateCorpus(const CorpusConfig& cfg, const std::string& path, size_t events, uint64_t seed) {
+        std::mt19937_64 generator(seed);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        std::uniform_int_distribution<size_t> hits_per_track(cfg.min_hits, cfg.max_hits);
+        std::gamma_distribution<double> adc(4.0, 1.25e-8);
+
+        std::ofstream output(path);
+        if (!output) {
+            throw std::runtime_error(fmt::format("Could not create corpus file '{}'", path));
+        }
+
+        std::string text;
+        for (size_t event = 0; event < events; event++) {
+            const double momentum = 0.2 + 0.8 * uniform(generator);     // GeV/c
+            const double theta = 45 + 90 * uniform(generator);          // degrees
+            const double phi = -180 + 360 * uniform(generator);         // degrees
+            const double vertex_z = -0.25 + 0.5 * uniform(generator);   // m
+            text += fmt::format("Event {}\n{:g}\t{:g}\t{:g}\t{:g}\n", 200000 + event, momentum, theta, phi, vertex_z);
+
+            const size_t hit_count = hits_per_track(generator);
+            for (size_t i = 0; i < hit_count; i++) {
+                const int ring = static_cast<int>(i * num_rings / hit_count);
+                const int pad = static_cast<int>(uniform(generator) * num_pads_per_ring);
+                const int plane = static_cast<int>(uniform(generator) * 10);
+                const double z_to_gem = 0.1 * uniform(generator);          // m
+                const double time = z_to_gem * 1000 / 0.032;                // ns
+                if (cfg.layout == HitLayout::WithTruth) {
+                    const double radius = 0.05 + 0.1 * (ring + 0.5) / num_rings;   // m
+                    const double hit_phi = 2 * M_PI * uniform(generator);
+                    text += fmt::format("\t{:g}\t{:g}\t{:g}\t{:g}\t{:g}\t{}\t{}\t{}\t{:g}\t\n",
+                                        time, adc(generator), radius * std::cos(hit_phi), radius * std::sin(hit_phi),
+                                        vertex_z + 0.1 * uniform(generator), ring, pad, plane, z_to_gem);
+                } else {
+                    text += fmt::format("\t{:g}\t{:g}\t{}\t{}\t{}\t{:g}\t\n", time, adc(generator), ring, pad, plane, z_to_gem);
+                }
+            }
+
+            if (text.size() > (1 << 20)) {
+                output.write(text.data(), static_cast<std::streamsize>(text.size()));
+                text.clear();
+            }
+        }
+        output.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    /** Corpus loaded to memory with lines split the way different parsers need them */
+    struct Corpus {
+        std::string name;
+        std::string path;
+        std::string text;
+        std::vector<std::string> lines;             // All lines except "Event" lines
+        std::vector<std::string_view> hit_lines;    // Lines after track header lines
+        size_t hit_lines_bytes = 0;
+        size_t events = 0;
+        HitLayout layout = HitLayout::NoTruth;
+    };
+
+    Corpus LoadCorpus(const std::string& name, const std::string& path) {
+        Corpus corpus;
+        corpus.name = name;
+        corpus.path = path;
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error(fmt::format("Could not open '{}'", path));
+        }
+        std::ostringstream buffer;
+        buffer << input.rdbuf();
+        corpus.text = buffer.str();
+
+        std::string_view text = corpus.text;
+        bool is_header = false;
+        bool is_layout_known = false;
+        while (!text.empty()) {
+            auto line = NextLine(text);
+            if (IsEventHeaderLine(line)) {
+                corpus.events++;
+                is_header = true;
+                continue;
+            }
+            corpus.lines.emplace_back(line);
+            if (is_header) {
+                is_header = false;
+                continue;
+            }
+            if (!is_layout_known && !IsBlankLine(line)) {
+                LineTokens tokens;
+                corpus.layout = TokenizeDataLine(line, tokens) >= kHitColumnsWithTruth ? HitLayout::WithTruth : HitLayout::NoTruth;
+                is_layout_known = true;
+            }
+            corpus.hit_lines.push_back(line);
+            corpus.hit_lines_bytes += line.size() + 1;
+        }
+        return corpus;
+    }
+
+    /// Keeps the compiler from throwing away results of measured code
+    volatile size_t g_sink = 0;
+
+    /// Best time of repeated runs (seconds)
+    double MeasureBest(size_t repeat, const std::function<void()>& run) {
+        double best = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < repeat; i++) {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    void PrintResult(std::string_view stage, size_t bytes, size_t events, double seconds) {
+        fmt::print("  {:<22} {:>10.1f} MB/s {:>14.0f} events/s\n", stage, bytes / seconds / 1e6, events / seconds);
+    }
+
+    /// Emits all events of the file by DigitizedDataEventSource. Returns number of emitted events
+    size_t RunEmit(const std::string& path, bool use_mmap) {
+        JApplication app;
+        app.SetParameterValue<std::string>("tdis:LogLevel", "warn");
+        app.SetParameterValue("io:use_mmap", use_mmap);
+        app.SetParameterValue("io:parallel_parse", false);
+        app.SetParameterValue<uint64_t>("io:prefetch_events", 0);
+        app.SetParameterValue("io:write_index", false);
+        app.ProvideService(std::make_shared<tdis::services::LogService>(&app));
+        app.ProvideService(std::make_shared<tdis::services::InputFilesService>(&app, std::vector<std::string>{path}));
+
+        DigitizedDataEventSource source(path, &app);
+        source.Init();
+        source.Open();
+        size_t events = 0;
+        JEvent event;
+        while (source.Emit(event) == JEventSource::Result::Success) {
+            event.Clear();
+            events++;
+        }
+        source.Close();
+        return events;
+    }
+
+    void BenchmarkCorpus(const Corpus& corpus, size_t repeat) {
+        const size_t hits = corpus.hit_lines.size();
+        fmt::print("\n{}: {} events, {:.1f} hits/event, {} columns, {:.1f} MB\n", corpus.name, corpus.events,
+                   corpus.events ? static_cast<double>(hits) / static_cast<double>(corpus.events) : 0.,
+                   corpus.layout == HitLayout::WithTruth ? kHitColumnsWithTruth : kHitColumnsNoTruth, corpus.text.size() / 1e6);
+
+        double seconds = MeasureBest(repeat, [&] {
+            size_t tokens = 0;
+            for (const auto& line: corpus.lines) {
+                tokens += SplitDataString(line).size();
+            }
+            g_sink = tokens;
+        });
+        PrintResult("SplitDataString", corpus.text.size(), corpus.events, seconds);
+
+        seconds = MeasureBest(repeat, [&] {
+            size_t parsed = 0;
+            LineTokens tokens;
+            DigitizedReadoutHit hit{};
+            for (auto line: corpus.hit_lines) {
+                parsed += ParseTrackHitTokens(tokens, TokenizeDataLine(line, tokens), hit);
+            }
+            g_sink = parsed;
+        });
+        PrintResult("ParseTrackHitTokens", corpus.hit_lines_bytes, corpus.events, seconds);
+
+        seconds = MeasureBest(repeat, [&] {
+            auto parse_lines = [&]<HitLayout Layout>() {
+                size_t parsed = 0;
+                LayoutHit<Layout> hit{};
+                for (auto line: corpus.hit_lines) {
+                    parsed += ParseHitLine(line, hit);
+                }
+                return parsed;
+            };
+            g_sink = corpus.layout == HitLayout::WithTruth ? parse_lines.operator()<HitLayout::WithTruth>()
+                                                           : parse_lines.operator()<HitLayout::NoTruth>();
+        });
+        PrintResult("ParseHitLine", corpus.hit_lines_bytes, corpus.events, seconds);
+
+        seconds = MeasureBest(repeat, [&] {
+            std::ifstream input(corpus.path);
+            size_t events = 0;
+            while (!ReadNextEventLines(input).empty()) {
+                events++;
+            }
+            g_sink = events;
+        });
+        PrintResult("ReadNextEventLines", corpus.text.size(), corpus.events, seconds);
+
+        for (bool use_mmap: {true, false}) {
+            size_t events = 0;
+            seconds = MeasureBest(repeat, [&] { events = RunEmit(corpus.path, use_mmap); });
+            PrintResult(use_mmap ? "Emit mmap" : "Emit getline", corpus.text.size(), events, seconds);
+        }
+    }
+}   // namespace
+
+
+int main(int argc, char* argv[]) {
+    CLI::App app{"tdis digitized text input benchmark"};
+
+    size_t events = 20000;
+    size_t repeat = 3;
+    std::string directory = (std::filesystem::temp_directory_path() / "tdis_input_benchmark").string();
+    bool keep = false;
+    std::vector<std::string> files;
+    app.add_option("--events", events, "Number of events in each generated corpus");
+    app.add_option("--repeat", repeat, "Number of runs of each measurement, the best one is reported");
+    app.add_option("--dir", directory, "Directory for generated corpora");
+    app.add_flag("--keep", keep, "Keep generated corpora");
+    app.add_option("files", files, "Digitized .txt files to measure in addition to generated corpora");
+    CLI11_PARSE(app, argc, argv);
+
+    const std::vector<CorpusConfig> configs = {
+        {"6 columns, short tracks", HitLayout::NoTruth, 10, 30},
+        {"6 columns, long tracks", HitLayout::NoTruth, 60, 140},
+        {"9 columns, short tracks", HitLayout::WithTruth, 10, 30},
+        {"9 columns, long tracks", HitLayout::WithTruth, 60, 140},
+    };
+
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> generated;
+    uint64_t seed = 1;
+    for (const auto& config: configs) {
+        auto path = fmt::format("{}/corpus_{}.txt", directory, generated.size());
+        fmt::print("Generating '{}': {}\n", path, config.name);
+        GenerateCorpus(config, path, events, seed++);
+        generated.push_back(path);
+    }
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        BenchmarkCorpus(LoadCorpus(configs[i].name, generated[i]), repeat);
+    }
+    for (const auto& file: files) {
+        BenchmarkCorpus(LoadCorpus(file, file), repeat);
+    }
+
+    if (!keep) {
+        for (const auto& path: generated) {
+            std::filesystem::remove(path);
+        }
+    }
+    return 0;
+}
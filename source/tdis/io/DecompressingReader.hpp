@@ -0,0 +1,422 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Reads a compressed file (.gz, .zst, .lz4) on a dedicated thread.
+ *
+ *  The thread decompresses the (memory mapped) input into blocks of fixed size and puts them to a bounded
+ *  ring buffer. The consumer takes blocks with NextBlock. When the ring is full the decompression thread waits,
+ *  so memory use is limited by ring_blocks * block_size however slow reconstruction is.
+ *  Block memory is recycled: NextBlock swaps the caller string with the ring slot.
+ *
+ *  gzip is always available (zlib). zstd and lz4 are compiled in if the build finds the libraries
+ *  and defines TDIS_WITH_ZSTD / TDIS_WITH_LZ4
+ *
+ *  OpenStream reads not compressed data from a pipe or socket the same way: each read() result is a block.
+ *  When the ring is full the thread stops reading, the kernel buffer fills up and the writer blocks (back-pressure).
+ *  The end of data is the writer closing its end
+ **/
+
+#pragma once
+
+#include <poll.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef TDIS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef TDIS_WITH_LZ4
+#include <lz4frame.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "io/MappedFile.hpp"
+
+namespace tdis::io {
+
+    enum class Compression { None, Gzip, Zstd, Lz4 };
+
+    /// Compression by file extension
+    inline Compression DetectCompression(std::string_view path) {
+        if (path.ends_with(".gz")) return Compression::Gzip;
+        if (path.ends_with(".zst")) return Compression::Zstd;
+        if (path.ends_with(".lz4")) return Compression::Lz4;
+        return Compression::None;
+    }
+
+    /// File name without compression extension: "data.txt.gz" => "data.txt"
+    inline std::string_view StripCompressionExtension(std::string_view path) {
+        switch (DetectCompression(path)) {
+            case Compression::Gzip: return path.substr(0, path.size() - 3);
+            case Compression::Zstd:
+            case Compression::Lz4: return path.substr(0, path.size() - 4);
+            default: return path;
+        }
+    }
+
+    /// If this build can decompress this kind of files
+    inline bool IsCompressionSupported(Compression compression) {
+        switch (compression) {
+            case Compression::None:
+            case Compression::Gzip: return true;
+#ifdef TDIS_WITH_ZSTD
+            case Compression::Zstd: return true;
+#endif
+#ifdef TDIS_WITH_LZ4
+            case Compression::Lz4: return true;
+#endif
+            default: return false;
+        }
+    }
+
+    class DecompressingReader {
+    public:
+        explicit DecompressingReader(size_t block_size = 4 * 1024 * 1024, size_t ring_blocks = 8);
+
+        ~DecompressingReader() { Close(); }
+
+        DecompressingReader(const DecompressingReader&) = delete;
+        DecompressingReader& operator=(const DecompressingReader&) = delete;
+
+        /// Opens the file and starts decompression thread. Throws std::runtime_error if it can't be read
+        void Open(const std::string& path);
+
+        /// Starts reading thread for a pipe or socket. Takes ownership of fd. name is used in messages
+        void OpenStream(int fd, const std::string& name);
+
+        /// Stops decompression thread and releases the file. Safe to call multiple times
+        void Close();
+
+        /// Waits for the next decompressed block and swaps it into block.
+        /// Returns false at the end of the data. Rethrows decompression errors
+        bool NextBlock(std::string& block);
+
+    private:
+        /// Decompression thread body
+        void Run();
+
+        /// Copies data from m_stream_fd to blocks until the writer closes it
+        void ReadStream();
+
+        /// Close is called from the consumer thread
+        bool IsStopRequested();
+
+        void DecompressGzip(std::string_view input);
+#ifdef TDIS_WITH_ZSTD
+        void DecompressZstd(std::string_view input);
+#endif
+#ifdef TDIS_WITH_LZ4
+        void DecompressLz4(std::string_view input);
+#endif
+
+        /// Puts filled m_out_block into the ring, waits if the ring is full. Returns false if Close is requested
+        bool PushBlock();
+
+        std::string m_path;
+        Compression m_compression = Compression::None;
+        MappedFile m_input;
+        int m_stream_fd = -1;
+        size_t m_block_size;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_cv_not_empty;
+        std::condition_variable m_cv_not_full;
+        std::vector<std::string> m_ring;
+        size_t m_ring_head = 0;             // Next block for consumer
+        size_t m_ring_count = 0;            // Number of filled blocks
+        bool m_producer_done = false;
+        bool m_stop = false;
+        std::exception_ptr m_error;
+
+        std::string m_out_block;            // Block being filled by decompression thread
+    };
+
+
+    inline DecompressingReader::DecompressingReader(size_t block_size, size_t ring_blocks):
+        m_block_size(block_size ? block_size : 1),
+        m_ring(ring_blocks ? ring_blocks : 1) {
+    }
+
+    inline void DecompressingReader::Open(const std::string& path) {
+        Close();
+
+        m_path = path;
+        m_compression = DetectCompression(path);
+        if (!IsCompressionSupported(m_compression)) {
+            throw std::runtime_error(fmt::format("'{}' compression is not supported by this build of tdis", path));
+        }
+
+        m_input.Open(path);
+        m_ring_head = m_ring_count = 0;
+        m_producer_done = m_stop = false;
+        m_error = nullptr;
+        m_thread = std::thread(&DecompressingReader::Run, this);
+    }
+
+    inline void DecompressingReader::OpenStream(int fd, const std::string& name) {
+        Close();
+
+        m_path = name;
+        m_compression = Compression::None;
+        m_stream_fd = fd;
+        m_ring_head = m_ring_count = 0;
+        m_producer_done = m_stop = false;
+        m_error = nullptr;
+        m_thread = std::thread(&DecompressingReader::Run, this);
+    }
+
+    inline void DecompressingReader::Close() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv_not_full.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        m_input.Close();
+        if (m_stream_fd >= 0) {
+            ::close(m_stream_fd);
+            m_stream_fd = -1;
+        }
+    }
+
+    inline bool DecompressingReader::IsStopRequested() {
+        std::lock_guard lock(m_mutex);
+        return m_stop;
+    }
+
+    inline bool DecompressingReader::NextBlock(std::string& block) {
+        std::unique_lock lock(m_mutex);
+        m_cv_not_empty.wait(lock, [this] { return m_ring_count > 0 || m_producer_done; });
+
+        if (m_ring_count == 0) {
+            if (m_error) {
+                std::rethrow_exception(m_error);
+            }
+            return false;
+        }
+
+        block.swap(m_ring[m_ring_head]);
+        m_ring_head = (m_ring_head + 1) % m_ring.size();
+        m_ring_count--;
+        lock.unlock();
+        m_cv_not_full.notify_one();
+        return true;
+    }
+
+    inline bool DecompressingReader::PushBlock() {
+        std::unique_lock lock(m_mutex);
+        m_cv_not_full.wait(lock, [this] { return m_ring_count < m_ring.size() || m_stop; });
+        if (m_stop) {
+            return false;
+        }
+
+        // The slot gets the filled block, we continue with the memory of the block the consumer returned earlier
+        m_ring[(m_ring_head + m_ring_count) % m_ring.size()].swap(m_out_block);
+        m_ring_count++;
+        lock.unlock();
+        m_cv_not_empty.notify_one();
+        return true;
+    }
+
+    inline void DecompressingReader::Run() {
+        try {
+            if (m_stream_fd >= 0) {
+                ReadStream();
+            } else {
+                switch (m_compression) {
+                    case Compression::Gzip: DecompressGzip(m_input.View()); break;
+#ifdef TDIS_WITH_ZSTD
+                    case Compression::Zstd: DecompressZstd(m_input.View()); break;
+#endif
+#ifdef TDIS_WITH_LZ4
+                    case Compression::Lz4: DecompressLz4(m_input.View()); break;
+#endif
+                    default: throw std::runtime_error(fmt::format("Unsupported compression of '{}'", m_path));
+                }
+            }
+        } catch (...) {
+            std::lock_guard lock(m_mutex);
+            m_error = std::current_exception();
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_producer_done = true;
+        }
+        m_cv_not_empty.notify_all();
+    }
+
+    inline void DecompressingReader::ReadStream() {
+        pollfd poll_fd{m_stream_fd, POLLIN, 0};
+        while (true) {
+            // Wake up from time to time to see if Close is called while the writer is silent
+            int ready = ::poll(&poll_fd, 1, 200);
+            if (IsStopRequested()) return;
+            if (ready == 0 || (ready < 0 && errno == EINTR)) continue;
+            if (ready < 0) {
+                throw std::runtime_error(fmt::format("Error waiting for data from '{}': {}", m_path, std::strerror(errno)));
+            }
+
+            m_out_block.resize(m_block_size);
+            ssize_t count = ::read(m_stream_fd, m_out_block.data(), m_block_size);
+            if (count < 0) {
+                if (errno == EINTR || errno == EAGAIN) continue;
+                throw std::runtime_error(fmt::format("Error reading from '{}': {}", m_path, std::strerror(errno)));
+            }
+            if (count == 0) {
+                return;     // The writer closed the stream
+            }
+
+            m_out_block.resize(static_cast<size_t>(count));
+            if (!PushBlock()) return;
+        }
+    }
+
+    inline void DecompressingReader::DecompressGzip(std::string_view input) {
+        z_stream stream{};
+        // 15 - max window, +32 - detect gzip or zlib header automatically
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw std::runtime_error(fmt::format("Could not initialize zlib for '{}'", m_path));
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = 0;
+        size_t input_left = input.size();
+        int status = Z_OK;
+
+        try {
+            while (true) {
+                m_out_block.resize(m_block_size);
+                stream.next_out = reinterpret_cast<Bytef*>(m_out_block.data());
+                stream.avail_out = static_cast<uInt>(m_block_size);
+
+                while (stream.avail_out > 0) {
+                    // avail_in is 32 bit, feed big mapped files by pieces
+                    if (stream.avail_in == 0 && input_left > 0) {
+                        stream.avail_in = static_cast<uInt>(std::min<size_t>(input_left, 1u << 30));
+                        input_left -= stream.avail_in;
+                    }
+
+                    status = inflate(&stream, Z_NO_FLUSH);
+                    if (status == Z_STREAM_END) {
+                        // Files made with 'cat a.gz b.gz' have several gzip members
+                        if (stream.avail_in == 0 && input_left == 0) break;
+                        inflateReset(&stream);
+                    } else if (status == Z_BUF_ERROR && stream.avail_in == 0 && input_left == 0) {
+                        throw std::runtime_error(fmt::format("Unexpected end of compressed file '{}'", m_path));
+                    } else if (status != Z_OK) {
+                        throw std::runtime_error(fmt::format("Decompression error in '{}': {}", m_path, stream.msg ? stream.msg : "unknown"));
+                    }
+                }
+
+                m_out_block.resize(m_block_size - stream.avail_out);
+                if (!m_out_block.empty() && !PushBlock()) break;
+                if (status == Z_STREAM_END && stream.avail_in == 0 && input_left == 0) break;
+            }
+        } catch (...) {
+            inflateEnd(&stream);
+            throw;
+        }
+        inflateEnd(&stream);
+    }
+
+#ifdef TDIS_WITH_ZSTD
+    inline void DecompressingReader::DecompressZstd(std::string_view input) {
+        std::unique_ptr<ZSTD_DStream, decltype(&ZSTD_freeDStream)> stream(ZSTD_createDStream(), &ZSTD_freeDStream);
+        if (!stream) {
+            throw std::runtime_error(fmt::format("Could not initialize zstd for '{}'", m_path));
+        }
+
+        ZSTD_inBuffer in{input.data(), input.size(), 0};
+        size_t frame_left = 0;
+        bool is_flushed = input.empty();
+        while (!is_flushed) {
+            m_out_block.resize(m_block_size);
+            ZSTD_outBuffer out{m_out_block.data(), m_block_size, 0};
+            while (out.pos < out.size) {
+                const size_t in_before = in.pos;
+                const size_t out_before = out.pos;
+                frame_left = ZSTD_decompressStream(stream.get(), &out, &in);
+                if (ZSTD_isError(frame_left)) {
+                    throw std::runtime_error(fmt::format("Decompression error in '{}': {}", m_path, ZSTD_getErrorName(frame_left)));
+                }
+
+                // With all input consumed the decoder can still hold data that didn't fit the block.
+                // It is done when the frame is complete or a call gives nothing
+                if (in.pos == in.size && (frame_left == 0 || (in.pos == in_before && out.pos == out_before))) {
+                    is_flushed = true;
+                    break;
+                }
+            }
+            m_out_block.resize(out.pos);
+            if (!m_out_block.empty() && !PushBlock()) return;
+        }
+
+        if (frame_left != 0) {
+            throw std::runtime_error(fmt::format("Unexpected end of compressed file '{}'", m_path));
+        }
+    }
+#endif
+
+#ifdef TDIS_WITH_LZ4
+    inline void DecompressingReader::DecompressLz4(std::string_view input) {
+        LZ4F_dctx* context = nullptr;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION))) {
+            throw std::runtime_error(fmt::format("Could not initialize lz4 for '{}'", m_path));
+        }
+        std::unique_ptr<LZ4F_dctx, decltype(&LZ4F_freeDecompressionContext)> context_owner(context, &LZ4F_freeDecompressionContext);
+
+        const char* in = input.data();
+        size_t in_left = input.size();
+        size_t hint = 0;
+        bool is_flushed = input.empty();
+        while (!is_flushed) {
+            m_out_block.resize(m_block_size);
+            size_t out_filled = 0;
+            while (out_filled < m_block_size) {
+                size_t out_size = m_block_size - out_filled;
+                size_t in_size = in_left;
+                hint = LZ4F_decompress(context, m_out_block.data() + out_filled, &out_size, in, &in_size, nullptr);
+                if (LZ4F_isError(hint)) {
+                    throw std::runtime_error(fmt::format("Decompression error in '{}': {}", m_path, LZ4F_getErrorName(hint)));
+                }
+                in += in_size;
+                in_left -= in_size;
+                out_filled += out_size;
+
+                // Same as zstd: after the last input the context may still hold decoded data
+                if (in_left == 0 && (hint == 0 || (in_size == 0 && out_size == 0))) {
+                    is_flushed = true;
+                    break;
+                }
+            }
+            m_out_block.resize(out_filled);
+            if (!m_out_block.empty() && !PushBlock()) return;
+        }
+
+        if (hint != 0) {
+            throw std::runtime_error(fmt::format("Unexpected end of compressed file '{}'", m_path));
+        }
+    }
+#endif
+
+}   // namespace tdis::io
@@ -0,0 +1,458 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Compact binary columnar (structure of arrays) cache of DigitizedReadoutTrack/DigitizedReadoutHit
+ *
+ *  The first pass over a digitized .txt file may write "<file>.tdisbin" next to it (io:write_cache).
+ *  Later runs open the cache with DigitizedBinaryEventSource and don't tokenize ASCII at all.
+ *  The reader memory maps the cache and reads columns in place (no copies, no parsing).
+ *
+ *  Layout (all values are native endian, every column starts at 8 bytes aligned offset):
+ *
+ *      FileHeader
+ *      Chunk 0, Chunk 1, ...           - events are written in chunks of io:cache_chunk_events
+ *      ChunkEntry[number of chunks]    - per chunk offset table
+ *      FileFooter
+ *
+ *  Each chunk holds n_events tracks and n_hits hits as columns:
+ *      ChunkHeader
+ *      uint64_t file_event_number[n_events]   - number after "Event" word in the text file
+ *      uint32_t hit_begin[n_events + 1]       - per event offset table: hits of event i are [hit_begin[i], hit_begin[i+1])
+ *      double   momentum, theta, phi, vertexZ [n_events] each
+ *      double   time, adc [n_hits] each
+ *      int32_t  ring, pad, plane [n_hits] each
+ *      double   zToGem [n_hits]
+ *      double   true_x, true_y, true_z [n_hits] each   - only if chunk has truth (kChunkHasTruth)
+ *
+ *  Values are stored in the text file units. Conversion to Acts units happens when filling PODIO
+ **/
+
+#pragma once
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "io/DigitizedTextParser.hpp"
+#include "io/MappedFile.hpp"
+
+namespace tdis::io {
+
+    namespace binary_cache {
+        constexpr std::array<char, 8> kFileMagic = {'T', 'D', 'I', 'S', 'B', 'I', 'N', '1'};
+        constexpr std::array<char, 8> kFooterMagic = {'T', 'D', 'I', 'S', 'E', 'N', 'D', '1'};
+        constexpr uint32_t kVersion = 1;
+        constexpr uint32_t kChunkHasTruth = 1;
+
+        struct FileHeader {
+            std::array<char, 8> magic;
+            uint32_t version;
+            uint32_t reserved;
+            FileStamp source_stamp;     // Stamp of the text file the cache was made from
+        };
+
+        struct ChunkHeader {
+            uint32_t n_events;
+            uint32_t n_hits;
+            uint32_t flags;
+            uint32_t reserved;
+        };
+
+        struct ChunkEntry {
+            uint64_t offset;            // Offset of ChunkHeader in the file
+            uint64_t first_event;       // Global index of the first event in the chunk
+        };
+
+        struct FileFooter {
+            uint64_t n_chunks;
+            uint64_t n_events;
+            uint64_t chunk_table_offset;
+            std::array<char, 8> magic;
+        };
+
+        constexpr size_t AlignUp(const size_t value) { return (value + 7) & ~size_t(7); }
+    }
+
+
+    /** Cache file name for the text file */
+    inline std::string GetBinaryCachePath(const std::string& text_file_path) {
+        return text_file_path + ".tdisbin";
+    }
+
+    /** Writes the binary cache. Events are accumulated in columns and flushed in chunks
+     *  The file is written under a temporary name and renamed in Finish(), so an interrupted
+     *  job never leaves a truncated cache behind */
+    class BinaryCacheWriter {
+    public:
+        explicit BinaryCacheWriter(const std::string& text_file_path, size_t chunk_events = 10000);
+
+        ~BinaryCacheWriter();
+
+        /// Starts a new event (track)
+        void BeginEvent(uint64_t file_event_number, const DigitizedReadoutTrack& track);
+
+        /// Adds a hit to the current event. Truth columns are filled and written only for hits with truth
+        template <HitLayout Layout>
+        void AddHit(const LayoutHit<Layout>& hit);
+
+        /// Flushes everything and moves the file to its final name
+        void Finish();
+
+        /// Removes the unfinished file
+        void Abort();
+
+        uint64_t EventCount() const { return m_total_events; }
+
+    private:
+        template <typename T>
+        void WriteColumn(const std::vector<T>& column);
+
+        void WriteChunk();
+
+        std::string m_path;
+        std::string m_tmp_path;
+        std::ofstream m_output;
+        size_t m_chunk_events;
+        uint64_t m_total_events = 0;
+        std::vector<binary_cache::ChunkEntry> m_chunks;
+
+        // Current chunk columns
+        std::vector<uint64_t> m_file_event_number;
+        std::vector<uint32_t> m_hit_begin;
+        std::vector<double> m_momentum, m_theta, m_phi, m_vertex_z;
+        std::vector<double> m_time, m_adc, m_z_to_gem, m_true_x, m_true_y, m_true_z;
+        std::vector<int32_t> m_ring, m_pad, m_plane;
+        bool m_has_truth = false;
+    };
+
+
+    /** Reads the binary cache. Columns point directly to memory mapped file */
+    class BinaryCacheReader {
+    public:
+        /// One chunk columns
+        struct Chunk {
+            uint32_t n_events = 0;
+            uint32_t n_hits = 0;
+            bool has_truth = false;
+            const uint64_t* file_event_number = nullptr;
+            const uint32_t* hit_begin = nullptr;
+            const double *momentum = nullptr, *theta = nullptr, *phi = nullptr, *vertex_z = nullptr;
+            const double *time = nullptr, *adc = nullptr, *z_to_gem = nullptr;
+            const int32_t *ring = nullptr, *pad = nullptr, *plane = nullptr;
+            const double *true_x = nullptr, *true_y = nullptr, *true_z = nullptr;
+        };
+
+        /// Opens and validates the cache file. Throws std::runtime_error if the file is not a valid cache
+        void Open(const std::string& cache_path);
+
+        void Close();
+
+        uint64_t EventCount() const { return m_footer.n_events; }
+
+        size_t ChunkCount() const { return m_chunk_table.size(); }
+
+        /// Global index of the first event in chunk
+        uint64_t ChunkFirstEvent(size_t chunk_index) const { return m_chunk_table[chunk_index].first_event; }
+
+        /// Maps columns of chunk_index. Throws std::runtime_error if the columns are out of the chunk data
+        Chunk GetChunk(size_t chunk_index) const;
+
+        /// Finds chunk containing event with global index
+        size_t FindChunk(uint64_t event_index) const;
+
+    private:
+        MappedFile m_file;
+        binary_cache::FileFooter m_footer{};
+        std::vector<binary_cache::ChunkEntry> m_chunk_table;
+    };
+
+
+    // ---------- BinaryCacheWriter ----------
+
+    inline BinaryCacheWriter::BinaryCacheWriter(const std::string& text_file_path, size_t chunk_events):
+        m_path(GetBinaryCachePath(text_file_path)),
+        m_tmp_path(m_path + ".tmp." + std::to_string(::getpid())),
+        m_chunk_events(chunk_events ? chunk_events : 1)
+    {
+        binary_cache::FileHeader header{};
+        header.magic = binary_cache::kFileMagic;
+        header.version = binary_cache::kVersion;
+        if (!FileStamp::Read(text_file_path, header.source_stamp)) {
+            throw std::runtime_error(fmt::format("Can't stat '{}' to write binary cache", text_file_path));
+        }
+
+        m_output.open(m_tmp_path, std::ios::binary | std::ios::trunc);
+        if (!m_output) {
+            throw std::runtime_error(fmt::format("Can't open binary cache file '{}' for writing", m_tmp_path));
+        }
+        m_output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_hit_begin.push_back(0);
+    }
+
+    inline BinaryCacheWriter::~BinaryCacheWriter() {
+        if (m_output.is_open()) {
+            Abort();
+        }
+    }
+
+    inline void BinaryCacheWriter::BeginEvent(uint64_t file_event_number, const DigitizedReadoutTrack& track) {
+        if (m_file_event_number.size() >= m_chunk_events) {
+            WriteChunk();
+        }
+        m_file_event_number.push_back(file_event_number);
+        m_momentum.push_back(track.momentum);
+        m_theta.push_back(track.theta);
+        m_phi.push_back(track.phi);
+        m_vertex_z.push_back(track.vertexZ);
+        m_hit_begin.push_back(m_hit_begin.back());
+    }
+
+    template <HitLayout Layout>
+    inline void BinaryCacheWriter::AddHit(const LayoutHit<Layout>& hit) {
+        m_time.push_back(hit.time);
+        m_adc.push_back(hit.adc);
+        m_ring.push_back(hit.ring);
+        m_pad.push_back(hit.pad);
+        m_plane.push_back(hit.plane);
+        m_z_to_gem.push_back(hit.zToGem);
+        if constexpr (Layout == HitLayout::WithTruth) {
+            m_true_x.push_back(hit.true_x);
+            m_true_y.push_back(hit.true_y);
+            m_true_z.push_back(hit.true_z);
+            m_has_truth = true;
+        }
+        m_hit_begin.back()++;
+    }
+
+    template <typename T>
+    inline void BinaryCacheWriter::WriteColumn(const std::vector<T>& column) {
+        static constexpr std::array<char, 8> zeros{};
+        auto pos = static_cast<size_t>(m_output.tellp());
+        m_output.write(zeros.data(), static_cast<std::streamsize>(binary_cache::AlignUp(pos) - pos));
+        m_output.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(T)));
+    }
+
+    inline void BinaryCacheWriter::WriteChunk() {
+        if (m_file_event_number.empty()) {
+            return;
+        }
+
+        binary_cache::ChunkHeader header{};
+        header.n_events = static_cast<uint32_t>(m_file_event_number.size());
+        header.n_hits = m_hit_begin.back();
+        header.flags = m_has_truth ? binary_cache::kChunkHasTruth : 0;
+
+        // Chunk header is aligned as every column
+        static constexpr std::array<char, 8> zeros{};
+        auto pos = static_cast<size_t>(m_output.tellp());
+        m_output.write(zeros.data(), static_cast<std::streamsize>(binary_cache::AlignUp(pos) - pos));
+        m_chunks.push_back({static_cast<uint64_t>(m_output.tellp()), m_total_events});
+        m_output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        WriteColumn(m_file_event_number);
+        WriteColumn(m_hit_begin);
+        WriteColumn(m_momentum);
+        WriteColumn(m_theta);
+        WriteColumn(m_phi);
+        WriteColumn(m_vertex_z);
+        WriteColumn(m_time);
+        WriteColumn(m_adc);
+        WriteColumn(m_ring);
+        WriteColumn(m_pad);
+        WriteColumn(m_plane);
+        WriteColumn(m_z_to_gem);
+        if (m_has_truth) {
+            WriteColumn(m_true_x);
+            WriteColumn(m_true_y);
+            WriteColumn(m_true_z);
+        }
+
+        m_total_events += header.n_events;
+
+        // Keep vectors capacity for the next chunk
+        for (auto* column: {&m_momentum, &m_theta, &m_phi, &m_vertex_z, &m_time, &m_adc, &m_z_to_gem, &m_true_x, &m_true_y, &m_true_z}) {
+            column->clear();
+        }
+        for (auto* column: {&m_ring, &m_pad, &m_plane}) {
+            column->clear();
+        }
+        m_file_event_number.clear();
+        m_hit_begin.clear();
+        m_hit_begin.push_back(0);
+        m_has_truth = false;
+    }
+
+    inline void BinaryCacheWriter::Finish() {
+        WriteChunk();
+
+        static constexpr std::array<char, 8> zeros{};
+        auto pos = static_cast<size_t>(m_output.tellp());
+        m_output.write(zeros.data(), static_cast<std::streamsize>(binary_cache::AlignUp(pos) - pos));
+
+        binary_cache::FileFooter footer{};
+        footer.n_chunks = m_chunks.size();
+        footer.n_events = m_total_events;
+        footer.chunk_table_offset = static_cast<uint64_t>(m_output.tellp());
+        footer.magic = binary_cache::kFooterMagic;
+        m_output.write(reinterpret_cast<const char*>(m_chunks.data()), static_cast<std::streamsize>(m_chunks.size() * sizeof(binary_cache::ChunkEntry)));
+        m_output.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+        m_output.close();
+
+        if (!m_output || std::rename(m_tmp_path.c_str(), m_path.c_str()) != 0) {
+            std::remove(m_tmp_path.c_str());
+            throw std::runtime_error(fmt::format("Failed to write binary cache file '{}'", m_path));
+        }
+    }
+
+    inline void BinaryCacheWriter::Abort() {
+        m_output.close();
+        std::remove(m_tmp_path.c_str());
+    }
+
+
+    // ---------- BinaryCacheReader ----------
+
+    inline void BinaryCacheReader::Open(const std::string& cache_path) {
+        m_file.Open(cache_path);
+        auto data = m_file.View();
+
+        binary_cache::FileHeader header{};
+        if (data.size() < sizeof(header) + sizeof(m_footer)) {
+            throw std::runtime_error(fmt::format("'{}' is too small to be TDIS binary cache", cache_path));
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        std::memcpy(&m_footer, data.data() + data.size() - sizeof(m_footer), sizeof(m_footer));
+        if (header.magic != binary_cache::kFileMagic || header.version != binary_cache::kVersion) {
+            throw std::runtime_error(fmt::format("'{}' is not TDIS binary cache or has unsupported version", cache_path));
+        }
+        if (m_footer.magic != binary_cache::kFooterMagic) {
+            throw std::runtime_error(fmt::format("'{}' TDIS binary cache is truncated (no footer)", cache_path));
+        }
+
+        // The chunk table is between the last chunk and the footer, chunks are between the header and the table.
+        // Written as subtractions of checked values so that corrupted numbers can't overflow
+        const size_t table_end = data.size() - sizeof(m_footer);
+        if (m_footer.chunk_table_offset < sizeof(header) || m_footer.chunk_table_offset > table_end ||
+            m_footer.n_chunks > (table_end - m_footer.chunk_table_offset) / sizeof(binary_cache::ChunkEntry)) {
+            throw std::runtime_error(fmt::format("'{}' TDIS binary cache is corrupted (chunk table is out of the file)", cache_path));
+        }
+
+        m_chunk_table.resize(m_footer.n_chunks);
+        std::memcpy(m_chunk_table.data(), data.data() + m_footer.chunk_table_offset, m_footer.n_chunks * sizeof(binary_cache::ChunkEntry));
+        for (const auto& entry: m_chunk_table) {
+            if (entry.offset < sizeof(header) || entry.offset >= m_footer.chunk_table_offset ||
+                sizeof(binary_cache::ChunkHeader) > m_footer.chunk_table_offset - entry.offset) {
+                throw std::runtime_error(fmt::format("'{}' TDIS binary cache is corrupted (chunk offset {} is out of chunk data)", cache_path, entry.offset));
+            }
+        }
+    }
+
+    inline void BinaryCacheReader::Close() {
+        m_chunk_table.clear();
+        m_footer = {};
+        m_file.Close();
+    }
+
+    inline BinaryCacheReader::Chunk BinaryCacheReader::GetChunk(size_t chunk_index) const {
+        const char* base = m_file.View().data();
+        size_t pos = m_chunk_table[chunk_index].offset;
+
+        binary_cache::ChunkHeader header{};
+        std::memcpy(&header, base + pos, sizeof(header));
+        pos += sizeof(header);
+
+        // Takes the next aligned column of `count` values. Columns must end before the chunk table
+        const size_t data_end = m_footer.chunk_table_offset;
+        auto column = [&]<typename T>(const T*& ptr, size_t count) {
+            pos = binary_cache::AlignUp(pos);
+            if (pos > data_end || count > (data_end - pos) / sizeof(T)) {
+                throw std::runtime_error(fmt::format("TDIS binary cache chunk {} is corrupted (columns are out of chunk data)", chunk_index));
+            }
+            ptr = reinterpret_cast<const T*>(base + pos);
+            pos += count * sizeof(T);
+        };
+
+        Chunk chunk;
+        chunk.n_events = header.n_events;
+        chunk.n_hits = header.n_hits;
+        chunk.has_truth = header.flags & binary_cache::kChunkHasTruth;
+        column(chunk.file_event_number, chunk.n_events);
+        column(chunk.hit_begin, static_cast<size_t>(chunk.n_events) + 1);
+        column(chunk.momentum, chunk.n_events);
+        column(chunk.theta, chunk.n_events);
+        column(chunk.phi, chunk.n_events);
+        column(chunk.vertex_z, chunk.n_events);
+        column(chunk.time, chunk.n_hits);
+        column(chunk.adc, chunk.n_hits);
+        column(chunk.ring, chunk.n_hits);
+        column(chunk.pad, chunk.n_hits);
+        column(chunk.plane, chunk.n_hits);
+        column(chunk.z_to_gem, chunk.n_hits);
+        if (chunk.has_truth) {
+            column(chunk.true_x, chunk.n_hits);
+            column(chunk.true_y, chunk.n_hits);
+            column(chunk.true_z, chunk.n_hits);
+        }
+
+        // Event hit ranges index the hit columns
+        for (uint32_t event = 0; event < chunk.n_events; event++) {
+            if (chunk.hit_begin[event] > chunk.hit_begin[event + 1] || chunk.hit_begin[event + 1] > chunk.n_hits) {
+                throw std::runtime_error(fmt::format("TDIS binary cache chunk {} is corrupted (hits of event {} are out of the chunk)", chunk_index, event));
+            }
+        }
+        return chunk;
+    }
+
+    inline size_t BinaryCacheReader::FindChunk(uint64_t event_index) const {
+        // Chunk table is sorted by first_event
+        auto next_chunk = std::upper_bound(m_chunk_table.begin(), m_chunk_table.end(), event_index,
+            [](uint64_t index, const binary_cache::ChunkEntry& entry) { return index < entry.first_event; });
+        return next_chunk == m_chunk_table.begin() ? 0 : static_cast<size_t>(next_chunk - m_chunk_table.begin() - 1);
+    }
+
+
+    /** Checks that the cache exists for the text file, is made from the current version of it and is not damaged */
+    inline bool IsBinaryCacheFresh(const std::string& text_file_path) {
+        FileStamp text_stamp;
+        if (!FileStamp::Read(text_file_path, text_stamp)) {
+            return false;
+        }
+
+        std::ifstream input(GetBinaryCachePath(text_file_path), std::ios::binary);
+        binary_cache::FileHeader header{};
+        input.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!input
+            || header.magic != binary_cache::kFileMagic
+            || header.version != binary_cache::kVersion
+            || !(header.source_stamp == text_stamp)) {
+            return false;
+        }
+
+        // Truncated or corrupted cache - the text is parsed instead
+        try {
+            BinaryCacheReader reader;
+            reader.Open(GetBinaryCachePath(text_file_path));
+            for (size_t chunk_index = 0; chunk_index < reader.ChunkCount(); chunk_index++) {
+                reader.GetChunk(chunk_index);
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+}   // namespace tdis::io
@@ -0,0 +1,297 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  EventSource for TDIS binary columnar cache of digitized tracks (see DigitizedBinaryCache.hpp)
+ *
+ *  The resource name may be either the cache file itself "<file>.txt.tdisbin" or the original text file "<file>.txt"
+ *  (or compressed "<file>.txt.gz" with "<file>.txt.gz.tdisbin" cache).
+ *  In the latter case the source is selected by CheckOpenable only if the cache next to the text file
+ *  exists and was made from the current version of the text file. Otherwise DigitizedDataEventSource reads the text.
+ *
+ *  Configuration Parameters (shared with DigitizedDataEventSource)
+ *    - io:skip_events (uint64, default 0):    Number of events to skip (uses chunk offset table)
+ *    - io:max_events (uint64, default 0):     Maximum number of events to process. 0 - all events
+ *    - io:pileup_*:                           Mix several input tracks to one event (see PileupMixer.hpp)
+ *    - io:timeslice_events (uint64, default 0): Emit timeslices of this many physics events (see DigitizedTimesliceUnfolder)
+ **/
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JEvent.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JEventSourceGeneratorT.h>
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include <string>
+
+#include "io/DigitizedBinaryCache.hpp"
+#include "io/DigitizedDataEventSource.hpp"
+#include "io/PileupMixer.hpp"
+#include "podio_model/DigitizedMtpcMcHitCollection.h"
+#include "podio_model/DigitizedMtpcMcTrackCollection.h"
+#include "podio_model/EventInfoCollection.h"
+#include "podio_model/TimesliceInfoCollection.h"
+#include "services/InputFilesService.hpp"
+#include "services/LogService.hpp"
+
+namespace tdis::io {
+
+    /** Binary columnar cache EventSource */
+    class DigitizedBinaryEventSource : public JEventSource {
+
+        BinaryCacheReader m_reader;
+        BinaryCacheReader::Chunk m_chunk;
+        size_t m_chunk_index = 0;
+        uint32_t m_event_in_chunk = 0;
+        uint64_t m_track_index = 0;          // Cache event index of the last read track
+        std::shared_ptr<spdlog::logger> m_log;
+
+        uint64_t m_cfg_skip_events = 0;
+        uint64_t m_cfg_max_events = 0;
+        uint64_t m_emitted_events = 0;
+
+        /// Deterministic event numbers and run number (see InputFilesService)
+        std::shared_ptr<services::InputFilesService> m_input_files;
+        size_t m_file_index = 0;
+        int32_t m_run_number = 0;
+
+        PileupMixer::Config m_cfg_pileup;
+        PileupMixer m_pileup;
+
+        uint64_t m_cfg_timeslice_events = 0;
+        uint64_t m_emitted_timeslices = 0;
+
+    public:
+        DigitizedBinaryEventSource();
+
+        DigitizedBinaryEventSource(std::string resource_name, JApplication* app);
+
+        ~DigitizedBinaryEventSource() override = default;
+
+        void Init() override;
+
+        void Open() override;
+
+        void Close() override;
+
+        Result Emit(JEvent&) override;
+
+        static std::string GetDescription();
+
+    private:
+        /// Cache file path for this resource (resource itself or cache next to .txt file)
+        std::string GetCachePath() const;
+
+        /// Adds tracks of the next physics event (several with pile-up mixing). Returns number of tracks, 0 at the end.
+        /// first_track_index is set to the cache event index of the first track
+        size_t ReadPhysicsEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, uint64_t& first_track_index);
+
+        /// Adds the next track from the cache to PODIO collections. Returns false if there are no more tracks
+        bool ReadNextTrack(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, double time_offset);
+    };
+
+
+    // Implementation section starts here
+
+    inline DigitizedBinaryEventSource::DigitizedBinaryEventSource() : JEventSource() {
+        SetTypeName(NAME_OF_THIS);  // Provide JANA with class name
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+
+    inline DigitizedBinaryEventSource::DigitizedBinaryEventSource(std::string resource_name, JApplication* app): JEventSource(resource_name, app) {
+        SetTypeName(NAME_OF_THIS);  // Provide JANA with class name
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+
+        // JANA builds processing topology by the event level of sources before Init is called
+        app->SetDefaultParameter("io:timeslice_events", m_cfg_timeslice_events,
+            "Emit timeslices of this many physics events (split back by DigitizedTimesliceUnfolder). 0 - emit physics events");
+        SetLevel(m_cfg_timeslice_events ? JEventLevel::Timeslice : JEventLevel::PhysicsEvent);
+    }
+
+    inline void DigitizedBinaryEventSource::Init() {
+        auto app = GetApplication();
+        m_log = app->GetService<tdis::services::LogService>()->logger("DigitizedBinaryEventSource");
+        m_input_files = app->GetService<tdis::services::InputFilesService>();
+
+        app->SetDefaultParameter("io:skip_events", m_cfg_skip_events,
+            "Number of events to skip. Seeks with the event offset index without reading skipped events");
+        app->SetDefaultParameter("io:max_events", m_cfg_max_events,
+            "Maximum number of events to process from each file after skipped ones. 0 - all events");
+        PileupMixer::DefineParameters(app, m_cfg_pileup);
+    }
+
+    inline std::string DigitizedBinaryEventSource::GetCachePath() const {
+        const auto& resource_name = this->GetResourceName();
+        return resource_name.ends_with(".tdisbin") ? resource_name : GetBinaryCachePath(resource_name);
+    }
+
+    inline void DigitizedBinaryEventSource::Open() {
+        auto cache_path = GetCachePath();
+        try {
+            m_reader.Open(cache_path);
+        } catch (const std::exception& ex) {
+            auto message= fmt::format("Error: {}", ex.what());
+            m_log->error(message);
+            throw std::runtime_error(message);
+        }
+
+        m_emitted_events = 0;
+        m_emitted_timeslices = 0;
+        m_file_index = m_input_files->GetFileIndex(this->GetResourceName());
+        m_run_number = m_input_files->GetRunNumber(this->GetResourceName());
+        m_log->info("Opened binary cache '{}' with {} events as input file #{}, run number {}", cache_path, m_reader.EventCount(), m_file_index, m_run_number);
+        m_pileup.Configure(m_cfg_pileup);
+        m_chunk_index = m_reader.FindChunk(m_cfg_skip_events);
+        m_chunk = m_reader.ChunkCount() ? m_reader.GetChunk(m_chunk_index) : BinaryCacheReader::Chunk{};
+        m_event_in_chunk = 0;
+        if (m_cfg_skip_events > 0 && m_reader.ChunkCount()) {
+            m_event_in_chunk = static_cast<uint32_t>(m_cfg_skip_events - m_reader.ChunkFirstEvent(m_chunk_index));
+            m_log->info("Skipping {} events", m_cfg_skip_events);
+        }
+    }
+
+    inline void DigitizedBinaryEventSource::Close() {
+        m_chunk = {};
+        m_reader.Close();
+    }
+
+    inline JEventSource::Result DigitizedBinaryEventSource::Emit(JEvent& event) {
+        // One physics event or a timeslice of io:timeslice_events physics events
+        const uint64_t events_to_read = m_cfg_timeslice_events ? m_cfg_timeslice_events : 1;
+        auto timeslice = std::make_unique<DigitizedTimeslice>();
+        DigitizedMtpcMcTrackCollection podioTracks;
+        DigitizedMtpcMcHitCollection podioHits;
+
+        while (timeslice->events.size() < events_to_read) {
+            if (m_cfg_max_events && m_emitted_events >= m_cfg_max_events) {
+                m_log->info("Reached io:max_events={}", m_cfg_max_events);
+                break;
+            }
+
+            const size_t first_track = podioTracks.size();
+            uint64_t first_track_index = 0;
+            const size_t track_count = ReadPhysicsEvent(podioTracks, podioHits, first_track_index);
+            if (track_count == 0) {
+                break;
+            }
+
+            // Event number depends only on the file and position of the first track in it,
+            // not on the order sources are read or on how many tracks pile-up mixes to an event
+            const uint64_t event_number = m_input_files->GetGlobalEventNumber(m_file_index, first_track_index);
+            timeslice->events.push_back({event_number, static_cast<uint32_t>(first_track), static_cast<uint32_t>(track_count)});
+            m_emitted_events++;
+        }
+
+        if (timeslice->events.empty()) {
+            return Result::FailureFinished;
+        }
+
+        // Timeslice collections have "Ts" prefix to not be confused with physics event ones
+        const std::string prefix = m_cfg_timeslice_events ? "Ts" : "";
+        event.InsertCollection<DigitizedMtpcMcTrack>(std::move(podioTracks), prefix + "DigitizedMtpcMcTrack");
+        event.InsertCollection<DigitizedMtpcMcHit>(std::move(podioHits), prefix + "DigitizedMtpcMcHit");
+
+        if (!m_cfg_timeslice_events) {
+            const uint64_t event_number = timeslice->events.front().event_number;
+            event.SetEventNumber(event_number);
+            event.SetRunNumber(m_run_number);
+
+            EventInfoCollection info;
+            info.push_back(MutableEventInfo(event_number, 0, m_run_number)); // event nr, timeslice nr, run nr
+            event.InsertCollection<EventInfo>(std::move(info), "EventInfo");
+            m_log->debug("Event {} has been emitted from binary cache", event_number);
+            return Result::Success;
+        }
+
+        timeslice->timeslice_number = m_input_files->GetGlobalEventNumber(m_file_index, m_emitted_timeslices++);
+        timeslice->run_number = m_run_number;
+        event.SetEventNumber(timeslice->timeslice_number);
+        event.SetRunNumber(m_run_number);
+        m_log->debug("Timeslice {} with {} events has been emitted from binary cache", timeslice->timeslice_number, timeslice->events.size());
+
+        TimesliceInfoCollection timeslice_info;
+        timeslice_info.push_back(MutableTimesliceInfo(timeslice->timeslice_number, m_run_number));
+        event.InsertCollection<TimesliceInfo>(std::move(timeslice_info), "TimesliceInfo");
+        event.Insert(timeslice.release(), "DigitizedTimeslice");
+        return Result::Success;
+    }
+
+    inline size_t DigitizedBinaryEventSource::ReadPhysicsEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, uint64_t& first_track_index) {
+        // One input track per event or several with io:pileup_* mixing
+        const size_t tracks_in_event = m_pileup.NextMultiplicity();
+        size_t track_count = 0;
+        while (track_count < tracks_in_event && ReadNextTrack(podioTracks, podioHits, m_pileup.NextTimeOffset(track_count))) {
+            if (track_count == 0) {
+                first_track_index = m_track_index;
+            }
+            track_count++;
+        }
+        return track_count;
+    }
+
+    inline bool DigitizedBinaryEventSource::ReadNextTrack(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, double time_offset) {
+        // Go to the next chunk if this one is done
+        while (m_event_in_chunk >= m_chunk.n_events) {
+            if (m_chunk_index + 1 >= m_reader.ChunkCount()) {
+                return false;
+            }
+            m_chunk = m_reader.GetChunk(++m_chunk_index);
+            m_event_in_chunk = 0;
+        }
+
+        const auto& chunk = m_chunk;
+        const uint32_t i = m_event_in_chunk++;
+        m_track_index = m_reader.ChunkFirstEvent(m_chunk_index) + i;
+
+        auto podioTrack = podioTracks.create();
+        podioTrack.phi(chunk.phi[i]);
+        podioTrack.theta(chunk.theta[i]);
+        podioTrack.vertexZ(chunk.vertex_z[i]);
+        podioTrack.momentum(chunk.momentum[i]);
+
+        constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+        for (uint32_t hit_index = chunk.hit_begin[i]; hit_index < chunk.hit_begin[i + 1]; ++hit_index) {
+            DigitizedReadoutHit hit{
+                chunk.time[hit_index],
+                chunk.adc[hit_index],
+                chunk.ring[hit_index],
+                chunk.pad[hit_index],
+                chunk.plane[hit_index],
+                chunk.z_to_gem[hit_index],
+                chunk.has_truth ? chunk.true_x[hit_index] : nan,
+                chunk.has_truth ? chunk.true_y[hit_index] : nan,
+                chunk.has_truth ? chunk.true_z[hit_index] : nan
+            };
+            auto podioHit = podioHits.create();
+            FillPodioHit(hit, podioHit, time_offset);
+            podioTrack.addhits(podioHit);
+        }
+        return true;
+    }
+
+    inline std::string DigitizedBinaryEventSource::GetDescription() {
+        return "Digitized TDIS MTPC binary columnar cache (.tdisbin) event source";
+    }
+} // namespace tdis::io
+
+
+
+// The template specialization needs to be in the global namespace (or at least not inside the tdis namespace)
+template <>
+inline double JEventSourceGeneratorT<tdis::io::DigitizedBinaryEventSource>::CheckOpenable(std::string resource_name) {
+    // The cache file itself
+    if (resource_name.ends_with(".tdisbin")) {
+        return 1.0;
+    }
+
+    // Text file which has up to date cache next to it. DigitizedDataEventSource gives lower confidence in this case
+    // (plain or compressed)
+    bool is_text = tdis::io::StripCompressionExtension(resource_name).ends_with("txt");
+    if (is_text && tdis::io::IsBinaryCacheFresh(resource_name)) {
+        return 1.0;
+    }
+    return 0.0;
+}
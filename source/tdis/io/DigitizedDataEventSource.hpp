@@ -31,6 +31,71 @@
   Event 200001
         ...
 
+ *  Compressed files "<file>.txt.gz", "<file>.txt.zst", "<file>.txt.lz4" are read directly (zstd and lz4 if the build has them).
+ *  They are decompressed on a separate thread (see DecompressingReader.hpp), the source cuts events
+ *  from the decompressed blocks the same way as from a memory mapped file.
+ *
+ *  Live input from the digitizer is read from "fifo://<path>" (named pipe) or "unix://<path>" (Unix domain socket)
+ *  resources (see StreamResource.hpp). A reading thread passes the data in blocks the same way as decompression.
+ *  If reconstruction is slower than the digitizer, the reading thread stops and the digitizer is blocked
+ *  by the full pipe or socket buffer. Processing ends when the digitizer closes the stream.
+ *  An event is taken when the next "Event" line or the end of stream arrives.
+ *
+ *  Configuration Parameters
+ *    - io:use_mmap (bool, default true):
+ *        Memory map the file and tokenize it in place (std::string_view + std::from_chars).
+ *        If false, the file is read line by line with std::getline as before.
+ *
+ *    - io:skip_events (uint64, default 0):
+ *        Number of events to skip from the beginning of the file. Skipping is done by seeking
+ *        with the event offset index (see EventOffsetIndex.hpp), skipped events are not read or parsed.
+ *        (jana:nskip works too, but it reads and parses each skipped event)
+ *        Compressed files can't seek, skipped events are decompressed and only cut, not parsed
+ *
+ *    - io:max_events (uint64, default 0 = all):
+ *        Maximum number of events to emit from this file (after skipped ones)
+ *
+ *    - io:write_index (bool, default true):
+ *        When the index is built by a pre-scan, save it next to the input as "<file>.idx" sidecar,
+ *        so next jobs over the same file seek instantly
+ *
+ *    - io:write_cache (bool, default false):
+ *        While reading the whole file (no io:skip_events/io:max_events) write binary columnar cache
+ *        "<file>.tdisbin" next to it. Next runs over the same file will pick DigitizedBinaryEventSource
+ *        automatically (see DigitizedBinaryCache.hpp). Works with io:use_mmap=true or compressed input
+ *
+ *    - io:cache_chunk_events (uint64, default 10000):
+ *        Number of events in one chunk of the binary cache
+ *
+ *    - io:parallel_parse (bool, default true):
+ *        Emit (which JANA serializes) only cuts the raw text span of the event and inserts it as DigitizedTextEvent.
+ *        DigitizedTextEventFactory parses it to DigitizedMtpcMcTrack/DigitizedMtpcMcHit in parallel worker threads.
+ *        Works with io:use_mmap=true or compressed input. If io:write_cache is on, parsing stays in Emit
+ *
+ *    - io:decompress_block_size (uint64, default 4194304):
+ *        Size in bytes of a decompressed block passed from decompression thread to the source
+ *        (for fifo:// and unix:// input - maximum size of one read)
+ *
+ *    - io:decompress_blocks (uint64, default 8):
+ *        Number of blocks in the ring buffer between decompression thread and the source.
+ *        Decompression thread waits when the ring is full
+ *
+ *    - io:stream_connect_timeout (double, default 30):
+ *        Seconds to wait for the digitizer to start listening on unix:// socket
+ *
+ *    - io:pileup_tracks, io:pileup_poisson, io:pileup_time_window, io:pileup_seed:
+ *        Mix several input tracks to one event (see PileupMixer.hpp)
+ *
+ *    - io:timeslice_events (uint64, default 0):
+ *        Emit timeslices of this many physics events instead of single physics events. This amortizes
+ *        the framework overhead per emitted event. DigitizedTimesliceUnfolder splits timeslices back
+ *        to physics events for reconstruction factories. 0 - emit physics events
+ *
+ *    - io:prefetch_events (uint64, default 16):
+ *        A read-ahead thread reads (and in serial parse mode parses) this many emitted events or timeslices
+ *        ahead of Emit and passes them through a lock-free queue (see ReadAheadQueue.hpp). So reading from disk
+ *        goes in parallel with parsing and Emit only inserts ready collections. 0 - read in Emit.
+ *        Plain text files also get posix_fadvise sequential and will-need hints ahead of the reader position
  **/
 #pragma once
 
@@ -43,39 +108,56 @@
 
 #include <Acts/Definitions/Units.hpp>
 #include <cctype>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <vector>
 
+#include "io/DecompressingReader.hpp"
+#include "io/DigitizedBinaryCache.hpp"
+#include "io/DigitizedTextParser.hpp"
+#include "io/EventOffsetIndex.hpp"
+#include "io/MappedFile.hpp"
+#include "io/PileupMixer.hpp"
+#include "io/ReadAheadQueue.hpp"
+#include "io/StreamResource.hpp"
 #include "podio_model/DigitizedMtpcMcHitCollection.h"
 #include "podio_model/DigitizedMtpcMcTrackCollection.h"
 #include "podio_model/EventInfoCollection.h"
+#include "podio_model/TimesliceInfoCollection.h"
+#include "services/InputFilesService.hpp"
 #include "services/LogService.hpp"
 
 namespace tdis::io {
 
-    /** POD structure for readout hits **/
-    struct DigitizedReadoutHit {
-        double time;     // - Time of arrival at Pad (ns)
-        double adc;      // - Amplitude (ADC bin of sample)
-        int ring;        // - Ring (id of rin, 0 is innermost).
-        int pad;         // - Pad (id of pad, 0 is at or closest to phi=0 and numbering is clockwise).
-        int plane;       // - Plane(id of z plane from 0 upstream  to 9 downstream)
-        double zToGem;   // - ZtoGEM (m)
-        double true_x;   // - True hit x info (quiet_NaN() if not provided)
-        double true_y;   // - True hit y info (quiet_NaN() if not provided)
-        double true_z;   // - True hit z info (quiet_NaN() if not provided)
+    /** Raw text of one input track, inserted by the source for DigitizedTextEventFactory
+     *  The span points into the memory mapped file or decompressed block which is kept alive by buffer_owner */
+    struct DigitizedTextEvent {
+        std::shared_ptr<const void> buffer_owner;
+        TextEventSpan span;
+        double time_offset = 0;     // ns, pile-up time offset added to hit times
+        HitLayout hit_layout = HitLayout::NoTruth;
     };
 
-    /** POD structure for readout track **/
-    struct DigitizedReadoutTrack {
-        double momentum;    // (GeV/c)
-        double theta;       // (degrees)
-        double phi;         // (degrees)
-        double vertexZ;     // (m)
-        std::vector<DigitizedReadoutHit> hits;
+    /** Physics events of a timeslice emitted by digitized sources (io:timeslice_events > 0)
+     *  The timeslice has tracks of all its events in TsDigitizedMtpcMcTrack/TsDigitizedMtpcMcHit collections
+     *  or, with io:parallel_parse, in TsDigitizedTextEvent objects (has_text_events is true).
+     *  Tracks of an event are [first_track, first_track + track_count) of them */
+    struct DigitizedTimeslice {
+        struct Event {
+            uint64_t event_number;
+            uint32_t first_track;
+            uint32_t track_count;
+        };
+
+        uint64_t timeslice_number = 0;
+        int32_t run_number = 0;
+        bool has_text_events = false;
+        std::vector<Event> events;
     };
 
     /** Digitized files in text format EventSource */
@@ -85,12 +167,97 @@ namespace tdis::io {
         size_t m_current_line_index = 0;
         std::shared_ptr<spdlog::logger> m_log;
 
+        /// Memory mapped input and position in it (used if m_cfg_use_mmap is true)
+        /// The mapping is shared with DigitizedTextEvent objects, so it lives until the last event is parsed
+        std::shared_ptr<MappedFile> m_mapped_file;
+        TextEventCursor m_event_cursor;
+
+        /// Compressed input: decompression thread and the text block m_event_cursor goes over.
+        /// Blocks are cut at "Event" lines, the incomplete event at the end waits for the next block in m_block_tail
+        std::unique_ptr<DecompressingReader> m_decompressor;
+        std::shared_ptr<const std::string> m_text_block;
+        std::string m_block_tail;
+        std::string m_decompressed;
+        bool m_decompressed_end = false;
+
+        /// io:decompress_block_size, io:decompress_blocks - decompression ring buffer
+        uint64_t m_cfg_decompress_block_size = 4 * 1024 * 1024;
+        uint64_t m_cfg_decompress_blocks = 8;
+
+        /// io:stream_connect_timeout - fifo:// or unix:// input
+        double m_cfg_stream_connect_timeout = 30;
+        bool m_is_stream = false;
+
+        /// io:use_mmap - memory map the file and parse it in place without per line allocations
+        bool m_cfg_use_mmap = true;
+
+        /// Event range to process: io:skip_events, io:max_events (0 - no limit)
+        uint64_t m_cfg_skip_events = 0;
+        uint64_t m_cfg_max_events = 0;
+
+        /// io:write_index - save event offset index built by pre-scan as a sidecar file
+        bool m_cfg_write_index = true;
+
+        /// io:write_cache, io:cache_chunk_events - write binary columnar cache during the first pass
+        bool m_cfg_write_cache = false;
+        uint64_t m_cfg_cache_chunk_events = 10000;
+        std::unique_ptr<BinaryCacheWriter> m_cache_writer;
+
+        /// io:parallel_parse - Emit only cuts event text, parsing is done by DigitizedTextEventFactory
+        bool m_cfg_parallel_parse = true;
+        bool m_is_parallel_parse = false;   // Actual mode (parallel parse might be not possible)
+
+        /// Hit line layout (with or without true X Y Z) of the current file. Detected once by the first hit line,
+        /// then all hits of the file are parsed with the parser of this layout
+        std::optional<HitLayout> m_hit_layout;
+
+        /// io:pileup_* - several input tracks in one event
+        PileupMixer::Config m_cfg_pileup;
+        PileupMixer m_pileup;
+
+        /// Deterministic event numbers and run number (see InputFilesService)
+        std::shared_ptr<services::InputFilesService> m_input_files;
+        size_t m_file_index = 0;
+        int32_t m_run_number = 0;
+
+        /// io:timeslice_events - emit timeslices of this many physics events. 0 - physics events
+        uint64_t m_cfg_timeslice_events = 0;
+
+        /// Number of events (and timeslices) emitted from this file
+        uint64_t m_emitted_events = 0;
+        uint64_t m_emitted_timeslices = 0;
+
+        /// Index in the file of the next input event ("Event" line), skipped and empty events included
+        uint64_t m_file_event_index = 0;
+
+        /// The whole file has been read
+        bool m_reached_end = false;
+
+        /// Physics events for one Emit (one event or a timeslice): event ranges and their tracks
+        /// as text events (parallel parse) or parsed PODIO collections ready to insert
+        struct EmitBatch {
+            std::vector<DigitizedTimeslice::Event> events;
+            std::vector<std::unique_ptr<DigitizedTextEvent>> text_events;
+            DigitizedMtpcMcTrackCollection tracks;
+            DigitizedMtpcMcHitCollection hits;
+        };
+
+        /// io:prefetch_events - read-ahead thread prepares batches for Emit. The thread owns reading state while it runs
+        uint64_t m_cfg_prefetch_events = 16;
+        std::unique_ptr<ReadAheadQueue<EmitBatch>> m_prefetch_queue;
+        std::thread m_prefetch_thread;
+        std::exception_ptr m_prefetch_error;
+
+        /// Read-ahead hints for plain text files
+        FileReadAdvice m_read_advice;
+
     public:
         DigitizedDataEventSource();
 
         DigitizedDataEventSource(std::string resource_name, JApplication* app);
 
-        ~DigitizedDataEventSource() override = default;
+        /// Stops read-ahead and closes the input if JANA didn't call Close (e.g. processing was aborted)
+        ~DigitizedDataEventSource() override;
 
         /// Initializes class (after all JANA2 services are ready to serve)
         void Init() override;
@@ -108,11 +275,43 @@ namespace tdis::io {
         static std::string GetDescription();
     private:
 
-        /// Parses string tokens to form DigitizedReadoutHit
-        bool ParseTrackHit(const std::vector<std::string>& tokens, DigitizedReadoutHit& result);
+        /// Detects hit layout of the file by the first event with hits. Does nothing once it is known
+        void DetectFileHitLayout(std::string_view event_text);
+
+        /// Reads the next event with std::getline and fills PODIO collections (io:use_mmap=false)
+        Result ReadStreamEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, double time_offset);
+
+        /// Reads input tracks of the next physics event (several with pile-up mixing)
+        /// to text_events (parallel parse) or PODIO collections. Returns number of tracks, 0 at the end of file.
+        /// first_file_event is set to the index in the file of the first track
+        size_t ReadPhysicsEvent(std::vector<std::unique_ptr<DigitizedTextEvent>>& text_events, DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, uint64_t& first_file_event);
+
+        /// Reads physics events for the next Emit. Returns false if there are no more events
+        bool ReadBatch(EmitBatch& batch);
+
+        /// Takes the next batch from the read-ahead thread or reads it. Returns false if there are no more events
+        bool NextBatch(EmitBatch& batch);
+
+        /// Starts read-ahead thread (io:prefetch_events > 0)
+        void StartPrefetch();
+
+        /// Stops and joins read-ahead thread
+        void StopPrefetch();
+
+        /// Takes text of the next event from memory mapped file or decompressed blocks
+        Result NextTextSpan(TextEventSpan& span);
+
+        /// Takes the next block of complete events from the decompression thread. Returns false at the end of data
+        bool NextDecompressedBlock();
 
-        /// Parses string tokens to form DigitizedReadoutTrack
-        bool ParseTrackHeader(const std::vector<std::string>& tokens, DigitizedReadoutTrack& result);
+        /// Takes the next event from memory mapped file or decompressed blocks and fills PODIO collections
+        Result ReadTextEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, double time_offset);
+
+        /// Loads event offset index from the sidecar file or builds it by pre-scanning the file
+        EventOffsetIndex LoadOrBuildIndex();
+
+        /// Positions the input at io:skip_events event using the event offset index
+        void SkipEvents();
     };
 
 
@@ -126,28 +325,264 @@ namespace tdis::io {
     inline DigitizedDataEventSource::DigitizedDataEventSource(std::string resource_name, JApplication* app): JEventSource(resource_name, app) {
         SetTypeName(NAME_OF_THIS);  // Provide JANA with class name
         SetCallbackStyle(CallbackStyle::ExpertMode);
+
+        // JANA builds processing topology by the event level of sources before Init is called
+        app->SetDefaultParameter("io:timeslice_events", m_cfg_timeslice_events,
+            "Emit timeslices of this many physics events (split back by DigitizedTimesliceUnfolder). 0 - emit physics events");
+        SetLevel(m_cfg_timeslice_events ? JEventLevel::Timeslice : JEventLevel::PhysicsEvent);
     }
 
     inline void DigitizedDataEventSource::Init() {
         auto app = GetApplication();
         m_log = app->GetService<tdis::services::LogService>()->logger("DigitizedDataEventSource");
+        m_input_files = app->GetService<tdis::services::InputFilesService>();
+
+        app->SetDefaultParameter("io:use_mmap", m_cfg_use_mmap,
+            "Memory map input .txt file and parse it in place (true) or read it line by line with std::getline (false)");
+        app->SetDefaultParameter("io:skip_events", m_cfg_skip_events,
+            "Number of events to skip. Seeks with the event offset index without reading skipped events");
+        app->SetDefaultParameter("io:max_events", m_cfg_max_events,
+            "Maximum number of events to process from each file after skipped ones. 0 - all events");
+        app->SetDefaultParameter("io:write_index", m_cfg_write_index,
+            "Save event offset index built by pre-scan as '<file>.idx' next to the input file");
+        app->SetDefaultParameter("io:write_cache", m_cfg_write_cache,
+            "Write binary columnar cache '<file>.tdisbin' while reading the whole text file. Next runs read the cache");
+        app->SetDefaultParameter("io:cache_chunk_events", m_cfg_cache_chunk_events,
+            "Number of events in one chunk of the binary cache");
+        app->SetDefaultParameter("io:parallel_parse", m_cfg_parallel_parse,
+            "Parse event text in parallel by DigitizedTextEventFactory instead of the serialized Emit (needs io:use_mmap or compressed input)");
+        app->SetDefaultParameter("io:decompress_block_size", m_cfg_decompress_block_size,
+            "Size in bytes of decompressed blocks of .gz/.zst/.lz4 input");
+        app->SetDefaultParameter("io:decompress_blocks", m_cfg_decompress_blocks,
+            "Number of decompressed blocks buffered ahead of the source by decompression thread");
+        app->SetDefaultParameter("io:stream_connect_timeout", m_cfg_stream_connect_timeout,
+            "Seconds to wait for the digitizer to start listening on unix:// socket input");
+        app->SetDefaultParameter("io:prefetch_events", m_cfg_prefetch_events,
+            "Number of emitted events (or timeslices) a read-ahead thread reads and parses ahead of Emit. 0 - read in Emit");
+        PileupMixer::DefineParameters(app, m_cfg_pileup);
     }
 
     inline void DigitizedDataEventSource::Open() {
-        // Open the file
-        m_input_file = std::ifstream(this->GetResourceName());
+        m_is_stream = IsStreamResource(this->GetResourceName());
+        if (m_is_stream) {
+            try {
+                m_log->info("Waiting for stream '{}'", this->GetResourceName());
+                int fd = OpenStreamResource(this->GetResourceName(), m_cfg_stream_connect_timeout);
+                m_decompressor = std::make_unique<DecompressingReader>(m_cfg_decompress_block_size, m_cfg_decompress_blocks);
+                m_decompressor->OpenStream(fd, this->GetResourceName());
+            } catch (const std::exception& ex) {
+                auto message= fmt::format("Error: {}", ex.what());
+                m_log->error(message);
+                throw std::runtime_error(message);
+            }
+            m_event_cursor.Reset({});
+            m_block_tail.clear();
+            m_decompressed_end = false;
+        } else if (DetectCompression(this->GetResourceName()) != Compression::None) {
+            try {
+                m_decompressor = std::make_unique<DecompressingReader>(m_cfg_decompress_block_size, m_cfg_decompress_blocks);
+                m_decompressor->Open(this->GetResourceName());
+            } catch (const std::exception& ex) {
+                auto message= fmt::format("Error: {}", ex.what());
+                m_log->error(message);
+                throw std::runtime_error(message);
+            }
+            m_event_cursor.Reset({});
+            m_block_tail.clear();
+            m_decompressed_end = false;
+        } else if (m_cfg_use_mmap) {
+            try {
+                m_mapped_file = std::make_shared<MappedFile>(this->GetResourceName());
+            } catch (const std::exception& ex) {
+                auto message= fmt::format("Error: {}", ex.what());
+                m_log->error(message);
+                throw std::runtime_error(message);
+            }
+            m_event_cursor.Reset(m_mapped_file->View());
+            m_read_advice.Open(this->GetResourceName());
+        } else {
+            // Open the file
+            m_input_file = std::ifstream(this->GetResourceName());
+
+            // Check if the file was successfully opened
+            if (!m_input_file.is_open()) {
+                auto message= fmt::format("Error: Could not open the file: '{}'", this->GetResourceName());
+                m_log->error(message);
+                throw std::runtime_error(message);
+            }
+            m_read_advice.Open(this->GetResourceName());
+        }
 
-        // Check if the file was successfully opened
-        if (!m_input_file.is_open()) {
-            auto message= fmt::format("Error: Could not open the file: '{}'", this->GetResourceName());
-            m_log->error(message);
-            throw std::runtime_error(message);
+        m_emitted_events = 0;
+        m_emitted_timeslices = 0;
+        m_file_event_index = 0;
+        m_reached_end = false;
+        m_hit_layout.reset();
+        m_file_index = m_input_files->GetFileIndex(this->GetResourceName());
+        m_run_number = m_input_files->GetRunNumber(this->GetResourceName());
+        m_log->info("Opened '{}' as input file #{}, run number {}", this->GetResourceName(), m_file_index, m_run_number);
+        m_pileup.Configure(m_cfg_pileup);
+        if (m_cfg_skip_events > 0) {
+            SkipEvents();
+        }
+
+        // Cache is written only if the whole file is going to be read
+        if (m_cfg_write_cache) {
+            if (!(m_mapped_file || m_decompressor) || m_is_stream || m_cfg_skip_events || m_cfg_max_events) {
+                m_log->warn("io:write_cache needs a file, io:use_mmap=true or compressed input and no io:skip_events/io:max_events. Cache is not written");
+            } else {
+                try {
+                    m_cache_writer = std::make_unique<BinaryCacheWriter>(this->GetResourceName(), m_cfg_cache_chunk_events);
+                } catch (const std::exception& ex) {
+                    m_log->warn("Binary cache is not written: {}", ex.what());
+                }
+            }
+        }
+
+        // Cache is written in the order of events, so it needs parsing in Emit
+        m_is_parallel_parse = m_cfg_parallel_parse && (m_mapped_file || m_decompressor) && !m_cache_writer;
+        m_log->debug("Event text is parsed in {}", m_is_parallel_parse ? "DigitizedTextEventFactory" : "Emit");
+
+        StartPrefetch();
+    }
+
+    inline void DigitizedDataEventSource::StartPrefetch() {
+        if (!m_cfg_prefetch_events) {
+            return;
+        }
+
+        m_prefetch_error = nullptr;
+        m_prefetch_queue = std::make_unique<ReadAheadQueue<EmitBatch>>(m_cfg_prefetch_events);
+        m_prefetch_thread = std::thread([this] {
+            try {
+                EmitBatch batch;
+                while (ReadBatch(batch) && m_prefetch_queue->Push(std::move(batch))) {
+                    batch = EmitBatch();
+                }
+            } catch (...) {
+                // Rethrown by Emit after the events read before the error
+                m_prefetch_error = std::current_exception();
+            }
+            m_prefetch_queue->Finish();
+        });
+        m_log->debug("Read-ahead thread started, up to {} batches ahead", m_cfg_prefetch_events);
+    }
+
+    inline void DigitizedDataEventSource::StopPrefetch() {
+        if (!m_prefetch_thread.joinable()) {
+            return;
+        }
+        m_prefetch_queue->Close();
+        if (m_decompressor) {
+            // The thread may wait for the next block of a stream
+            m_decompressor->Close();
+        }
+        m_prefetch_thread.join();
+        m_prefetch_queue.reset();
+    }
+
+    inline EventOffsetIndex DigitizedDataEventSource::LoadOrBuildIndex() {
+        const auto& file_path = this->GetResourceName();
+
+        EventOffsetIndex index;
+        if (index.Load(file_path)) {
+            m_log->info("Loaded event offset index '{}' with {} events", EventOffsetIndex::SidecarPath(file_path), index.Size());
+            return index;
+        }
+
+        // Pre-scan looks only for "Event" lines, so it is much faster than parsing
+        m_log->info("Building event offset index for '{}'", file_path);
+        if (m_mapped_file) {
+            index = EventOffsetIndex::Build(m_mapped_file->View());
+        } else {
+            MappedFile scan_file(file_path);
+            index = EventOffsetIndex::Build(scan_file.View());
+        }
+        m_log->info("Event offset index has {} events", index.Size());
+
+        if (m_cfg_write_index) {
+            if (index.Save(file_path)) {
+                m_log->info("Event offset index saved to '{}'", EventOffsetIndex::SidecarPath(file_path));
+            } else {
+                m_log->warn("Could not save event offset index to '{}'", EventOffsetIndex::SidecarPath(file_path));
+            }
+        }
+        return index;
+    }
+
+    inline void DigitizedDataEventSource::SkipEvents() {
+        if (m_decompressor) {
+            // No random access in compressed stream. Events are only cut, not parsed
+            m_log->info("Skipping {} events in compressed input", m_cfg_skip_events);
+            TextEventSpan span;
+            for (uint64_t skipped = 0; skipped < m_cfg_skip_events;) {
+                auto result = NextTextSpan(span);
+                if (result == Result::FailureFinished) {
+                    m_log->warn("io:skip_events={} but the file has only {} events. Nothing to process", m_cfg_skip_events, skipped);
+                    return;
+                }
+                skipped++;      // Empty events count too, as in the event offset index
+            }
+            return;
+        }
+
+        auto index = LoadOrBuildIndex();
+        if (m_cfg_skip_events >= index.Size()) {
+            m_log->warn("io:skip_events={} but the file has only {} events. Nothing to process", m_cfg_skip_events, index.Size());
+            if (m_mapped_file) {
+                m_event_cursor.Reset(m_mapped_file->View(), m_mapped_file->Size());
+            }
+            m_input_file.setstate(std::ios::eofbit);
+            m_file_event_index = index.Size();
+            return;
+        }
+
+        const auto& entry = index[m_cfg_skip_events];
+        m_file_event_index = m_cfg_skip_events;
+        m_log->info("Skipping {} events. Starting at 'Event {}', line {}", m_cfg_skip_events, entry.file_event_number, entry.line_index);
+        m_current_line_index = entry.line_index;
+        if (m_mapped_file) {
+            m_event_cursor.Reset(m_mapped_file->View(), entry.offset, entry.line_index);
+        } else {
+            m_input_file.seekg(static_cast<std::streamoff>(entry.offset));
+        }
+    }
+
+    inline DigitizedDataEventSource::~DigitizedDataEventSource() {
+        // A joinable read-ahead thread would call std::terminate. Close does nothing more after a previous Close
+        try {
+            Close();
+        } catch (const std::exception& e) {
+            std::cerr << "DigitizedDataEventSource: error closing '" << this->GetResourceName() << "': " << e.what() << std::endl;
         }
     }
 
     inline void DigitizedDataEventSource::Close() {
+        // Read-ahead thread uses the input, so it is stopped first
+        StopPrefetch();
+        m_read_advice.Close();
+
         // Close the file pointer here!
         m_input_file.close();
+        m_event_cursor.Reset({});
+        m_mapped_file.reset();
+        if (m_decompressor) {
+            m_decompressor->Close();
+            m_decompressor.reset();
+        }
+        m_text_block.reset();
+        m_block_tail.clear();
+        m_block_tail.shrink_to_fit();
+
+        if (m_cache_writer) {
+            if (m_reached_end) {
+                m_cache_writer->Finish();
+                m_log->info("Binary cache with {} events written to '{}'", m_cache_writer->EventCount(), GetBinaryCachePath(this->GetResourceName()));
+            } else {
+                m_cache_writer->Abort();
+            }
+            m_cache_writer.reset();
+        }
     }
 
     inline void PrintStreamError(const std::ifstream& file) {
@@ -165,119 +600,336 @@ namespace tdis::io {
     }
 
 
-    static std::vector<std::string> SplitDataString(const std::string& line) {
-        std::vector<std::string> tokens;
-        const char* str = line.data();
-        const char* end = str + line.size();
+    /// Copies DigitizedReadoutHit to PODIO hit converting units to Acts units. time_offset (ns) is added to the hit time
+    inline void FillPodioHit(const DigitizedReadoutHit& hit, MutableDigitizedMtpcMcHit& podioHit, double time_offset = 0) {
+        podioHit.time(   (hit.time + time_offset) * Acts::UnitConstants::ns  );
+        podioHit.adc(    hit.adc   );
+        podioHit.ring(   hit.ring  );
+        podioHit.pad(    hit.pad   );
+        podioHit.plane(  hit.plane );
+        podioHit.zToGem( hit.zToGem  * Acts::UnitConstants::m);
+
+        edm4hep::Vector3f true_pos = edm4hep::Vector3f{
+            static_cast<float>(hit.true_x * Acts::UnitConstants::m),
+            static_cast<float>(hit.true_y * Acts::UnitConstants::m),
+            static_cast<float>(hit.true_z * Acts::UnitConstants::m)
+        };
+        podioHit.truePosition(true_pos);
+    }
+
+    /// Copies hit of a known layout to PODIO hit converting units to Acts units. Hits without truth get NaN true position
+    template <HitLayout Layout>
+    inline void FillPodioHit(const LayoutHit<Layout>& hit, MutableDigitizedMtpcMcHit& podioHit, double time_offset = 0) {
+        podioHit.time(   (hit.time + time_offset) * Acts::UnitConstants::ns  );
+        podioHit.adc(    hit.adc   );
+        podioHit.ring(   hit.ring  );
+        podioHit.pad(    hit.pad   );
+        podioHit.plane(  hit.plane );
+        podioHit.zToGem( hit.zToGem  * Acts::UnitConstants::m);
+
+        if constexpr (Layout == HitLayout::WithTruth) {
+            podioHit.truePosition(edm4hep::Vector3f{
+                static_cast<float>(hit.true_x * Acts::UnitConstants::m),
+                static_cast<float>(hit.true_y * Acts::UnitConstants::m),
+                static_cast<float>(hit.true_z * Acts::UnitConstants::m)
+            });
+        } else {
+            constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+            podioHit.truePosition(edm4hep::Vector3f{nan, nan, nan});
+        }
+    }
+
+    /** Parses text of one event (track header line followed by hit lines) straight into PODIO collections
+     *  Hit lines are parsed with the parser of the given layout in place as std::string_view and converted with
+     *  std::from_chars, so there are no per-line allocations and no per-hit column count checks.
+     *  If cache_writer is given, parsed values are also added to the binary cache.
+     *  time_offset (ns) is added to PODIO hit times (pile-up mixing), the cache gets times as in the file.
+     *  The track is added with its first hit, so a track without hits is not added anywhere.
+     *  Returns false if the track header line can't be parsed */
+    template <HitLayout Layout>
+    inline bool ParseTextEvent(const TextEventSpan& span,
+                               DigitizedMtpcMcTrackCollection& podioTracks,
+                               DigitizedMtpcMcHitCollection& podioHits,
+                               spdlog::logger& log,
+                               BinaryCacheWriter* cache_writer = nullptr,
+                               double time_offset = 0) {
+        std::string_view text = span.text;
+        size_t line_index = span.line_index + 1;   // +1 is "Event" line
+        LineTokens tokens;
+
+        // First line is always track/event header
+        DigitizedReadoutTrack track{};
+        auto count = TokenizeDataLine(NextLine(text), tokens);
+        if (!ParseTrackHeaderTokens(tokens, count, track)) {
+            log.warn("Could not parse track info. Tokens number {}. Near line: {}", count, line_index);
+            return false;
+        }
+
+        std::optional<MutableDigitizedMtpcMcTrack> podioTrack;
+        while (!text.empty()) {
+            line_index++;
+            auto line = NextLine(text);
+
+            LayoutHit<Layout> hit;
+            if (!ParseHitLine(line, hit)) {
+                // Empty lines between events or at the end of file are fine
+                if (!IsBlankLine(line)) {
+                    log.warn("Could not parse track hit with {} columns. Near line: {}", LayoutHit<Layout>::kColumns, line_index);
+                }
+                continue;
+            }
 
-        while (str < end) {
-            // Skip leading whitespace
-            while (str < end && std::isspace(static_cast<unsigned char>(*str))) {
-                ++str;
+            if (!podioTrack) {
+                podioTrack = podioTracks.create();
+                podioTrack->phi(track.phi);
+                podioTrack->theta(track.theta);
+                podioTrack->vertexZ(track.vertexZ);
+                podioTrack->momentum(track.momentum);
+                if (cache_writer) {
+                    cache_writer->BeginEvent(span.file_event_number, track);
+                }
             }
 
-            if (str >= end) break;
+            auto podioHit = podioHits.create();
+            FillPodioHit(hit, podioHit, time_offset);
+            podioTrack->addhits(podioHit);
+            if (cache_writer) {
+                cache_writer->AddHit(hit);
+            }
+        }
+        return true;
+    }
 
-            // Start of the token
-            const char* token_start = str;
+    /// Parses event text with the parser of the file hit layout. See ParseTextEvent<Layout>
+    inline bool ParseTextEvent(const TextEventSpan& span,
+                               HitLayout layout,
+                               DigitizedMtpcMcTrackCollection& podioTracks,
+                               DigitizedMtpcMcHitCollection& podioHits,
+                               spdlog::logger& log,
+                               BinaryCacheWriter* cache_writer = nullptr,
+                               double time_offset = 0) {
+        if (layout == HitLayout::WithTruth) {
+            return ParseTextEvent<HitLayout::WithTruth>(span, podioTracks, podioHits, log, cache_writer, time_offset);
+        }
+        return ParseTextEvent<HitLayout::NoTruth>(span, podioTracks, podioHits, log, cache_writer, time_offset);
+    }
+
+    inline void DigitizedDataEventSource::DetectFileHitLayout(std::string_view event_text) {
+        HitLayout layout;
+        if (m_hit_layout || !DetectHitLayout(event_text, layout)) {
+            return;
+        }
+        m_hit_layout = layout;
+        m_log->info("Hit lines have {} columns{}", layout == HitLayout::WithTruth ? kHitColumnsWithTruth : kHitColumnsNoTruth,
+                    layout == HitLayout::WithTruth ? " (with true X Y Z)" : "");
+    }
+
+    inline JEventSource::Result DigitizedDataEventSource::Emit(JEvent& event) {
+        // Calls to GetEvent are synchronized with each other, which means they can
+        // read and write state on the JEventSource without causing race conditions.
+
+        EmitBatch batch;
+        if (!NextBatch(batch)) {
+            return Result::FailureFinished;
+        }
 
-            // Find the end of the token
-            while (str < end && !std::isspace(static_cast<unsigned char>(*str))) {
-                ++str;
+        // Timeslice collections have "Ts" prefix to not be confused with physics event ones
+        const std::string prefix = m_cfg_timeslice_events ? "Ts" : "";
+        if (m_is_parallel_parse) {
+            std::vector<DigitizedTextEvent*> text_events;
+            text_events.reserve(batch.text_events.size());
+            for (auto& text_event: batch.text_events) {
+                text_events.push_back(text_event.release());
             }
+            event.Insert(text_events, prefix + "DigitizedTextEvent");
+        } else {
+            event.InsertCollection<DigitizedMtpcMcTrack>(std::move(batch.tracks), prefix + "DigitizedMtpcMcTrack");
+            event.InsertCollection<DigitizedMtpcMcHit>(std::move(batch.hits), prefix + "DigitizedMtpcMcHit");
+        }
+
+        if (!m_cfg_timeslice_events) {
+            const uint64_t event_number = batch.events.front().event_number;
+            event.SetEventNumber(event_number);
+            event.SetRunNumber(m_run_number);
 
-            // Extract the token and add it to the vector
-            tokens.emplace_back(token_start, str - token_start);
+            EventInfoCollection info;
+            info.push_back(MutableEventInfo(event_number, 0, m_run_number)); // event nr, timeslice nr, run nr
+            event.InsertCollection<EventInfo>(std::move(info), "EventInfo");
+            return Result::Success;
         }
 
-        return tokens;
+        auto timeslice = std::make_unique<DigitizedTimeslice>();
+        timeslice->events = std::move(batch.events);
+        timeslice->timeslice_number = m_input_files->GetGlobalEventNumber(m_file_index, m_emitted_timeslices++);
+        timeslice->run_number = m_run_number;
+        timeslice->has_text_events = m_is_parallel_parse;
+        event.SetEventNumber(timeslice->timeslice_number);
+        event.SetRunNumber(m_run_number);
+
+        TimesliceInfoCollection timeslice_info;
+        timeslice_info.push_back(MutableTimesliceInfo(timeslice->timeslice_number, m_run_number));
+        event.InsertCollection<TimesliceInfo>(std::move(timeslice_info), "TimesliceInfo");
+        event.Insert(timeslice.release(), "DigitizedTimeslice");
+        return Result::Success;
+    }
+
+    inline bool DigitizedDataEventSource::NextBatch(EmitBatch& batch) {
+        if (!m_prefetch_queue) {
+            return ReadBatch(batch);
+        }
+        if (m_prefetch_queue->Pop(batch)) {
+            return true;
+        }
+        if (m_prefetch_error) {
+            std::rethrow_exception(m_prefetch_error);
+        }
+        return false;
     }
 
+    inline bool DigitizedDataEventSource::ReadBatch(EmitBatch& batch) {
+        // One physics event or a timeslice of io:timeslice_events physics events
+        const uint64_t events_to_read = m_cfg_timeslice_events ? m_cfg_timeslice_events : 1;
 
-    static std::vector<std::string> ReadNextEventLines(std::ifstream& input_file) {
-        std::vector<std::string> lines;
+        while (batch.events.size() < events_to_read) {
+            if (m_cfg_max_events && m_emitted_events >= m_cfg_max_events) {
+                m_log->info("Reached io:max_events={}", m_cfg_max_events);
+                break;
+            }
 
-        while (true) {
-            if (!input_file) {
-                return lines;
+            const size_t first_track = m_is_parallel_parse ? batch.text_events.size() : batch.tracks.size();
+            uint64_t first_file_event = 0;
+            const size_t track_count = ReadPhysicsEvent(batch.text_events, batch.tracks, batch.hits, first_file_event);
+            if (track_count == 0) {
+                break;
             }
 
-            // Read the file line by line
-            std::string line;
-            std::getline(input_file, line);
+            // Event number depends only on the file and position of the first track in it,
+            // not on the order sources are read, empty events or how many tracks pile-up mixes to an event
+            const uint64_t event_number = m_input_files->GetGlobalEventNumber(m_file_index, first_file_event);
+            batch.events.push_back({event_number, static_cast<uint32_t>(first_track), static_cast<uint32_t>(track_count)});
+            m_emitted_events++;
+        }
 
-            if (line.starts_with("Event")) {
-                if (lines.empty()) {
-                    // This probably means the beginning of file, the first event
-                    continue;
+        // Ask for the data ahead of what is read
+        if (m_mapped_file) {
+            m_read_advice.Advance(m_event_cursor.Offset());
+        } else if (m_input_file.is_open()) {
+            auto position = m_input_file.tellg();
+            if (position >= 0) {
+                m_read_advice.Advance(static_cast<uint64_t>(position));
+            }
+        }
+
+        return !batch.events.empty();
+    }
+
+    inline size_t DigitizedDataEventSource::ReadPhysicsEvent(std::vector<std::unique_ptr<DigitizedTextEvent>>& text_events, DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, uint64_t& first_file_event) {
+        // One input track per event or several with io:pileup_* mixing
+        const size_t tracks_in_event = m_pileup.NextMultiplicity();
+        size_t track_count = 0;
+
+        while (track_count < tracks_in_event) {
+            const double time_offset = m_pileup.NextTimeOffset(track_count);
+            Result result;
+            if (m_is_parallel_parse) {
+                // Parsing is done by DigitizedTextEventFactory in worker threads
+                TextEventSpan span;
+                result = NextTextSpan(span);
+                if (result == Result::Success) {
+                    std::shared_ptr<const void> buffer_owner = m_decompressor ? std::shared_ptr<const void>(m_text_block) : m_mapped_file;
+                    text_events.push_back(std::make_unique<DigitizedTextEvent>(DigitizedTextEvent{std::move(buffer_owner), span, time_offset, m_hit_layout.value_or(HitLayout::NoTruth)}));
                 }
-                // This means we read till the next events
-                return lines;
+            } else {
+                result = (m_mapped_file || m_decompressor) ? ReadTextEvent(podioTracks, podioHits, time_offset) : ReadStreamEvent(podioTracks, podioHits, time_offset);
             }
 
-            lines.emplace_back(line);
+            // Empty events in the file are just skipped. The last mixed event may have less tracks
+            if (result == Result::FailureFinished) {
+                break;
+            }
+            if (result == Result::Success && track_count++ == 0) {
+                first_file_event = m_file_event_index - 1;
+            }
         }
+        return track_count;
     }
 
-    inline bool DigitizedDataEventSource::ParseTrackHeader(const std::vector<std::string>& tokens, DigitizedReadoutTrack& result) {
-        if (tokens.size() < 4) {
-            m_log->warn("Could not parse track info. Incorrect tokens number {}. Near line: {}", tokens.size(), m_current_line_index);
-            return false;
+    inline JEventSource::Result DigitizedDataEventSource::NextTextSpan(TextEventSpan& span) {
+        while (!m_event_cursor.Next(span)) {
+            if (!m_decompressor || !NextDecompressedBlock()) {
+                m_log->debug("Reached end of file at line: {}", m_event_cursor.LineIndex());
+                m_reached_end = true;
+                return Result::FailureFinished;
+            }
         }
+        m_current_line_index = span.line_index;
+        m_file_event_index++;
 
-        result.momentum = std::stod(tokens[0]);  // (GeV/c)
-        result.theta = std::stod(tokens[1]);     // (degrees)
-        result.phi = std::stod(tokens[2]);       // (degrees)
-        result.vertexZ = std::stod(tokens[3]);   // (m)
-        return true;
+        if (span.text.find_first_not_of(" \t\r\n") == std::string_view::npos) {
+            m_log->debug("Empty event at line (near): {}\n", m_current_line_index);
+            return Result::FailureTryAgain;
+        }
+        DetectFileHitLayout(span.text);
+        return Result::Success;
     }
 
-    inline bool DigitizedDataEventSource::ParseTrackHit(const std::vector<std::string>& tokens, DigitizedReadoutHit& result) {
-        if (tokens.empty()) {
-            m_log->info("Could not parse track hit. Tokens are empty. Empty line? Near line: {}", m_current_line_index);
-            return false;
+    inline bool DigitizedDataEventSource::NextDecompressedBlock() {
+        // Blocks always start at "Event" line (or file start). The block ends before the last "Event" line found,
+        // as the event after it may continue in the next decompressed block
+        std::string text = std::move(m_block_tail);
+        m_block_tail.clear();
+        size_t cut = std::string::npos;
+        while (true) {
+            auto found = text.rfind("\nEvent");
+            if (found != std::string::npos) {
+                cut = found + 1;
+                break;
+            }
+            if (m_decompressed_end) {
+                cut = text.size();
+                break;
+            }
+            if (!m_decompressor->NextBlock(m_decompressed)) {
+                m_decompressed_end = true;
+                continue;
+            }
+            text.append(m_decompressed);
         }
-        if (tokens.size() < 6) {
-            m_log->warn("Could not parse track hit. Incorrect tokens number {}. Near line: {}", tokens.size(), m_current_line_index);
+
+        if (cut == 0 || text.empty()) {
             return false;
         }
 
-        if(tokens.size() == 6) {
-            // Files with no true X Y Z hit info
-            result.time   = std::stod(tokens[0]);    // - Time of arrival at Pad (ns)
-            result.adc    = std::stod(tokens[1]);    // - Amplitude (ADC bin of sample)
-            result.ring   = std::stoi(tokens[2]);    // - Ring (id of rin, 0 is innermost).
-            result.pad    = std::stoi(tokens[3]);    // - Pad (id of pad, 0 is at or closest to phi=0 and numbering is clockwise).
-            result.plane  = std::stoi(tokens[4]);    // - Plane(id of z plane from 0 upstream  to 9 downstream)
-            result.zToGem = std::stod(tokens[5]);    // - ZtoGEM (m)
+        m_block_tail.assign(text, cut);
+        text.resize(cut);
+        m_text_block = std::make_shared<const std::string>(std::move(text));
+        m_event_cursor.Reset(*m_text_block, 0, m_event_cursor.LineIndex());
+        return true;
+    }
 
-            // True hit information is not set
-            result.true_x = std::numeric_limits<double>::quiet_NaN();
-            result.true_y = std::numeric_limits<double>::quiet_NaN();
-            result.true_z = std::numeric_limits<double>::quiet_NaN();
-        } else {
-            result.time   = std::stod(tokens[0]);    // - Time of arrival at Pad (ns)
-            result.adc    = std::stod(tokens[1]);    // - Amplitude (ADC bin of sample)
-            result.true_x = std::stod(tokens[2]);    // True X Y Z of hit
-            result.true_y = std::stod(tokens[3]);
-            result.true_z = std::stod(tokens[4]);
-            result.ring   = std::stoi(tokens[5]);    // - Ring (id of rin, 0 is innermost).
-            result.pad    = std::stoi(tokens[6]);    // - Pad (id of pad, 0 is at or closest to phi=0 and numbering is clockwise).
-            result.plane  = std::stoi(tokens[7]);    // - Plane(id of z plane from 0 upstream  to 9 downstream)
-            result.zToGem = std::stod(tokens[8]);    // - ZtoGEM (m)
+    inline JEventSource::Result DigitizedDataEventSource::ReadTextEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, double time_offset) {
+        TextEventSpan span;
+        auto result = NextTextSpan(span);
+        if (result != Result::Success) {
+            return result;
         }
 
-        return true;
-    }
+        const size_t hit_count = podioHits.size();
+        if (!ParseTextEvent(span, m_hit_layout.value_or(HitLayout::NoTruth), podioTracks, podioHits, *m_log, m_cache_writer.get(), time_offset)) {
+            return Result::FailureFinished;
+        }
 
-    inline JEventSource::Result DigitizedDataEventSource::Emit(JEvent& event) {
-        // Calls to GetEvent are synchronized with each other, which means they can
-        // read and write state on the JEventSource without causing race conditions.
+        // A track without hits is not added by the parser and is skipped like an empty event
+        if (podioHits.size() == hit_count) {
+            m_log->warn("Track without hits is skipped. Near line: {}", m_current_line_index);
+            return Result::FailureTryAgain;
+        }
 
-        static size_t current_event_number = 1;
-        event.SetEventNumber(current_event_number++);
-        event.SetRunNumber(22);
+        m_log->info("Event has been emitted at {}", m_current_line_index);
+        return Result::Success;
+    }
 
+    inline JEventSource::Result DigitizedDataEventSource::ReadStreamEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits, double time_offset) {
         auto lines = ReadNextEventLines(m_input_file);
         if (lines.empty()) {
             if (m_input_file.bad() || m_input_file.fail() || m_input_file.eof()) {
@@ -290,6 +942,7 @@ namespace tdis::io {
         }
 
         size_t m_event_line_index = m_current_line_index;
+        m_file_event_index++;
 
         // (!) Each new event starts with Event word, which is thrown out by ReadNextEventLines
         // but we need to count it in m_current_line_index
@@ -302,71 +955,29 @@ namespace tdis::io {
             return Result::FailureTryAgain;
         }
 
-        // First we parse event into DigitizedReadoutTrack with DigitizedReadoutHits
-        // Then we will copy it to PODIO structures
-        // We do this extra step because in future we want to merge tracks in various ways
-
-        // Parse track
-        DigitizedReadoutTrack track{};
-        try {
-            auto tokens = SplitDataString(lines[0]);
-            if(!ParseTrackHeader(tokens, track)) {
-                return Result::FailureFinished;
-            }
-
-            for (auto i = 1; i < lines.size(); ++i) {
-                DigitizedReadoutHit hit{};
-                tokens = SplitDataString(lines[i]);
-                if(!ParseTrackHit(tokens, hit)) {
-                    continue;
-                }
-                track.hits.emplace_back(hit);
-            }
-
-            m_current_line_index += lines.size();
-        } catch (...) {
-            fmt::print("Error parsing event/track. Near line: {}\n", m_current_line_index);
-            throw;
+        // Lines are joined back to the event text, so it is parsed the same way as memory mapped input
+        std::string text;
+        for (const auto& line: lines) {
+            text.append(line);
+            text.push_back('\n');
         }
-
-        // Double check that we have some track with some hits
-        if(track.hits.empty()) {
-            m_log->warn("Could not parse track hit. WE SHOULDN'T BE HERE. Near line: {}", m_current_line_index);
+        TextEventSpan span;
+        span.text = text;
+        span.line_index = m_event_line_index;
+        m_current_line_index += lines.size();
+
+        DetectFileHitLayout(span.text);
+        const size_t hit_count = podioHits.size();
+        if (!ParseTextEvent(span, m_hit_layout.value_or(HitLayout::NoTruth), podioTracks, podioHits, *m_log, nullptr, time_offset)) {
             return Result::FailureFinished;
         }
 
-        // Copy data to PODIO
-        DigitizedMtpcMcTrackCollection podioTracks;
-        DigitizedMtpcMcHitCollection podioHits;
-        auto podioTrack = podioTracks.create();
-        podioTrack.phi(track.phi);
-        podioTrack.theta(track.theta);
-        podioTrack.vertexZ(track.vertexZ);
-        podioTrack.momentum(track.momentum);
-        for(auto& hit: track.hits) {
-
-            auto podioHit = podioHits.create();
-            podioHit.time(   hit.time * Acts::UnitConstants::ns  );
-            podioHit.adc(    hit.adc   );
-            podioHit.ring(   hit.ring  );
-            podioHit.pad(    hit.pad   );
-            podioHit.plane(  hit.plane );
-            podioHit.zToGem( hit.zToGem  * Acts::UnitConstants::m);
-
-            edm4hep::Vector3f true_pos = edm4hep::Vector3f{
-                static_cast<float>(hit.true_x * Acts::UnitConstants::m),
-                static_cast<float>(hit.true_y * Acts::UnitConstants::m),
-                static_cast<float>(hit.true_z * Acts::UnitConstants::m)
-            };
-            podioHit.truePosition(true_pos);
-            podioTrack.addhits(podioHit);
+        // A track without hits is not added by the parser and is skipped like an empty event
+        if (podioHits.size() == hit_count) {
+            m_log->warn("Track without hits is skipped. Near line: {}", m_current_line_index);
+            return Result::FailureTryAgain;
         }
 
-        EventInfoCollection info;
-        info.push_back(MutableEventInfo(0, 0, 0)); // event nr, timeslice nr, run nr
-        event.InsertCollection<EventInfo>(std::move(info), "EventInfo");
-        event.InsertCollection<DigitizedMtpcMcTrack>(std::move(podioTracks), "DigitizedMtpcMcTrack");
-        event.InsertCollection<DigitizedMtpcMcHit>(std::move(podioHits), "DigitizedMtpcMcHit");
         m_log->info("Event has been emitted at {}", m_event_line_index);
         return Result::Success;
     }
@@ -388,6 +999,17 @@ inline double JEventSourceGeneratorT<tdis::io::DigitizedDataEventSource>::CheckO
 
   // To determine confidence level, feel free to open up the file and check for magic bytes or metadata.
   // Returning a confidence <- {0.0, 1.0} is perfectly OK!
-    bool is_correct_ext = resource_name.ends_with("txt");
-    return  is_correct_ext? 1.0 : 0.0;
+    // Live digitizer output
+    if (tdis::io::IsStreamResource(resource_name)) {
+        return 1.0;
+    }
+
+    // Compressed text files are read directly
+    bool is_correct_ext = tdis::io::StripCompressionExtension(resource_name).ends_with("txt");
+    if (!is_correct_ext) {
+        return 0.0;
+    }
+
+    // If there is up-to-date binary cache next to the file, let DigitizedBinaryEventSource read it
+    return tdis::io::IsBinaryCacheFresh(resource_name) ? 0.5 : 1.0;
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Parses raw event text cut by DigitizedDataEventSource (io:parallel_parse=true) to PODIO collections.
+ *
+ *  JANA serializes Emit of an event source, but runs factories in parallel worker threads. So the source only
+ *  finds event boundaries in the memory mapped file, while tokenizing and number conversion happen here.
+ *  The output collections have the same names as the source produces in the serial mode, so downstream
+ *  factories don't depend on the mode.
+ **/
+
+#pragma once
+
+#include <JANA/Components/JOmniFactory.h>
+#include <spdlog/spdlog.h>
+
+#include "io/DigitizedDataEventSource.hpp"
+#include "podio_model/DigitizedMtpcMcHitCollection.h"
+#include "podio_model/DigitizedMtpcMcTrackCollection.h"
+#include "services/LogService.hpp"
+
+namespace tdis::io {
+
+    struct DigitizedTextEventFactory : public JOmniFactory<DigitizedTextEventFactory> {
+        Input<DigitizedTextEvent> m_text_events_in {this, {"DigitizedTextEvent"}};
+        PodioOutput<tdis::DigitizedMtpcMcTrack> m_tracks_out {this, "DigitizedMtpcMcTrack"};
+        PodioOutput<tdis::DigitizedMtpcMcHit> m_hits_out {this, "DigitizedMtpcMcHit"};
+        Service<services::LogService> m_service_log{this};
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        void Configure() {
+            m_log = m_service_log->logger("io:text_parser");
+        }
+
+        void ChangeRun(int32_t /*run_nr*/) {
+        }
+
+        void Execute(int32_t /*run_nr*/, uint64_t /*evt_nr*/) {
+            auto tracks = std::make_unique<DigitizedMtpcMcTrackCollection>();
+            auto hits = std::make_unique<DigitizedMtpcMcHitCollection>();
+
+            for (const auto* text_event: m_text_events_in()) {
+                if (!ParseTextEvent(text_event->span, text_event->hit_layout, *tracks, *hits, *m_log, nullptr, text_event->time_offset)) {
+                    m_log->warn("Event {} at line {} is not parsed", text_event->span.file_event_number, text_event->span.line_index);
+                }
+            }
+
+            m_tracks_out() = std::move(tracks);
+            m_hits_out() = std::move(hits);
+        }
+    };
+}   // namespace tdis::io
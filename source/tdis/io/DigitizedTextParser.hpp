@@ -0,0 +1,418 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Allocation free parsing of TDIS digitized text format (see DigitizedDataEventSource.hpp for the format)
+ *
+ *  Everything here works on std::string_view pointing into a buffer which is owned by somebody else
+ *  (memory mapped file, decompressed block, etc.). Numbers are converted with std::from_chars,
+ *  which doesn't allocate and doesn't depend on locale.
+ *
+ *  This header intentionally doesn't depend on JANA or PODIO, so it may be used in tests and benchmarks
+ **/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace tdis::io {
+
+    /** POD structure for readout hits **/
+    struct DigitizedReadoutHit {
+        double time;     // - Time of arrival at Pad (ns)
+        double adc;      // - Amplitude (ADC bin of sample)
+        int ring;        // - Ring (id of rin, 0 is innermost).
+        int pad;         // - Pad (id of pad, 0 is at or closest to phi=0 and numbering is clockwise).
+        int plane;       // - Plane(id of z plane from 0 upstream  to 9 downstream)
+        double zToGem;   // - ZtoGEM (m)
+        double true_x;   // - True hit x info (quiet_NaN() if not provided)
+        double true_y;   // - True hit y info (quiet_NaN() if not provided)
+        double true_z;   // - True hit z info (quiet_NaN() if not provided)
+    };
+
+    /** POD structure for readout track **/
+    struct DigitizedReadoutTrack {
+        double momentum;    // (GeV/c)
+        double theta;       // (degrees)
+        double phi;         // (degrees)
+        double vertexZ;     // (m)
+        std::vector<DigitizedReadoutHit> hits;
+    };
+
+    /// Number of columns in hit line of files without true X Y Z
+    constexpr size_t kHitColumnsNoTruth = 6;
+
+    /// Number of columns in hit line of files with true X Y Z
+    constexpr size_t kHitColumnsWithTruth = 9;
+
+    /// Number of columns in track header line
+    constexpr size_t kTrackHeaderColumns = 4;
+
+    /// Max number of tokens we ever need to look at in one line
+    constexpr size_t kMaxLineTokens = kHitColumnsWithTruth;
+
+    /// Fixed size token storage, so tokenizing a line doesn't allocate
+    using LineTokens = std::array<std::string_view, kMaxLineTokens>;
+
+    /// Whitespace as std::isspace in "C" locale, but without function call and locale lookup
+    constexpr bool IsDataSpace(const char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    /** Splits line to whitespace separated tokens. Only first tokens.size() tokens are stored,
+     *  but the returned value is the total number of tokens in the line */
+    inline size_t TokenizeDataLine(std::string_view line, LineTokens& tokens) {
+        const char* str = line.data();
+        const char* end = str + line.size();
+        size_t count = 0;
+
+        while (str < end) {
+            // Skip leading whitespace
+            while (str < end && IsDataSpace(*str)) {
+                ++str;
+            }
+
+            if (str >= end) break;
+
+            // Start of the token
+            const char* token_start = str;
+
+            // Find the end of the token
+            while (str < end && !IsDataSpace(*str)) {
+                ++str;
+            }
+
+            if (count < tokens.size()) {
+                tokens[count] = std::string_view(token_start, static_cast<size_t>(str - token_start));
+            }
+            count++;
+        }
+        return count;
+    }
+
+    /// Converts whole token to a number. Returns false if token is not a number or has trailing symbols
+    template <typename T>
+    inline bool ParseNumber(std::string_view token, T& value) {
+        const char* begin = token.data();
+        const char* end = begin + token.size();
+        auto [ptr, ec] = std::from_chars(begin, end, value);
+        return ec == std::errc() && ptr == end;
+    }
+
+    /// Takes the next line (without '\n' and '\r') from text and advances text past it
+    inline std::string_view NextLine(std::string_view& text) {
+        const auto line_end = text.find('\n');
+        std::string_view line;
+        if (line_end == std::string_view::npos) {
+            line = text;
+            text = {};
+        } else {
+            line = text.substr(0, line_end);
+            text.remove_prefix(line_end + 1);
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+
+    /// Each event starts with a line "Event <event number>"
+    constexpr bool IsEventHeaderLine(std::string_view line) {
+        return line.starts_with("Event");
+    }
+
+    /// Parses 4 tokens of track line: momentum, theta, phi, vertexZ
+    inline bool ParseTrackHeaderTokens(const LineTokens& tokens, const size_t count, DigitizedReadoutTrack& result) {
+        if (count < kTrackHeaderColumns) {
+            return false;
+        }
+
+        return ParseNumber(tokens[0], result.momentum)  // (GeV/c)
+            && ParseNumber(tokens[1], result.theta)     // (degrees)
+            && ParseNumber(tokens[2], result.phi)       // (degrees)
+            && ParseNumber(tokens[3], result.vertexZ);  // (m)
+    }
+
+    /** Parses tokens of a hit line detecting its layout by the number of tokens (see ParseHitLine for known layout)
+     *   6 columns: time adc ring pad plane zToGem
+     *   9 columns: time adc trueX trueY trueZ ring pad plane zToGem */
+    inline bool ParseTrackHitTokens(const LineTokens& tokens, const size_t count, DigitizedReadoutHit& result) {
+        if (count < kHitColumnsNoTruth) {
+            return false;
+        }
+
+        if (count == kHitColumnsNoTruth) {
+            // Files with no true X Y Z hit info
+            result.true_x = std::numeric_limits<double>::quiet_NaN();
+            result.true_y = std::numeric_limits<double>::quiet_NaN();
+            result.true_z = std::numeric_limits<double>::quiet_NaN();
+
+            return ParseNumber(tokens[0], result.time)      // - Time of arrival at Pad (ns)
+                && ParseNumber(tokens[1], result.adc)       // - Amplitude (ADC bin of sample)
+                && ParseNumber(tokens[2], result.ring)      // - Ring (id of rin, 0 is innermost).
+                && ParseNumber(tokens[3], result.pad)       // - Pad (id of pad, 0 is at or closest to phi=0 ...)
+                && ParseNumber(tokens[4], result.plane)     // - Plane(id of z plane from 0 upstream  to 9 downstream)
+                && ParseNumber(tokens[5], result.zToGem);   // - ZtoGEM (m)
+        }
+
+        if (count < kHitColumnsWithTruth) {
+            return false;
+        }
+
+        return ParseNumber(tokens[0], result.time)          // - Time of arrival at Pad (ns)
+            && ParseNumber(tokens[1], result.adc)           // - Amplitude (ADC bin of sample)
+            && ParseNumber(tokens[2], result.true_x)        // True X Y Z of hit
+            && ParseNumber(tokens[3], result.true_y)
+            && ParseNumber(tokens[4], result.true_z)
+            && ParseNumber(tokens[5], result.ring)          // - Ring (id of rin, 0 is innermost).
+            && ParseNumber(tokens[6], result.pad)           // - Pad (id of pad, 0 is at or closest to phi=0 ...)
+            && ParseNumber(tokens[7], result.plane)         // - Plane(id of z plane from 0 upstream  to 9 downstream)
+            && ParseNumber(tokens[8], result.zToGem);       // - ZtoGEM (m)
+    }
+
+
+    /// Hit line layout. It is the same for all hit lines of a file, so it is detected once per file
+    enum class HitLayout {
+        NoTruth,    // time adc ring pad plane zToGem
+        WithTruth   // time adc trueX trueY trueZ ring pad plane zToGem
+    };
+
+    /** Hit values of a known layout. Hits of files without truth have no storage for true X Y Z */
+    template <HitLayout Layout>
+    struct LayoutHit {
+        static constexpr size_t kColumns = kHitColumnsNoTruth;
+        double time;     // - Time of arrival at Pad (ns)
+        double adc;      // - Amplitude (ADC bin of sample)
+        int ring;        // - Ring (id of rin, 0 is innermost).
+        int pad;         // - Pad (id of pad, 0 is at or closest to phi=0 and numbering is clockwise).
+        int plane;       // - Plane(id of z plane from 0 upstream  to 9 downstream)
+        double zToGem;   // - ZtoGEM (m)
+    };
+
+    template <>
+    struct LayoutHit<HitLayout::WithTruth> {
+        static constexpr size_t kColumns = kHitColumnsWithTruth;
+        double time;     // - Time of arrival at Pad (ns)
+        double adc;      // - Amplitude (ADC bin of sample)
+        int ring;        // - Ring (id of rin, 0 is innermost).
+        int pad;         // - Pad (id of pad, 0 is at or closest to phi=0 and numbering is clockwise).
+        int plane;       // - Plane(id of z plane from 0 upstream  to 9 downstream)
+        double zToGem;   // - ZtoGEM (m)
+        double true_x;   // - True hit x info (m)
+        double true_y;   // - True hit y info (m)
+        double true_z;   // - True hit z info (m)
+    };
+
+    /// True if the line has only whitespace
+    constexpr bool IsBlankLine(std::string_view line) {
+        return std::all_of(line.begin(), line.end(), IsDataSpace);
+    }
+
+    /// Converts the next whitespace separated number starting at pos and moves pos past it
+    template <typename T>
+    inline bool ParseNextNumber(const char*& pos, const char* end, T& value) {
+        while (pos < end && IsDataSpace(*pos)) {
+            ++pos;
+        }
+        auto [ptr, ec] = std::from_chars(pos, end, value);
+        if (ec != std::errc() || (ptr < end && !IsDataSpace(*ptr))) {
+            return false;
+        }
+        pos = ptr;
+        return true;
+    }
+
+    /** Parses a hit line of the given layout in one pass over the line, without tokenizing and without
+     *  checking the column count. Columns after the layout ones are ignored */
+    template <HitLayout Layout>
+    inline bool ParseHitLine(std::string_view line, LayoutHit<Layout>& hit) {
+        const char* pos = line.data();
+        const char* end = pos + line.size();
+
+        if (!ParseNextNumber(pos, end, hit.time) || !ParseNextNumber(pos, end, hit.adc)) {
+            return false;
+        }
+        if constexpr (Layout == HitLayout::WithTruth) {
+            if (!ParseNextNumber(pos, end, hit.true_x) || !ParseNextNumber(pos, end, hit.true_y) || !ParseNextNumber(pos, end, hit.true_z)) {
+                return false;
+            }
+        }
+        return ParseNextNumber(pos, end, hit.ring)
+            && ParseNextNumber(pos, end, hit.pad)
+            && ParseNextNumber(pos, end, hit.plane)
+            && ParseNextNumber(pos, end, hit.zToGem);
+    }
+
+    /** Detects hit layout by the first hit line of event text (track header line followed by hit lines).
+     *  Returns false if the event has no hit lines */
+    inline bool DetectHitLayout(std::string_view event_text, HitLayout& layout) {
+        NextLine(event_text);   // Track header
+        LineTokens tokens;
+        while (!event_text.empty()) {
+            auto count = TokenizeDataLine(NextLine(event_text), tokens);
+            if (count == 0) {
+                continue;
+            }
+            layout = count >= kHitColumnsWithTruth ? HitLayout::WithTruth : HitLayout::NoTruth;
+            return true;
+        }
+        return false;
+    }
+
+
+    /** Text of one event as it is in the input buffer (no copies) */
+    struct TextEventSpan {
+        std::string_view text;              // Track header line followed by hit lines. "Event" line is not included
+        uint64_t file_event_number = 0;     // Number after "Event" word in the file
+        size_t offset = 0;                  // Byte offset of "Event" line in the buffer
+        size_t line_index = 0;              // Line index of "Event" line in the buffer
+    };
+
+    /** Cuts a text buffer to per-event spans
+     *  Events are searched by "Event" word at the beginning of a line. Everything before the first
+     *  "Event" line is skipped */
+    class TextEventCursor {
+    public:
+        TextEventCursor() = default;
+
+        explicit TextEventCursor(std::string_view text) { Reset(text); }
+
+        /// Starts (over) iterating the buffer from the given position
+        void Reset(std::string_view text, size_t offset = 0, size_t line_index = 0) {
+            m_text = text;
+            m_pos = std::min(offset, text.size());
+            m_line_index = line_index;
+        }
+
+        /// Fills span with the next event. Returns false if there are no more events
+        bool Next(TextEventSpan& span);
+
+        /// Current position in the buffer
+        size_t Offset() const { return m_pos; }
+
+        /// Line index at the current position
+        size_t LineIndex() const { return m_line_index; }
+
+    private:
+        /// Finds the beginning of the next line starting with "Event" at or after pos. Returns text size if not found
+        size_t FindEventHeader(size_t pos) const;
+
+        std::string_view m_text;
+        size_t m_pos = 0;
+        size_t m_line_index = 0;
+    };
+
+
+    inline size_t TextEventCursor::FindEventHeader(size_t pos) const {
+        if (pos == 0 && IsEventHeaderLine(m_text)) {
+            return 0;
+        }
+
+        // "\nEvent" search is done by the standard library (memchr under the hood)
+        // which is much faster than looking at each line
+        const auto found = m_text.find("\nEvent", pos == 0 ? 0 : pos - 1);
+        return found == std::string_view::npos ? m_text.size() : found + 1;
+    }
+
+    inline bool TextEventCursor::Next(TextEventSpan& span) {
+        const size_t header_pos = FindEventHeader(m_pos);
+        if (header_pos >= m_text.size()) {
+            m_line_index += static_cast<size_t>(std::count(m_text.begin() + m_pos, m_text.end(), '\n'));
+            m_pos = m_text.size();
+            return false;
+        }
+
+        // Lines that were skipped before the header (normally none)
+        m_line_index += static_cast<size_t>(std::count(m_text.begin() + m_pos, m_text.begin() + header_pos, '\n'));
+
+        // "Event <number>" line
+        std::string_view rest = m_text.substr(header_pos);
+        std::string_view header_line = NextLine(rest);
+        LineTokens tokens;
+        auto count = TokenizeDataLine(header_line, tokens);
+        span.file_event_number = 0;
+        if (count >= 2) {
+            ParseNumber(tokens[1], span.file_event_number);
+        }
+
+        const size_t body_pos = m_text.size() - rest.size();
+        const size_t next_header_pos = FindEventHeader(body_pos);
+
+        span.text = m_text.substr(body_pos, next_header_pos - body_pos);
+        span.offset = header_pos;
+        span.line_index = m_line_index;
+
+        m_line_index += 1 + static_cast<size_t>(std::count(span.text.begin(), span.text.end(), '\n'));
+        m_pos = next_header_pos;
+        return true;
+    }
+
+
+    /// Splits line to whitespace separated tokens (std::getline path, io:use_mmap=false)
+    inline std::vector<std::string> SplitDataString(const std::string& line) {
+        std::vector<std::string> tokens;
+        const char* str = line.data();
+        const char* end = str + line.size();
+
+        while (str < end) {
+            // Skip leading whitespace
+            while (str < end && std::isspace(static_cast<unsigned char>(*str))) {
+                ++str;
+            }
+
+            if (str >= end) break;
+
+            // Start of the token
+            const char* token_start = str;
+
+            // Find the end of the token
+            while (str < end && !std::isspace(static_cast<unsigned char>(*str))) {
+                ++str;
+            }
+
+            // Extract the token and add it to the vector
+            tokens.emplace_back(token_start, str - token_start);
+        }
+
+        return tokens;
+    }
+
+
+    /// Reads lines of the next event with std::getline. "Event" line is not included
+    inline std::vector<std::string> ReadNextEventLines(std::ifstream& input_file) {
+        std::vector<std::string> lines;
+
+        while (true) {
+            if (!input_file) {
+                return lines;
+            }
+
+            // Read the file line by line
+            std::string line;
+            std::getline(input_file, line);
+
+            if (line.starts_with("Event")) {
+                if (lines.empty()) {
+                    // This probably means the beginning of file, the first event
+                    continue;
+                }
+                // This means we read till the next events
+                return lines;
+            }
+
+            lines.emplace_back(line);
+        }
+    }
+
+}   // namespace tdis::io
@@ -0,0 +1,98 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Splits timeslices emitted by digitized sources (io:timeslice_events > 0) into physics events.
+ *
+ *  Each child physics event gets the same collections as sources give in the physics event mode:
+ *  EventInfo and DigitizedMtpcMcTrack/DigitizedMtpcMcHit copied from the timeslice collections,
+ *  or DigitizedTextEvent objects with io:parallel_parse, which DigitizedTextEventFactory then parses
+ *  in parallel. So reconstruction factories work the same in both modes.
+ **/
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JEvent.h>
+#include <JANA/JEventUnfolder.h>
+#include <spdlog/spdlog.h>
+
+#include "io/DigitizedDataEventSource.hpp"
+#include "podio_model/DigitizedMtpcMcHitCollection.h"
+#include "podio_model/DigitizedMtpcMcTrackCollection.h"
+#include "podio_model/EventInfoCollection.h"
+#include "services/LogService.hpp"
+
+namespace tdis::io {
+
+    class DigitizedTimesliceUnfolder : public JEventUnfolder {
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+    public:
+        DigitizedTimesliceUnfolder() {
+            SetTypeName(NAME_OF_THIS);
+            SetParentLevel(JEventLevel::Timeslice);
+            SetChildLevel(JEventLevel::PhysicsEvent);
+        }
+
+        void Init() override {
+            m_log = GetApplication()->GetService<tdis::services::LogService>()->logger("DigitizedTimesliceUnfolder");
+        }
+
+        Result Unfold(const JEvent& parent, JEvent& child, int child_idx) override;
+    };
+
+
+    inline JEventUnfolder::Result DigitizedTimesliceUnfolder::Unfold(const JEvent& parent, JEvent& child, int child_idx) {
+        auto timeslice = parent.GetSingle<DigitizedTimeslice>("DigitizedTimeslice");
+        const auto& entry = timeslice->events.at(static_cast<size_t>(child_idx));
+
+        child.SetEventNumber(entry.event_number);
+        child.SetRunNumber(timeslice->run_number);
+
+        EventInfoCollection info;
+        info.push_back(MutableEventInfo(entry.event_number, timeslice->timeslice_number, timeslice->run_number)); // event nr, timeslice nr, run nr
+        child.InsertCollection<EventInfo>(std::move(info), "EventInfo");
+
+        if (timeslice->has_text_events) {
+            // Only text spans are passed, parsing happens in physics event factories
+            auto ts_text_events = parent.Get<DigitizedTextEvent>("TsDigitizedTextEvent");
+            std::vector<DigitizedTextEvent*> text_events;
+            for (uint32_t i = entry.first_track; i < entry.first_track + entry.track_count; i++) {
+                text_events.push_back(new DigitizedTextEvent(*ts_text_events.at(i)));
+            }
+            child.Insert(text_events, "DigitizedTextEvent");
+        } else {
+            // PODIO objects belong to one collection (and frame), so tracks and hits are copied
+            auto ts_tracks = parent.GetCollection<DigitizedMtpcMcTrack>("TsDigitizedMtpcMcTrack");
+            DigitizedMtpcMcTrackCollection tracks;
+            DigitizedMtpcMcHitCollection hits;
+            for (uint32_t i = entry.first_track; i < entry.first_track + entry.track_count; i++) {
+                const auto ts_track = (*ts_tracks)[i];
+                auto track = tracks.create();
+                track.momentum(ts_track.momentum());
+                track.theta(ts_track.theta());
+                track.phi(ts_track.phi());
+                track.vertexZ(ts_track.vertexZ());
+                for (const auto& ts_hit: ts_track.hits()) {
+                    auto hit = hits.create();
+                    hit.time(ts_hit.time());
+                    hit.adc(ts_hit.adc());
+                    hit.ring(ts_hit.ring());
+                    hit.pad(ts_hit.pad());
+                    hit.plane(ts_hit.plane());
+                    hit.zToGem(ts_hit.zToGem());
+                    hit.truePosition(ts_hit.truePosition());
+                    track.addhits(hit);
+                }
+            }
+            child.InsertCollection<DigitizedMtpcMcTrack>(std::move(tracks), "DigitizedMtpcMcTrack");
+            child.InsertCollection<DigitizedMtpcMcHit>(std::move(hits), "DigitizedMtpcMcHit");
+        }
+
+        m_log->trace("Timeslice {}: unfolded event {}", timeslice->timeslice_number, entry.event_number);
+        const bool is_last = static_cast<size_t>(child_idx) + 1 >= timeslice->events.size();
+        return is_last ? Result::NextChildNextParent : Result::NextChildKeepParent;
+    }
+}   // namespace tdis::io
@@ -0,0 +1,151 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Event offset index of a digitized text file: byte position (and line index) of every "Event <n>" header.
+ *
+ *  The index is built by a fast pre-scan of the (memory mapped) file, which only looks at "Event" lines,
+ *  or is loaded from a sidecar file "<input file>.idx" written next to the input by an earlier run.
+ *  With the index, an event source may seek straight to event N instead of parsing everything before it.
+ *
+ *  Sidecar binary layout (little endian, as written by the machine):
+ *      char[8]   magic "TDISIDX1"
+ *      uint64_t  size of indexed file in bytes
+ *      int64_t   modification time of indexed file (ns since epoch)
+ *      uint64_t  number of entries
+ *      Entry[]   entries
+ *  Sidecar is ignored if file size or modification time don't match the input file
+ **/
+
+#pragma once
+
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "io/DigitizedTextParser.hpp"
+#include "io/MappedFile.hpp"
+
+namespace tdis::io {
+
+    class EventOffsetIndex {
+    public:
+        struct Entry {
+            uint64_t offset;            // Byte offset of "Event" line
+            uint64_t line_index;        // Line index of "Event" line
+            uint64_t file_event_number; // Number after "Event" word
+        };
+
+        /// Builds the index scanning "Event" lines of the text
+        static EventOffsetIndex Build(std::string_view text);
+
+        /// Sidecar file name for the input file
+        static std::string SidecarPath(const std::string& file_path) { return file_path + ".idx"; }
+
+        /// Loads sidecar index for file_path. Returns false if there is no sidecar or it is outdated
+        bool Load(const std::string& file_path);
+
+        /// Writes sidecar index for file_path. Returns false if it can't be written (e.g. read only directory)
+        bool Save(const std::string& file_path) const;
+
+        size_t Size() const { return m_entries.size(); }
+
+        bool Empty() const { return m_entries.empty(); }
+
+        const Entry& operator[](size_t index) const { return m_entries[index]; }
+
+        const std::vector<Entry>& Entries() const { return m_entries; }
+
+    private:
+        static constexpr std::array<char, 8> kMagic = {'T', 'D', 'I', 'S', 'I', 'D', 'X', '1'};
+
+        std::vector<Entry> m_entries;
+    };
+
+
+    inline EventOffsetIndex EventOffsetIndex::Build(std::string_view text) {
+        EventOffsetIndex index;
+        TextEventCursor cursor(text);
+        TextEventSpan span;
+        while (cursor.Next(span)) {
+            index.m_entries.push_back({span.offset, span.line_index, span.file_event_number});
+        }
+        return index;
+    }
+
+    inline bool EventOffsetIndex::Load(const std::string& file_path) {
+        m_entries.clear();
+
+        FileStamp file_stamp;
+        if (!FileStamp::Read(file_path, file_stamp)) {
+            return false;
+        }
+
+        std::ifstream input(SidecarPath(file_path), std::ios::binary);
+        if (!input) {
+            return false;
+        }
+
+        std::array<char, 8> magic{};
+        FileStamp indexed_stamp;
+        uint64_t count = 0;
+        input.read(magic.data(), magic.size());
+        input.read(reinterpret_cast<char*>(&indexed_stamp.size), sizeof(indexed_stamp.size));
+        input.read(reinterpret_cast<char*>(&indexed_stamp.mtime_ns), sizeof(indexed_stamp.mtime_ns));
+        input.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!input || magic != kMagic || indexed_stamp != file_stamp) {
+            return false;
+        }
+
+        m_entries.resize(count);
+        input.read(reinterpret_cast<char*>(m_entries.data()), static_cast<std::streamsize>(count * sizeof(Entry)));
+        if (!input) {
+            m_entries.clear();
+            return false;
+        }
+        return true;
+    }
+
+    inline bool EventOffsetIndex::Save(const std::string& file_path) const {
+        FileStamp file_stamp;
+        if (!FileStamp::Read(file_path, file_stamp)) {
+            return false;
+        }
+
+        // Several farm jobs may index the same file at once. Write to a temporary file and rename,
+        // so readers see either the complete sidecar or none
+        auto sidecar_path = SidecarPath(file_path);
+        auto tmp_path = sidecar_path + ".tmp." + std::to_string(::getpid());
+        {
+            std::ofstream output(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!output) {
+                return false;
+            }
+
+            uint64_t count = m_entries.size();
+            output.write(kMagic.data(), kMagic.size());
+            output.write(reinterpret_cast<const char*>(&file_stamp.size), sizeof(file_stamp.size));
+            output.write(reinterpret_cast<const char*>(&file_stamp.mtime_ns), sizeof(file_stamp.mtime_ns));
+            output.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            output.write(reinterpret_cast<const char*>(m_entries.data()), static_cast<std::streamsize>(count * sizeof(Entry)));
+            if (!output) {
+                output.close();
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(tmp_path.c_str(), sidecar_path.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+}   // namespace tdis::io
@@ -0,0 +1,402 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  EventSource which generates proton tracks in memory instead of reading digitized files.
+ *  Made for load and scaling tests of any size and for checking fit quality with known truth.
+ *
+ *  Resource name is "generator://helix" (anything may follow, e.g. "generator://helix/2",
+ *  so several generator sources get different input file indexes, event numbers and random sequences).
+ *
+ *  Each track starts at the beam line (x = y = 0, z = vertexZ) with uniformly sampled momentum, theta, phi
+ *  and vertexZ and follows a helix in the uniform field gen:bz. For each ring the hit is where the helix
+ *  crosses the ring center radius, pad is found from its phi with PadGeometryHelper.hpp constants.
+ *  Plane and ZtoGEM come from the readout disk positions of ActsGeometryService: planes go in pairs sharing
+ *  a cathode in the middle, even planes drift to upstream readout, odd planes to downstream one.
+ *  Time is the drift time to the readout. The true position is the exact helix point.
+ *  Output is the same DigitizedMtpcMcTrack/DigitizedMtpcMcHit (and EventInfo) as digitized file sources give.
+ *
+ *  Configuration Parameters
+ *    - gen:events (uint64, default 10000):        Number of physics events to generate. 0 - no limit
+ *    - gen:tracks (double, default 1):            Mean number of tracks in one event
+ *    - gen:tracks_poisson (bool, default false):  Poisson distributed number of tracks (at least 1) instead of exactly round(gen:tracks)
+ *    - gen:time_window (double, default 0):       Additional tracks get time offsets uniformly distributed in [-window/2, window/2] (ns)
+ *    - gen:seed (uint64, default 1):              Random seed. The same seed gives the same events
+ *    - gen:momentum_min, gen:momentum_max (double, default 0.2, 1.0):   Momentum range (GeV/c)
+ *    - gen:theta_min, gen:theta_max (double, default 45, 135):          Polar angle range (degrees)
+ *    - gen:phi_min, gen:phi_max (double, default -180, 180):            Azimuthal angle range (degrees)
+ *    - gen:vertex_z_min, gen:vertex_z_max (double, default -0.25, 0.25): Vertex Z range (m)
+ *    - gen:bz (double, default 1.5):              Magnetic field in Z (Tesla). Should match KalmanFitterGenerator:bz
+ *    - gen:drift_velocity (double, default 0.032): Drift velocity (mm/ns) to get hit time from ZtoGEM
+ *    - gen:adc_mean (double, default 5e-8):       Mean amplitude for a minimum ionizing track, scaled by 1/beta^2
+ *    - io:timeslice_events (uint64, default 0):   Emit timeslices of this many physics events (see DigitizedTimesliceUnfolder)
+ **/
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JEvent.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JEventSourceGeneratorT.h>
+#include <JANA/JException.h>
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include <Acts/Definitions/Units.hpp>
+#include <cmath>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "PadGeometryHelper.hpp"
+#include "io/DigitizedDataEventSource.hpp"
+#include "io/DigitizedTextParser.hpp"
+#include "io/PileupMixer.hpp"
+#include "podio_model/DigitizedMtpcMcHitCollection.h"
+#include "podio_model/DigitizedMtpcMcTrackCollection.h"
+#include "podio_model/EventInfoCollection.h"
+#include "podio_model/TimesliceInfoCollection.h"
+#include "services/InputFilesService.hpp"
+#include "services/LogService.hpp"
+#include "tracking/ActsGeometryService.h"
+
+namespace tdis::io {
+
+    inline constexpr std::string_view kHelixGeneratorScheme = "generator://helix";
+
+    /** Samples tracks and makes their digitized hits. Doesn't depend on JANA, units are as in digitized files */
+    class HelixTrackGenerator {
+    public:
+        struct Config {
+            double momentum_min = 0.2;      // GeV/c
+            double momentum_max = 1.0;      // GeV/c
+            double theta_min = 45;          // degrees
+            double theta_max = 135;         // degrees
+            double phi_min = -180;          // degrees
+            double phi_max = 180;           // degrees
+            double vertex_z_min = -0.25;    // m
+            double vertex_z_max = 0.25;     // m
+            double bz = 1.5;                // T
+            double drift_velocity = 0.032;  // mm/ns
+            double adc_mean = 5e-8;
+        };
+
+        /// plane_positions - Z of readout disks (mm) from upstream to downstream, going in pairs
+        void Configure(const Config& config, std::vector<double> plane_positions, uint64_t seed);
+
+        /// Fills track with sampled parameters and its hits (the hits vector is reused)
+        void Generate(DigitizedReadoutTrack& track);
+
+        /// Finds plane and distance to its readout (mm) for z (mm). Returns false if z is outside of the planes
+        bool FindPlane(double z, int& plane, double& z_to_gem) const;
+
+        /// Pad index of the ring at azimuthal angle phi (radians)
+        static int FindPad(int ring, double phi);
+
+    private:
+        Config m_cfg;
+        std::vector<double> m_plane_positions;
+        std::mt19937_64 m_generator;
+        std::uniform_real_distribution<double> m_uniform{0, 1};
+        std::gamma_distribution<double> m_adc_fluctuation{4.0, 0.25};   // mean 1
+    };
+
+
+    /** Generator EventSource, see the description at the top of the file */
+    class HelixGeneratorEventSource : public JEventSource {
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        HelixTrackGenerator::Config m_cfg_generator;
+        HelixTrackGenerator m_generator;
+        DigitizedReadoutTrack m_track;
+
+        uint64_t m_cfg_events = 10000;
+        uint64_t m_emitted_events = 0;
+
+        /// Number of tracks in event and their time offsets
+        PileupMixer::Config m_cfg_multiplicity{1, false, 0, 1};
+        PileupMixer m_multiplicity;
+
+        /// Deterministic event numbers and run number (see InputFilesService)
+        std::shared_ptr<services::InputFilesService> m_input_files;
+        size_t m_file_index = 0;
+        int32_t m_run_number = 0;
+
+        uint64_t m_cfg_timeslice_events = 0;
+        uint64_t m_emitted_timeslices = 0;
+
+    public:
+        HelixGeneratorEventSource();
+
+        HelixGeneratorEventSource(std::string resource_name, JApplication* app);
+
+        ~HelixGeneratorEventSource() override = default;
+
+        void Init() override;
+
+        void Open() override;
+
+        Result Emit(JEvent&) override;
+
+        static std::string GetDescription();
+
+    private:
+        /// Generates tracks of the next physics event. Returns number of tracks
+        size_t GeneratePhysicsEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits);
+    };
+
+
+    // Implementation section starts here
+
+    inline void HelixTrackGenerator::Configure(const Config& config, std::vector<double> plane_positions, uint64_t seed) {
+        m_cfg = config;
+        m_plane_positions = std::move(plane_positions);
+        m_generator.seed(seed);
+    }
+
+    inline bool HelixTrackGenerator::FindPlane(double z, int& plane, double& z_to_gem) const {
+        // Planes (2k, 2k+1) are one TPC volume with the cathode in the middle
+        for (size_t even = 0; even + 1 < m_plane_positions.size(); even += 2) {
+            const double upstream = m_plane_positions[even];
+            const double downstream = m_plane_positions[even + 1];
+            if (z < upstream || z > downstream) {
+                continue;
+            }
+            const double cathode = (upstream + downstream) / 2;
+            plane = static_cast<int>(z < cathode ? even : even + 1);
+            z_to_gem = z < cathode ? z - upstream : downstream - z;
+            return true;
+        }
+        return false;
+    }
+
+    inline int HelixTrackGenerator::FindPad(int ring, double phi) {
+        // Inverse of getPadCenter: odd rings are rotated by half of a pad
+        const double offset = (ring % 2 == 0) ? 0.0 : delta_theta / 2.0;
+        double angle = std::fmod(phi - offset, 2 * M_PI);
+        if (angle < 0) {
+            angle += 2 * M_PI;
+        }
+        const int pad = static_cast<int>(angle / delta_theta);
+        return pad < num_pads_per_ring ? pad : num_pads_per_ring - 1;
+    }
+
+    inline void HelixTrackGenerator::Generate(DigitizedReadoutTrack& track) {
+        using namespace Acts::UnitLiterals;
+        auto sample = [this](double min, double max) { return min + (max - min) * m_uniform(m_generator); };
+
+        track.momentum = sample(m_cfg.momentum_min, m_cfg.momentum_max);
+        track.theta = sample(m_cfg.theta_min, m_cfg.theta_max);
+        track.phi = sample(m_cfg.phi_min, m_cfg.phi_max);
+        track.vertexZ = sample(m_cfg.vertex_z_min, m_cfg.vertex_z_max);
+        track.hits.clear();
+
+        // Helix of a proton (charge +1) from the beam line. Acts units: mm, GeV, T
+        constexpr double proton_mass = 0.93827;
+        const double theta = track.theta * M_PI / 180;
+        const double phi = track.phi * M_PI / 180;
+        const double vertex_z = track.vertexZ * 1_m;
+        const double pt = track.momentum * std::sin(theta);
+        const double cot_theta = std::cos(theta) / std::sin(theta);
+        const bool is_straight = std::abs(m_cfg.bz) < 1e-9;
+        const double radius = is_straight ? 0 : pt * 1_GeV / (std::abs(m_cfg.bz) * 1_T);
+        const double rotation = m_cfg.bz > 0 ? -1 : 1;      // positive charge turns clockwise in +Z field
+
+        const double beta2 = track.momentum * track.momentum / (track.momentum * track.momentum + proton_mass * proton_mass);
+
+        for (int ring = 0; ring < num_rings; ring++) {
+            const double ring_radius = getRingCenterRadius(ring);
+
+            // The helix circle goes through the origin, the chord to the crossing point is the ring radius
+            double transverse_path = ring_radius;
+            double hit_phi = phi;
+            if (!is_straight) {
+                if (ring_radius > 2 * radius) {
+                    break;      // curls before this ring
+                }
+                const double half_turn = std::asin(ring_radius / (2 * radius));
+                transverse_path = 2 * radius * half_turn;
+                hit_phi = phi + rotation * half_turn;
+            }
+
+            const double z = vertex_z + transverse_path * cot_theta;
+            int plane = 0;
+            double z_to_gem = 0;
+            if (!FindPlane(z, plane, z_to_gem)) {
+                continue;
+            }
+
+            const double x = ring_radius * std::cos(hit_phi);
+            const double y = ring_radius * std::sin(hit_phi);
+            track.hits.push_back(DigitizedReadoutHit{
+                z_to_gem / m_cfg.drift_velocity,                        // ns
+                m_cfg.adc_mean / beta2 * m_adc_fluctuation(m_generator),
+                ring,
+                FindPad(ring, hit_phi),
+                plane,
+                z_to_gem / 1_m,
+                x / 1_m,
+                y / 1_m,
+                z / 1_m
+            });
+        }
+    }
+
+
+    inline HelixGeneratorEventSource::HelixGeneratorEventSource() : JEventSource() {
+        SetTypeName(NAME_OF_THIS);  // Provide JANA with class name
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+
+    inline HelixGeneratorEventSource::HelixGeneratorEventSource(std::string resource_name, JApplication* app): JEventSource(resource_name, app) {
+        SetTypeName(NAME_OF_THIS);  // Provide JANA with class name
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+
+        // JANA builds processing topology by the event level of sources before Init is called
+        app->SetDefaultParameter("io:timeslice_events", m_cfg_timeslice_events,
+            "Emit timeslices of this many physics events (split back by DigitizedTimesliceUnfolder). 0 - emit physics events");
+        SetLevel(m_cfg_timeslice_events ? JEventLevel::Timeslice : JEventLevel::PhysicsEvent);
+    }
+
+    inline void HelixGeneratorEventSource::Init() {
+        auto app = GetApplication();
+        m_log = app->GetService<tdis::services::LogService>()->logger("HelixGeneratorEventSource");
+        m_input_files = app->GetService<tdis::services::InputFilesService>();
+
+        auto& cfg = m_cfg_generator;
+        app->SetDefaultParameter("gen:events", m_cfg_events, "Number of physics events to generate. 0 - no limit");
+        app->SetDefaultParameter("gen:tracks", m_cfg_multiplicity.mean_tracks, "Mean number of generated tracks in one event");
+        app->SetDefaultParameter("gen:tracks_poisson", m_cfg_multiplicity.poisson,
+            "Poisson distributed number of tracks (true) or exactly round(gen:tracks) (false)");
+        app->SetDefaultParameter("gen:time_window", m_cfg_multiplicity.time_window,
+            "Time window [ns] for random time offsets of additional tracks in event, offsets are in [-window/2, window/2]");
+        app->SetDefaultParameter("gen:seed", m_cfg_multiplicity.seed, "Random seed of the generator");
+        app->SetDefaultParameter("gen:momentum_min", cfg.momentum_min, "Minimal track momentum [GeV/c]");
+        app->SetDefaultParameter("gen:momentum_max", cfg.momentum_max, "Maximal track momentum [GeV/c]");
+        app->SetDefaultParameter("gen:theta_min", cfg.theta_min, "Minimal track theta [deg]");
+        app->SetDefaultParameter("gen:theta_max", cfg.theta_max, "Maximal track theta [deg]");
+        app->SetDefaultParameter("gen:phi_min", cfg.phi_min, "Minimal track phi [deg]");
+        app->SetDefaultParameter("gen:phi_max", cfg.phi_max, "Maximal track phi [deg]");
+        app->SetDefaultParameter("gen:vertex_z_min", cfg.vertex_z_min, "Minimal vertex Z [m]");
+        app->SetDefaultParameter("gen:vertex_z_max", cfg.vertex_z_max, "Maximal vertex Z [m]");
+        app->SetDefaultParameter("gen:bz", cfg.bz, "Magnetic field in Z [Tesla]. Should match KalmanFitterGenerator:bz");
+        app->SetDefaultParameter("gen:drift_velocity", cfg.drift_velocity, "Drift velocity [mm/ns] to get hit time from ZtoGEM");
+        app->SetDefaultParameter("gen:adc_mean", cfg.adc_mean, "Mean hit amplitude for beta=1 track, scaled by 1/beta^2");
+
+        if (cfg.drift_velocity <= 0) {
+            throw JException("gen:drift_velocity must be > 0");
+        }
+    }
+
+    inline void HelixGeneratorEventSource::Open() {
+        auto plane_positions = GetApplication()->GetService<tdis::tracking::ActsGeometryService>()->GetPlanePositions();
+        if (plane_positions.size() < 2) {
+            auto message = fmt::format("Error: generator needs readout plane positions from geometry, got {} planes", plane_positions.size());
+            m_log->error(message);
+            throw std::runtime_error(message);
+        }
+
+        m_emitted_events = 0;
+        m_emitted_timeslices = 0;
+        m_file_index = m_input_files->GetFileIndex(this->GetResourceName());
+        m_run_number = m_input_files->GetRunNumber(this->GetResourceName());
+
+        // Different generator resources give different events with the same gen:seed
+        const uint64_t seed = m_cfg_multiplicity.seed + m_file_index;
+        m_generator.Configure(m_cfg_generator, std::move(plane_positions), seed);
+        auto multiplicity_cfg = m_cfg_multiplicity;
+        multiplicity_cfg.seed = ~seed;
+        m_multiplicity.Configure(multiplicity_cfg);
+
+        m_log->info("Generating {} events with {} tracks per event in Bz={} T as input #{}, run number {}",
+            m_cfg_events, m_cfg_multiplicity.mean_tracks, m_cfg_generator.bz, m_file_index, m_run_number);
+    }
+
+    inline JEventSource::Result HelixGeneratorEventSource::Emit(JEvent& event) {
+        // One physics event or a timeslice of io:timeslice_events physics events
+        const uint64_t events_to_read = m_cfg_timeslice_events ? m_cfg_timeslice_events : 1;
+        auto timeslice = std::make_unique<DigitizedTimeslice>();
+        DigitizedMtpcMcTrackCollection podioTracks;
+        DigitizedMtpcMcHitCollection podioHits;
+
+        while (timeslice->events.size() < events_to_read) {
+            if (m_cfg_events && m_emitted_events >= m_cfg_events) {
+                break;
+            }
+
+            const size_t first_track = podioTracks.size();
+            const size_t track_count = GeneratePhysicsEvent(podioTracks, podioHits);
+            const uint64_t event_number = m_input_files->GetGlobalEventNumber(m_file_index, m_emitted_events);
+            timeslice->events.push_back({event_number, static_cast<uint32_t>(first_track), static_cast<uint32_t>(track_count)});
+            m_emitted_events++;
+        }
+
+        if (timeslice->events.empty()) {
+            return Result::FailureFinished;
+        }
+
+        // Timeslice collections have "Ts" prefix to not be confused with physics event ones
+        const std::string prefix = m_cfg_timeslice_events ? "Ts" : "";
+        event.InsertCollection<DigitizedMtpcMcTrack>(std::move(podioTracks), prefix + "DigitizedMtpcMcTrack");
+        event.InsertCollection<DigitizedMtpcMcHit>(std::move(podioHits), prefix + "DigitizedMtpcMcHit");
+
+        if (!m_cfg_timeslice_events) {
+            const uint64_t event_number = timeslice->events.front().event_number;
+            event.SetEventNumber(event_number);
+            event.SetRunNumber(m_run_number);
+
+            EventInfoCollection info;
+            info.push_back(MutableEventInfo(event_number, 0, m_run_number)); // event nr, timeslice nr, run nr
+            event.InsertCollection<EventInfo>(std::move(info), "EventInfo");
+            m_log->debug("Event {} has been generated", event_number);
+            return Result::Success;
+        }
+
+        timeslice->timeslice_number = m_input_files->GetGlobalEventNumber(m_file_index, m_emitted_timeslices++);
+        timeslice->run_number = m_run_number;
+        event.SetEventNumber(timeslice->timeslice_number);
+        event.SetRunNumber(m_run_number);
+        m_log->debug("Timeslice {} with {} generated events has been emitted", timeslice->timeslice_number, timeslice->events.size());
+
+        TimesliceInfoCollection timeslice_info;
+        timeslice_info.push_back(MutableTimesliceInfo(timeslice->timeslice_number, m_run_number));
+        event.InsertCollection<TimesliceInfo>(std::move(timeslice_info), "TimesliceInfo");
+        event.Insert(timeslice.release(), "DigitizedTimeslice");
+        return Result::Success;
+    }
+
+    inline size_t HelixGeneratorEventSource::GeneratePhysicsEvent(DigitizedMtpcMcTrackCollection& podioTracks, DigitizedMtpcMcHitCollection& podioHits) {
+        const size_t track_count = m_multiplicity.NextMultiplicity();
+        for (size_t track_index = 0; track_index < track_count; track_index++) {
+            m_generator.Generate(m_track);
+
+            auto podioTrack = podioTracks.create();
+            podioTrack.momentum(m_track.momentum);
+            podioTrack.theta(m_track.theta);
+            podioTrack.phi(m_track.phi);
+            podioTrack.vertexZ(m_track.vertexZ);
+
+            const double time_offset = m_multiplicity.NextTimeOffset(track_index);
+            for (const auto& hit: m_track.hits) {
+                auto podioHit = podioHits.create();
+                FillPodioHit(hit, podioHit, time_offset);
+                podioTrack.addhits(podioHit);
+            }
+        }
+        return track_count;
+    }
+
+    inline std::string HelixGeneratorEventSource::GetDescription() {
+        return "Synthetic TDIS MTPC proton helix track generator (generator://helix)";
+    }
+} // namespace tdis::io
+
+
+
+// The template specialization needs to be in the global namespace (or at least not inside the tdis namespace)
+template <>
+inline double JEventSourceGeneratorT<tdis::io::HelixGeneratorEventSource>::CheckOpenable(std::string resource_name) {
+    return resource_name.starts_with(tdis::io::kHelixGeneratorScheme) ? 1.0 : 0.0;
+}
@@ -0,0 +1,181 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Read-only memory mapping of a whole input file.
+ *
+ *  The mapping is released in destructor (RAII). The content is exposed as std::string_view
+ *  so text parsers can tokenize the file in place without copying lines into std::string
+ *
+ *  FileReadAdvice asks the kernel to read pages ahead of the reader position (posix_fadvise), so on
+ *  slow shared filesystems the data is already in page cache when parsing gets to it
+ **/
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+namespace tdis::io {
+
+    /** Size and modification time of a file. Used to check that sidecar/cache files are up to date */
+    struct FileStamp {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+
+        bool operator==(const FileStamp&) const = default;
+
+        /// Reads stamp of the file. Returns false if the file doesn't exist
+        static bool Read(const std::string& file_path, FileStamp& stamp) {
+            struct stat file_stat{};
+            if (::stat(file_path.c_str(), &file_stat) != 0) {
+                return false;
+            }
+            stamp.size = static_cast<uint64_t>(file_stat.st_size);
+            stamp.mtime_ns = static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1'000'000'000 + file_stat.st_mtim.tv_nsec;
+            return true;
+        }
+    };
+
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(const std::string& path) { Open(path); }
+
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// Maps the whole file to memory. Throws std::runtime_error if file can't be opened or mapped
+        void Open(const std::string& path);
+
+        /// Unmaps the file. Safe to call multiple times
+        void Close();
+
+        bool IsOpen() const { return m_fd >= 0; }
+
+        /// Size of the file in bytes
+        size_t Size() const { return m_size; }
+
+        /// Whole file content
+        std::string_view View() const { return {m_data, m_size}; }
+
+    private:
+        int m_fd = -1;
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+
+    /** Read-ahead hints for a file which is read front to back */
+    class FileReadAdvice {
+    public:
+        /// window - bytes to read ahead of the reader position
+        explicit FileReadAdvice(size_t window = 64 * 1024 * 1024): m_window(window) {}
+
+        ~FileReadAdvice() { Close(); }
+
+        FileReadAdvice(const FileReadAdvice&) = delete;
+        FileReadAdvice& operator=(const FileReadAdvice&) = delete;
+
+        /// Opens file for advices and marks it as read sequentially. Advices are only hints, so errors are ignored
+        void Open(const std::string& path);
+
+        /// Reader is at position. Asks to read the next window when half of the previous one is consumed
+        void Advance(uint64_t position);
+
+        void Close();
+
+    private:
+        int m_fd = -1;
+        size_t m_window;
+        uint64_t m_advised_end = 0;
+    };
+
+
+    inline void MappedFile::Open(const std::string& path) {
+        Close();
+
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) {
+            throw std::runtime_error(fmt::format("Could not open the file: '{}'. {}", path, std::strerror(errno)));
+        }
+
+        struct stat file_stat{};
+        if (::fstat(m_fd, &file_stat) != 0) {
+            auto message = fmt::format("Could not stat the file: '{}'. {}", path, std::strerror(errno));
+            Close();
+            throw std::runtime_error(message);
+        }
+
+        m_size = static_cast<size_t>(file_stat.st_size);
+
+        // mmap of zero length is an error, an empty file is just an empty view
+        if (m_size == 0) {
+            return;
+        }
+
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (data == MAP_FAILED) {
+            auto message = fmt::format("Could not mmap the file: '{}'. {}", path, std::strerror(errno));
+            Close();
+            throw std::runtime_error(message);
+        }
+        m_data = static_cast<const char*>(data);
+
+        // The file is read front to back. Ask kernel for aggressive read-ahead
+        ::madvise(data, m_size, MADV_SEQUENTIAL);
+    }
+
+    inline void MappedFile::Close() {
+        if (m_data) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+            m_data = nullptr;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        m_size = 0;
+    }
+
+    inline void FileReadAdvice::Open(const std::string& path) {
+        Close();
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd >= 0) {
+            ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        m_advised_end = 0;
+        Advance(0);
+    }
+
+    inline void FileReadAdvice::Advance(uint64_t position) {
+        if (m_fd < 0 || position + m_window / 2 < m_advised_end) {
+            return;
+        }
+        // Page cache is shared, so this works for std::ifstream and mmap readers of the same file
+        ::posix_fadvise(m_fd, static_cast<off_t>(position), static_cast<off_t>(m_window), POSIX_FADV_WILLNEED);
+        m_advised_end = position + m_window;
+    }
+
+    inline void FileReadAdvice::Close() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+}   // namespace tdis::io
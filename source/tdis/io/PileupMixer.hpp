@@ -0,0 +1,106 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Pile-up mixing for digitized track sources.
+ *
+ *  The digitized files have one track per event. With mixing, the source builds each emitted event
+ *  from several consecutive input tracks to get realistic detector occupancy.
+ *  Each track stays a separate DigitizedMtpcMcTrack with its own hits, so hit to track truth links are kept.
+ *  The first track of the event is the triggered one. Other tracks get a random time offset, which is added
+ *  to the time of all their hits.
+ *
+ *  Configuration Parameters (used by DigitizedDataEventSource and DigitizedBinaryEventSource)
+ *    - io:pileup_tracks (double, default 0):
+ *        Mean number of input tracks in one emitted event. 0 - no mixing, one track per event
+ *
+ *    - io:pileup_poisson (bool, default true):
+ *        Number of tracks is Poisson distributed with io:pileup_tracks mean (at least 1).
+ *        If false, each event has exactly round(io:pileup_tracks) tracks
+ *
+ *    - io:pileup_time_window (double, default 0):
+ *        Pile-up tracks get time offsets uniformly distributed in [-window/2, window/2] (ns)
+ *
+ *    - io:pileup_seed (uint64, default 1):
+ *        Random seed. The same seed and input give the same events
+ **/
+
+#pragma once
+
+#include <JANA/JApplication.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace tdis::io {
+
+    class PileupMixer {
+    public:
+        struct Config {
+            double mean_tracks = 0;
+            bool poisson = true;
+            double time_window = 0;     // ns
+            uint64_t seed = 1;
+        };
+
+        /// Registers io:pileup_* parameters with the values of config as defaults
+        static void DefineParameters(JApplication* app, Config& config);
+
+        void Configure(const Config& config);
+
+        bool IsEnabled() const { return m_cfg.mean_tracks > 0; }
+
+        /// Number of input tracks for the next emitted event (>= 1)
+        size_t NextMultiplicity();
+
+        /// Time offset (ns) for the track with track_index in the event. The first track has no offset
+        double NextTimeOffset(size_t track_index);
+
+    private:
+        Config m_cfg;
+        std::mt19937_64 m_generator;
+        std::poisson_distribution<size_t> m_multiplicity;
+        std::uniform_real_distribution<double> m_time_offset;
+    };
+
+
+    inline void PileupMixer::DefineParameters(JApplication* app, Config& config) {
+        app->SetDefaultParameter("io:pileup_tracks", config.mean_tracks,
+            "Mean number of input tracks mixed to one event. 0 - no mixing, one track per event");
+        app->SetDefaultParameter("io:pileup_poisson", config.poisson,
+            "Poisson distributed number of mixed tracks (true) or exactly round(io:pileup_tracks) (false)");
+        app->SetDefaultParameter("io:pileup_time_window", config.time_window,
+            "Time window [ns] for random time offsets of pile-up tracks, offsets are in [-window/2, window/2]");
+        app->SetDefaultParameter("io:pileup_seed", config.seed,
+            "Random seed for pile-up mixing");
+    }
+
+    inline void PileupMixer::Configure(const Config& config) {
+        m_cfg = config;
+        m_generator.seed(config.seed);
+        if (IsEnabled()) {
+            m_multiplicity = std::poisson_distribution<size_t>(config.mean_tracks);
+        }
+        m_time_offset = std::uniform_real_distribution<double>(-config.time_window / 2, config.time_window / 2);
+    }
+
+    inline size_t PileupMixer::NextMultiplicity() {
+        if (!IsEnabled()) {
+            return 1;
+        }
+        if (!m_cfg.poisson) {
+            return std::max<size_t>(1, static_cast<size_t>(std::lround(m_cfg.mean_tracks)));
+        }
+        return std::max<size_t>(1, m_multiplicity(m_generator));
+    }
+
+    inline double PileupMixer::NextTimeOffset(size_t track_index) {
+        if (track_index == 0 || m_cfg.time_window <= 0) {
+            return 0;
+        }
+        return m_time_offset(m_generator);
+    }
+
+}   // namespace tdis::io
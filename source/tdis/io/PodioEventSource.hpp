@@ -0,0 +1,291 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  EventSource for PODIO ROOT files written by PodioWriteProcessor (podio_output.root)
+ *
+ *  Each "events" frame becomes a physics event. Collections listed in podio:input_collections are inserted
+ *  into the JEvent as they were saved, so factories producing them are not run again. Other collections of
+ *  the frame are not read at all. By default these are the digitized input and reconstructed hits, so
+ *  a rerun like
+ *
+ *      tdis -pKalmanFitterGenerator:bz=1.4 -ppodio:output_file=refit.root podio_output.root
+ *
+ *  skips text parsing and hit reconstruction and only runs the fitting with the new configuration.
+ *  Event and run numbers are taken from the saved EventInfo.
+ *
+ *  podio:output_file must be another file: PodioWriteProcessor truncates its output when it starts, before
+ *  the input is read. tdis_main checks it with CheckPodioInputIsNotOutput and stops with an error.
+ *
+ *  Configuration Parameters
+ *    - podio:input_collections (std::vector<std::string>):
+ *        Comma separated list of collections to take from the file.
+ *        Default: EventInfo,DigitizedMtpcMcTrack,DigitizedMtpcMcHit,TrackerHit,Measurement2D,TruthTrackInitParameters
+ *        Collections which are produced again should not be listed (a frame can't have two collections
+ *        with the same name). Relations to collections which are not listed are not available
+ *
+ *    - io:skip_events (uint64, default 0):    Number of frames to skip
+ *    - io:max_events (uint64, default 0):     Maximum number of frames to process. 0 - all frames
+ **/
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JEvent.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JEventSourceGeneratorT.h>
+#include <JANA/JException.h>
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <podio/CollectionBase.h>
+#include <podio/Frame.h>
+#include <podio/ROOTReader.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "podio_model/DigitizedMtpcMcHitCollection.h"
+#include "podio_model/DigitizedMtpcMcTrackCollection.h"
+#include "podio_model/EventInfoCollection.h"
+#include "podio_model/Measurement2DCollection.h"
+#include "podio_model/TimesliceInfoCollection.h"
+#include "podio_model/TrackCollection.h"
+#include "podio_model/TrackParametersCollection.h"
+#include "podio_model/TrackSeedCollection.h"
+#include "podio_model/TrackSegmentCollection.h"
+#include "podio_model/TrackerHitCollection.h"
+#include "podio_model/TrajectoryCollection.h"
+#include "services/InputFilesService.hpp"
+#include "services/LogService.hpp"
+
+namespace tdis::io {
+
+    /** Frame data read from file which gives the frame only the selected collections.
+     *  Other collections are not unpacked and their names are free for newly produced collections */
+    class SelectedFrameData {
+    public:
+        SelectedFrameData(std::unique_ptr<podio::ROOTFrameData> data, std::shared_ptr<const std::set<std::string>> selected):
+            m_data(std::move(data)), m_selected(selected) {}
+
+        podio::CollectionIDTable getIDTable() const { return m_data->getIDTable(); }
+
+        std::optional<podio::CollectionReadBuffers> getCollectionBuffers(const std::string& name) {
+            if (!m_selected->count(name)) {
+                return std::nullopt;
+            }
+            return m_data->getCollectionBuffers(name);
+        }
+
+        std::vector<std::string> getAvailableCollections() const {
+            auto names = m_data->getAvailableCollections();
+            std::erase_if(names, [this](const std::string& name) { return !m_selected->count(name); });
+            return names;
+        }
+
+        std::unique_ptr<podio::GenericParameters> getParameters() { return m_data->getParameters(); }
+
+    private:
+        std::unique_ptr<podio::ROOTFrameData> m_data;
+        std::shared_ptr<const std::set<std::string>> m_selected;
+    };
+
+
+    /** Throws JException if one of input files is the PODIO output file, which would be truncated before it is read */
+    inline void CheckPodioInputIsNotOutput(const std::vector<std::string>& input_files, const std::string& output_file) {
+        std::error_code output_error;
+        const auto output_path = std::filesystem::weakly_canonical(std::filesystem::absolute(output_file), output_error);
+        if (output_error) return;
+
+        for (const auto& input_file: input_files) {
+            std::error_code input_error;
+            const auto input_path = std::filesystem::weakly_canonical(std::filesystem::absolute(input_file), input_error);
+            if (!input_error && input_path == output_path) {
+                throw JException(fmt::format("Input file '{}' is also podio:output_file and would be overwritten. "
+                                             "Set another output, e.g. -ppodio:output_file=refit.root", input_file));
+            }
+        }
+    }
+
+
+    /** Inserts collection owned by the event frame to JEvent with its data type */
+    using FrameCollectionInserter = void (*)(JEvent&, const podio::CollectionBase*, const std::string&);
+
+    template <typename T>
+    void InsertFrameCollection(JEvent& event, const podio::CollectionBase* collection, const std::string& name) {
+        event.InsertCollectionAlreadyInFrame<T>(collection, name);
+    }
+
+    /// Inserters by collection type name (e.g. "tdis::DigitizedMtpcMcHitCollection")
+    template <typename... T>
+    std::unordered_map<std::string_view, FrameCollectionInserter> MakeFrameCollectionInserters() {
+        return {{T::collection_type::typeName, &InsertFrameCollection<T>}...};
+    }
+
+
+    class PodioEventSource : public JEventSource {
+
+        podio::ROOTReader m_reader;
+        uint64_t m_frame_count = 0;
+        uint64_t m_frame_index = 0;
+        std::shared_ptr<spdlog::logger> m_log;
+
+        /// podio:input_collections
+        std::vector<std::string> m_cfg_input_collections = {
+            "EventInfo",
+            "DigitizedMtpcMcTrack",
+            "DigitizedMtpcMcHit",
+            "TrackerHit",
+            "Measurement2D",
+            "TruthTrackInitParameters"
+        };
+        std::shared_ptr<const std::set<std::string>> m_input_collections;
+
+        /// All datatypes of layout.yaml
+        std::unordered_map<std::string_view, FrameCollectionInserter> m_inserters = MakeFrameCollectionInserters<
+            EventInfo, TimesliceInfo, DigitizedMtpcMcTrack, DigitizedMtpcMcHit,
+            edm4eic::TrackerHit, edm4eic::Measurement2D, edm4eic::TrackSeed, edm4eic::Trajectory,
+            edm4eic::TrackParameters, edm4eic::Track, edm4eic::TrackSegment>();
+        std::set<std::string> m_unknown_types;     // Warned once per type
+
+        uint64_t m_cfg_skip_events = 0;
+        uint64_t m_cfg_max_events = 0;
+        uint64_t m_emitted_events = 0;
+
+        /// Event numbers for frames without EventInfo (see InputFilesService)
+        std::shared_ptr<services::InputFilesService> m_input_files;
+        size_t m_file_index = 0;
+        int32_t m_run_number = 0;
+
+    public:
+        PodioEventSource();
+
+        PodioEventSource(std::string resource_name, JApplication* app);
+
+        ~PodioEventSource() override = default;
+
+        void Init() override;
+
+        void Open() override;
+
+        void Close() override;
+
+        Result Emit(JEvent&) override;
+
+        static std::string GetDescription();
+    };
+
+
+    // Implementation section starts here
+
+    inline PodioEventSource::PodioEventSource() : JEventSource() {
+        SetTypeName(NAME_OF_THIS);  // Provide JANA with class name
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+
+    inline PodioEventSource::PodioEventSource(std::string resource_name, JApplication* app): JEventSource(resource_name, app) {
+        SetTypeName(NAME_OF_THIS);  // Provide JANA with class name
+        SetCallbackStyle(CallbackStyle::ExpertMode);
+    }
+
+    inline void PodioEventSource::Init() {
+        auto app = GetApplication();
+        m_log = app->GetService<tdis::services::LogService>()->logger("PodioEventSource");
+        m_input_files = app->GetService<tdis::services::InputFilesService>();
+
+        app->SetDefaultParameter("podio:input_collections", m_cfg_input_collections,
+            "Comma separated list of collections to take from PODIO input file. Collections produced again must not be listed");
+        app->SetDefaultParameter("io:skip_events", m_cfg_skip_events,
+            "Number of events to skip. PODIO frames are read by entry number, skipped frames are not read");
+        app->SetDefaultParameter("io:max_events", m_cfg_max_events,
+            "Maximum number of events to process from each file after skipped ones. 0 - all events");
+        m_input_collections = std::make_shared<const std::set<std::string>>(m_cfg_input_collections.begin(), m_cfg_input_collections.end());
+    }
+
+    inline void PodioEventSource::Open() {
+        try {
+            m_reader.openFile(this->GetResourceName());
+        } catch (const std::exception& ex) {
+            auto message= fmt::format("Error: Could not open PODIO file '{}'. {}", this->GetResourceName(), ex.what());
+            m_log->error(message);
+            throw std::runtime_error(message);
+        }
+
+        m_frame_count = m_reader.getEntries("events");
+        m_frame_index = std::min(m_cfg_skip_events, m_frame_count);
+        m_emitted_events = 0;
+        m_file_index = m_input_files->GetFileIndex(this->GetResourceName());
+        m_run_number = m_input_files->GetRunNumber(this->GetResourceName());
+        m_log->info("Opened PODIO file '{}' with {} events as input file #{}", this->GetResourceName(), m_frame_count, m_file_index);
+        m_log->info("Input collections: {}", fmt::join(m_cfg_input_collections, ", "));
+        if (m_cfg_skip_events > 0) {
+            m_log->info("Skipping {} events", m_cfg_skip_events);
+        }
+    }
+
+    inline void PodioEventSource::Close() {
+        // podio::ROOTReader closes files in destructor
+        m_frame_count = m_frame_index = 0;
+    }
+
+    inline JEventSource::Result PodioEventSource::Emit(JEvent& event) {
+        if (m_frame_index >= m_frame_count) {
+            return Result::FailureFinished;
+        }
+        if (m_cfg_max_events && m_emitted_events >= m_cfg_max_events) {
+            m_log->info("Reached io:max_events={}", m_cfg_max_events);
+            return Result::FailureFinished;
+        }
+
+        const uint64_t frame_index = m_frame_index++;
+        auto frame_data = std::make_unique<SelectedFrameData>(m_reader.readEntry("events", frame_index), m_input_collections);
+        auto frame = std::make_unique<podio::Frame>(std::move(frame_data));
+
+        for (const auto& name: frame->getAvailableCollections()) {
+            const auto* collection = frame->get(name);
+            auto inserter = m_inserters.find(collection->getTypeName());
+            if (inserter == m_inserters.end()) {
+                if (m_unknown_types.emplace(collection->getTypeName()).second) {
+                    m_log->warn("Collection '{}' has type '{}' which is not in tdis datamodel. It is skipped", name, collection->getTypeName());
+                }
+                continue;
+            }
+            inserter->second(event, collection, name);
+        }
+
+        // Keep numbering of the saved events
+        const auto& info = frame->get<EventInfoCollection>("EventInfo");
+        if (!info.empty()) {
+            event.SetEventNumber(info[0].EventNumber());
+            event.SetRunNumber(info[0].RunNumber());
+        } else {
+            event.SetEventNumber(m_input_files->GetGlobalEventNumber(m_file_index, frame_index));
+            event.SetRunNumber(m_run_number);
+        }
+
+        // Collections are owned by the frame, which is owned by the event now
+        event.Insert(frame.release());
+        m_emitted_events++;
+        m_log->debug("Event {} has been read from frame {}", event.GetEventNumber(), frame_index);
+        return Result::Success;
+    }
+
+    inline std::string PodioEventSource::GetDescription() {
+        return "PODIO ROOT file (podio_output.root) event source";
+    }
+} // namespace tdis::io
+
+
+
+// The template specialization needs to be in the global namespace (or at least not inside the tdis namespace)
+template <>
+inline double JEventSourceGeneratorT<tdis::io::PodioEventSource>::CheckOpenable(std::string resource_name) {
+    return resource_name.ends_with(".root") ? 1.0 : 0.0;
+}
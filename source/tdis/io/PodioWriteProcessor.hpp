@@ -83,6 +83,8 @@ public:
         "FittedTrajectories", "FittedTrackParams", "FittedTracks"
     };
 
+  static constexpr const char* kDefaultOutputFile = "podio_output.root";
+
   PodioWriteProcessor(JApplication * app);
   ~PodioWriteProcessor() override = default;
 
@@ -96,7 +98,7 @@ public:
   std::mutex m_mutex;
   bool m_is_first_event = true;
   std::shared_ptr<spdlog::logger> m_log;
-  std::string m_output_file = "podio_output.root";
+  std::string m_output_file = kDefaultOutputFile;
 
   std::set<std::string> m_output_collections;  // config. parameter
   std::vector<std::string> m_collections_to_write;  // derived from above config. parameters
@@ -0,0 +1,137 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Bounded single producer / single consumer queue between a read-ahead thread and an event source.
+ *
+ *  Items are moved through a ring of preallocated slots. Positions are atomics, so push and pop
+ *  take no locks. A side waits (C++20 std::atomic::wait) only if the queue is full or empty:
+ *  the reader thread sleeps when it is far enough ahead, the source sleeps when it outran the reader.
+ *
+ *  The producer calls Finish() after the last item, the consumer may Close() the queue at any time
+ *  to make the producer stop.
+ **/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tdis::io {
+
+    template <typename T>
+    class ReadAheadQueue {
+    public:
+        /// capacity is rounded up to a power of 2
+        explicit ReadAheadQueue(size_t capacity);
+
+        ReadAheadQueue(const ReadAheadQueue&) = delete;
+        ReadAheadQueue& operator=(const ReadAheadQueue&) = delete;
+
+        /// Producer: moves item to the queue, waits while the queue is full. Returns false if the queue is closed
+        bool Push(T&& item);
+
+        /// Consumer: moves the next item out, waits while the queue is empty.
+        /// Returns false if the producer finished and all items are taken or if the queue is closed
+        bool Pop(T& item);
+
+        /// Producer: there will be no more items
+        void Finish();
+
+        /// Consumer: stop the producer. Push and Pop return false after it
+        void Close();
+
+    private:
+        void Notify();
+
+        std::vector<T> m_slots;
+        size_t m_mask = 0;
+
+        // Producer and consumer positions are on separate cache lines
+        alignas(64) std::atomic<size_t> m_head{0};      // Next item to pop
+        alignas(64) std::atomic<size_t> m_tail{0};      // Next slot to push
+        alignas(64) std::atomic<uint32_t> m_signal{0};  // Changes on every push, pop, finish and close. Both sides wait on it
+        std::atomic<bool> m_finished{false};
+        std::atomic<bool> m_closed{false};
+    };
+
+
+    template <typename T>
+    ReadAheadQueue<T>::ReadAheadQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    template <typename T>
+    bool ReadAheadQueue<T>::Push(T&& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        while (true) {
+            // Read the signal before checking, so a pop in between doesn't get lost
+            const uint32_t signal = m_signal.load(std::memory_order_acquire);
+            if (m_closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (tail - m_head.load(std::memory_order_acquire) < m_slots.size()) {
+                break;
+            }
+            m_signal.wait(signal, std::memory_order_acquire);
+        }
+
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        Notify();
+        return true;
+    }
+
+    template <typename T>
+    bool ReadAheadQueue<T>::Pop(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            const uint32_t signal = m_signal.load(std::memory_order_acquire);
+            if (m_closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (m_tail.load(std::memory_order_acquire) != head) {
+                break;
+            }
+            if (m_finished.load(std::memory_order_acquire)) {
+                // The last push might happen right before finish
+                if (m_tail.load(std::memory_order_acquire) != head) {
+                    break;
+                }
+                return false;
+            }
+            m_signal.wait(signal, std::memory_order_acquire);
+        }
+
+        item = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        Notify();
+        return true;
+    }
+
+    template <typename T>
+    void ReadAheadQueue<T>::Finish() {
+        m_finished.store(true, std::memory_order_release);
+        Notify();
+    }
+
+    template <typename T>
+    void ReadAheadQueue<T>::Close() {
+        m_closed.store(true, std::memory_order_release);
+        Notify();
+    }
+
+    template <typename T>
+    void ReadAheadQueue<T>::Notify() {
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_all();
+    }
+
+}   // namespace tdis::io
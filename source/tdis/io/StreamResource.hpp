@@ -0,0 +1,87 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Live input resources for running tdis right behind the digitizer without an intermediate file:
+ *
+ *    fifo://<path>   - named pipe (mkfifo). Opening waits until the writer opens the pipe
+ *    unix://<path>   - Unix domain stream socket. tdis connects to the digitizer listening on <path>
+ *
+ *  The data is the same "Event"/track/hit text as in digitized .txt files.
+ **/
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fmt/core.h>
+
+namespace tdis::io {
+
+    inline constexpr std::string_view kFifoScheme = "fifo://";
+    inline constexpr std::string_view kUnixSocketScheme = "unix://";
+
+    /// If resource name is fifo:// or unix:// stream
+    inline bool IsStreamResource(std::string_view resource_name) {
+        return resource_name.starts_with(kFifoScheme) || resource_name.starts_with(kUnixSocketScheme);
+    }
+
+    /** Opens fifo:// or unix:// resource for reading and returns its file descriptor.
+     *  Connection to a socket is retried for connect_timeout_sec as the digitizer may start later.
+     *  Throws std::runtime_error if it can't be opened */
+    inline int OpenStreamResource(const std::string& resource_name, double connect_timeout_sec) {
+        if (resource_name.starts_with(kFifoScheme)) {
+            auto path = resource_name.substr(kFifoScheme.size());
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error(fmt::format("Could not open fifo '{}'. {}", path, std::strerror(errno)));
+            }
+            return fd;
+        }
+
+        if (resource_name.starts_with(kUnixSocketScheme)) {
+            auto path = resource_name.substr(kUnixSocketScheme.size());
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error(fmt::format("Unix socket path is too long: '{}'", path));
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(connect_timeout_sec);
+            while (true) {
+                int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                if (fd < 0) {
+                    throw std::runtime_error(fmt::format("Could not create socket for '{}'. {}", path, std::strerror(errno)));
+                }
+                if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) {
+                    // Nothing is sent to the digitizer
+                    ::shutdown(fd, SHUT_WR);
+                    return fd;
+                }
+
+                int error = errno;
+                ::close(fd);
+                bool is_not_ready = error == ENOENT || error == ECONNREFUSED;
+                if (!is_not_ready || std::chrono::steady_clock::now() >= deadline) {
+                    throw std::runtime_error(fmt::format("Could not connect to unix socket '{}'. {}", path, std::strerror(error)));
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+
+        throw std::runtime_error(fmt::format("'{}' is not fifo:// or unix:// resource", resource_name));
+    }
+
+}   // namespace tdis::io
@@ -0,0 +1,105 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ * InputFilesService keeps the ordered list of input files and gives each event source
+ * a deterministic event numbering and run number.
+ *
+ * JANA may open several sources and their events are processed by many threads in any order.
+ * So event numbers come from the (file index, index of event in the file) pair:
+ *      global event number = file_index * io:file_event_stride + event index in the file
+ * The same inputs in the same order always give the same numbers.
+ *
+ *  Configuration Parameters
+ *    - io:file_event_stride (uint64, default 1000000000):
+ *        Event number range reserved for each input file
+ *
+ *    - io:run_number (int32, default -1):
+ *        Run number of events. -1 - take the number after "run" in the file name (e.g. mtpc_run1234.txt), or 0
+ */
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JException.h>
+#include <JANA/Services/JServiceLocator.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <charconv>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tdis::services {
+
+    class InputFilesService : public JService {
+
+        std::mutex m_lock;
+        std::vector<std::string> m_file_paths;
+        uint64_t m_event_stride = 1'000'000'000;
+        int32_t m_run_number = -1;
+
+    public:
+        InputFilesService(JApplication* app, std::vector<std::string> file_paths): m_file_paths(std::move(file_paths)) {
+            app->SetDefaultParameter("io:file_event_stride", m_event_stride,
+                "Event number range reserved for each input file: event number = file_index * stride + event index in the file");
+            app->SetDefaultParameter("io:run_number", m_run_number,
+                "Run number of events. -1 - take the number after 'run' in the file name or 0");
+
+            if (m_event_stride == 0) {
+                throw JException("io:file_event_stride must be > 0");
+            }
+        }
+
+        /** Position of the file in the input list. Files which are not in the list (e.g. added by plugins)
+         *  get the next free index. The same file given twice has the same index (and event numbers) **/
+        size_t GetFileIndex(const std::string& file_path) {
+            std::lock_guard<std::mutex> locker(m_lock);
+            auto iter = std::find(m_file_paths.begin(), m_file_paths.end(), file_path);
+            if (iter != m_file_paths.end()) {
+                return static_cast<size_t>(iter - m_file_paths.begin());
+            }
+            m_file_paths.push_back(file_path);
+            return m_file_paths.size() - 1;
+        }
+
+        /** Deterministic event number for event with event_index in the file with file_index **/
+        uint64_t GetGlobalEventNumber(size_t file_index, uint64_t event_index) const {
+            return static_cast<uint64_t>(file_index) * m_event_stride + event_index;
+        }
+
+        /** Run number from io:run_number or from the file name **/
+        int32_t GetRunNumber(const std::string& file_path) const {
+            return m_run_number >= 0 ? m_run_number : ParseRunNumber(file_path);
+        }
+
+        /** Finds "run" (any case, optionally followed by '_' or '-') and digits after it in the file name.
+         *  Returns 0 if there is no such number **/
+        static int32_t ParseRunNumber(std::string_view file_path) {
+            auto slash_pos = file_path.find_last_of('/');
+            std::string_view name = slash_pos == std::string_view::npos ? file_path : file_path.substr(slash_pos + 1);
+
+            for (size_t pos = 0; pos + 3 < name.size(); pos++) {
+                auto lower = [&](size_t i) { return std::tolower(static_cast<unsigned char>(name[i])); };
+                if (lower(pos) != 'r' || lower(pos + 1) != 'u' || lower(pos + 2) != 'n') {
+                    continue;
+                }
+
+                size_t digits_pos = pos + 3;
+                if (digits_pos < name.size() && (name[digits_pos] == '_' || name[digits_pos] == '-')) {
+                    digits_pos++;
+                }
+
+                int32_t run_number = 0;
+                auto [end, error] = std::from_chars(name.data() + digits_pos, name.data() + name.size(), run_number);
+                if (error == std::errc() && end != name.data() + digits_pos && run_number >= 0) {
+                    return run_number;
+                }
+            }
+            return 0;
+        }
+    };
+}   // namespace tdis::services
@@ -9,10 +9,22 @@
 #include <utility>
 
 #include "CLI/CLI.hpp"
+#include "io/DigitizedBinaryEventSource.hpp"
 #include "io/DigitizedDataEventSource.hpp"
+#include "io/DigitizedTextEventFactory.hpp"
+#include "io/DigitizedTimesliceUnfolder.hpp"
+#include "io/HelixGeneratorEventSource.hpp"
+#include "io/PodioEventSource.hpp"
 #include "io/PodioWriteProcessor.hpp"
+#include "services/InputFilesService.hpp"
 #include "services/LogService.hpp"
 #include "tracking/ActsGeometryService.h"
+#include "tracking/ConditionsService.h"
+#include "tracking/DistortionCorrectionService.h"
+#include "tracking/HitFilterFactory.h"
+#include "tracking/PadClusteringFactory.h"
+#include "tracking/PadHitIndexFactory.h"
+#include "tracking/PadOccupancyService.h"
 #include "tracking/ReconstructedHitFactory.h"
 #include "tracking/TruthTrackParameterFactory.h"
 #include "tracking/KalmanFittingFactory.h"
@@ -110,15 +122,62 @@ int main(int argc, char* argv[]) {
 
     // Register services:
     app.ProvideService(std::make_shared<tdis::services::LogService>(&app));
+    app.ProvideService(std::make_shared<tdis::services::InputFilesService>(&app, parsedArgs.filePaths));
     app.ProvideService(std::make_shared<tdis::tracking::ActsGeometryService>());
+    app.ProvideService(std::make_shared<tdis::tracking::DistortionCorrectionService>());
+    app.ProvideService(std::make_shared<tdis::tracking::ConditionsService>());
+    app.ProvideService(std::make_shared<tdis::tracking::PadOccupancyService>());
+
+    // Parses event text cut by DigitizedDataEventSource (io:parallel_parse)
+    auto textParserGenerator = new JOmniFactoryGeneratorT<tdis::io::DigitizedTextEventFactory>();
+    textParserGenerator->AddWiring(
+        "DigitizedTextEventParser",
+        {"DigitizedTextEvent"},
+        {"DigitizedMtpcMcTrack", "DigitizedMtpcMcHit"});
+    app.Add(textParserGenerator);
+
+    // Hit filter: ADC, time window and dead pad cuts before hit reconstruction
+    bool hit_filter = false;
+    app.SetDefaultParameter("tracking:hit_filter", hit_filter,
+        "Filter digitized hits before reconstruction (see tracking:hit_filter:* parameters)");
+    if (hit_filter) {
+        auto hitFilterGenerator = new JOmniFactoryGeneratorT<tdis::tracking::HitFilterFactory>();
+        hitFilterGenerator->AddWiring(
+            "HitFilterGenerator",
+            {"DigitizedMtpcMcHit"},
+            {"FilteredDigitizedMtpcMcHit"});
+        app.Add(hitFilterGenerator);
+    }
+
+    // Pad clustering: single pad measurements are merged by PadClusteringFactory to Measurement2D
+    bool pad_clustering = false;
+    app.SetDefaultParameter("tracking:pad_clustering", pad_clustering,
+        "Merge neighboring pads to ADC weighted cluster measurements (see tracking:cluster_time_window)");
 
     auto recoHitGenerator = new JOmniFactoryGeneratorT<tdis::tracking::ReconstructedHitFactory>();
     recoHitGenerator->AddWiring(
         "TrackerHitGenerator",
-        {"DigitizedMtpcMcHit"},
-        {"TrackerHit", "Measurement2D"});
+        {hit_filter ? "FilteredDigitizedMtpcMcHit" : "DigitizedMtpcMcHit"},
+        {"TrackerHit", pad_clustering ? "UnclusteredMeasurement2D" : "Measurement2D"});
     app.Add(recoHitGenerator);
 
+    // Pad index of TrackerHit. It is built only in events where some factory asks for PadHitIndex (PadClusteringFactory)
+    auto hitIndexGenerator = new JOmniFactoryGeneratorT<tdis::tracking::PadHitIndexFactory>();
+    hitIndexGenerator->AddWiring(
+        "PadHitIndexGenerator",
+        {"TrackerHit"},
+        {"PadHitIndex"});
+    app.Add(hitIndexGenerator);
+
+    if (pad_clustering) {
+        auto padClusteringGenerator = new JOmniFactoryGeneratorT<tdis::tracking::PadClusteringFactory>();
+        padClusteringGenerator->AddWiring(
+            "PadClusteringGenerator",
+            {"UnclusteredMeasurement2D", "PadHitIndex"},
+            {"Measurement2D"});
+        app.Add(padClusteringGenerator);
+    }
+
     auto truthTrackInitGenerator = new JOmniFactoryGeneratorT<tdis::tracking::TruthTrackParameterFactory>();
     truthTrackInitGenerator->AddWiring(
         "TruthTrackParameterGenerator",
@@ -141,6 +200,17 @@ int main(int argc, char* argv[]) {
 
 
     app.Add(new JEventSourceGeneratorT<tdis::io::DigitizedDataEventSource>);
+    app.Add(new JEventSourceGeneratorT<tdis::io::DigitizedBinaryEventSource>);
+    app.Add(new JEventSourceGeneratorT<tdis::io::HelixGeneratorEventSource>);     // generator://helix
+    app.Add(new JEventSourceGeneratorT<tdis::io::PodioEventSource>);             // podio_output.root of previous runs
+
+    // Timeslice mode: sources emit timeslices of io:timeslice_events events, the unfolder splits them to physics events
+    uint64_t timeslice_events = 0;
+    app.SetDefaultParameter("io:timeslice_events", timeslice_events,
+        "Emit timeslices of this many physics events (split back by DigitizedTimesliceUnfolder). 0 - emit physics events");
+    if (timeslice_events > 0) {
+        app.Add(new tdis::io::DigitizedTimesliceUnfolder);
+    }
     app.Add(new tdis::io::PodioWriteProcessor(&app));
 
     // app.Add(new JEventProcessorPodio);
@@ -154,6 +224,13 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // PodioWriteProcessor truncates its output at start, so it can't be an input too ("1" is the default name)
+    std::string podioOutputFile = tdis::io::PodioWriteProcessor::kDefaultOutputFile;
+    if (auto param = parameterManager->FindParameter("podio:output_file"); param && param->GetValue() != "1") {
+        podioOutputFile = param->GetValue();
+    }
+    tdis::io::CheckPodioInputIsNotOutput(parsedArgs.filePaths, podioOutputFile);
+
     for(auto& filePath : parsedArgs.filePaths) {
         app.Add(filePath);
     }
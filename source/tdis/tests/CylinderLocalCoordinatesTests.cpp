@@ -0,0 +1,39 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <numbers>
+
+#include "tracking/CylinderLocalCoordinates.hpp"
+
+using namespace tdis::tracking;
+
+TEST_CASE("CylinderGlobalToLocal gives R*phi and z on the surface", "[CylinderLocalCoordinates]") {
+    double loc0 = 0, loc1 = 0;
+    const double radius = 60;
+    const double phi = 2.5;
+    auto status = CylinderGlobalToLocal(radius, radius * std::cos(phi), radius * std::sin(phi), -150.065, 1.0, loc0, loc1);
+    REQUIRE(status == LocalCoordinatesStatus::Success);
+    REQUIRE(loc0 == Catch::Approx(radius * phi));
+    REQUIRE(loc1 == Catch::Approx(-150.065));
+
+    // phi wraps to (-pi, pi]
+    CylinderGlobalToLocal(radius, -radius, -1e-9, 0, 1.0, loc0, loc1);
+    REQUIRE(loc0 == Catch::Approx(-radius * std::numbers::pi));
+}
+
+TEST_CASE("CylinderGlobalToLocal batch reports points off surface", "[CylinderLocalCoordinates]") {
+    CylinderPointBatch batch;
+    batch.push_back(60, 60.5, 0, 10);      // Within tolerance
+    batch.push_back(60, 0, 62, 20);        // 2 mm away
+    batch.push_back(100, 0, -100, 30);
+
+    REQUIRE(CylinderGlobalToLocal(batch, 1.0) == 1);
+    REQUIRE(batch.status[0] == LocalCoordinatesStatus::Success);
+    REQUIRE(batch.status[1] == LocalCoordinatesStatus::OffSurface);
+    REQUIRE(batch.status[2] == LocalCoordinatesStatus::Success);
+    REQUIRE(batch.loc0[0] == Catch::Approx(0));
+    REQUIRE(batch.loc0[2] == Catch::Approx(-50 * std::numbers::pi));
+    REQUIRE(batch.loc1[2] == Catch::Approx(30));
+
+    batch.clear();
+    REQUIRE(CylinderGlobalToLocal(batch, 1.0) == 0);
+}
@@ -0,0 +1,102 @@
+#include <catch2/catch_all.hpp>
+#include <zlib.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "io/DecompressingReader.hpp"
+
+using namespace tdis::io;
+
+namespace {
+    constexpr size_t kBlockSize = 4096;
+
+    /// Text that doesn't compress to nothing, so frames have several compressed blocks
+    std::string MakeText(size_t size, unsigned seed) {
+        std::string text(size, ' ');
+        unsigned state = seed;
+        for (size_t i = 0; i < size; i++) {
+            state = state * 1103515245u + 12345u;
+            text[i] = (i % 64 == 63) ? '\n' : static_cast<char>('0' + (state >> 16) % 10);
+        }
+        return text;
+    }
+
+    std::string WriteFile(const std::string& name, const std::string& content) {
+        auto path = (std::filesystem::temp_directory_path() / name).string();
+        std::ofstream(path, std::ios::binary).write(content.data(), static_cast<std::streamsize>(content.size()));
+        return path;
+    }
+
+    /// All blocks of the file glued together
+    std::string ReadAll(const std::string& path) {
+        DecompressingReader reader(kBlockSize, 2);
+        reader.Open(path);
+        std::string result;
+        std::string block;
+        while (reader.NextBlock(block)) {
+            REQUIRE(block.size() <= kBlockSize);
+            result += block;
+        }
+        std::remove(path.c_str());
+        return result;
+    }
+
+    std::string CompressGzip(const std::string& text) {
+        uLongf size = compressBound(text.size());
+        std::string result(size, '\0');
+        REQUIRE(compress2(reinterpret_cast<Bytef*>(result.data()), &size,
+                          reinterpret_cast<const Bytef*>(text.data()), text.size(), Z_BEST_SPEED) == Z_OK);
+        result.resize(size);
+        return result;
+    }
+
+#ifdef TDIS_WITH_ZSTD
+    std::string CompressZstd(const std::string& text) {
+        std::string result(ZSTD_compressBound(text.size()), '\0');
+        const size_t size = ZSTD_compress(result.data(), result.size(), text.data(), text.size(), 1);
+        REQUIRE_FALSE(ZSTD_isError(size));
+        result.resize(size);
+        return result;
+    }
+#endif
+
+#ifdef TDIS_WITH_LZ4
+    std::string CompressLz4(const std::string& text) {
+        std::string result(LZ4F_compressFrameBound(text.size(), nullptr), '\0');
+        const size_t size = LZ4F_compressFrame(result.data(), result.size(), text.data(), text.size(), nullptr);
+        REQUIRE_FALSE(LZ4F_isError(size));
+        result.resize(size);
+        return result;
+    }
+#endif
+}   // namespace
+
+TEST_CASE("DecompressingReader reads data of exactly whole blocks", "[DecompressingReader]") {
+    const auto text = MakeText(4 * kBlockSize, 1);
+
+    REQUIRE(ReadAll(WriteFile("tdis_reader_blocks.txt.gz", CompressGzip(text))) == text);
+#ifdef TDIS_WITH_ZSTD
+    REQUIRE(ReadAll(WriteFile("tdis_reader_blocks.txt.zst", CompressZstd(text))) == text);
+#endif
+#ifdef TDIS_WITH_LZ4
+    REQUIRE(ReadAll(WriteFile("tdis_reader_blocks.txt.lz4", CompressLz4(text))) == text);
+#endif
+}
+
+TEST_CASE("DecompressingReader reads the last frame crossing a block boundary", "[DecompressingReader]") {
+    // Two frames like 'cat a.zst b.zst'. The second starts in the middle of block 1 and ends in block 2
+    const auto first = MakeText(kBlockSize + kBlockSize / 2, 2);
+    const auto second = MakeText(kBlockSize, 3);
+
+    REQUIRE(ReadAll(WriteFile("tdis_reader_frames.txt.gz", CompressGzip(first) + CompressGzip(second))) == first + second);
+#ifdef TDIS_WITH_ZSTD
+    REQUIRE(ReadAll(WriteFile("tdis_reader_frames.txt.zst", CompressZstd(first) + CompressZstd(second))) == first + second);
+#endif
+#ifdef TDIS_WITH_LZ4
+    REQUIRE(ReadAll(WriteFile("tdis_reader_frames.txt.lz4", CompressLz4(first) + CompressLz4(second))) == first + second);
+#endif
+}
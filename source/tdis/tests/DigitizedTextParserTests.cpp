@@ -0,0 +1,118 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <string_view>
+
+#include "io/DigitizedTextParser.hpp"
+
+using namespace tdis::io;
+
+TEST_CASE("TokenizeDataLine splits tabs and spaces without allocations", "[DigitizedTextParser]") {
+    LineTokens tokens;
+    auto count = TokenizeDataLine("\t312.019\t4.03231e-08\t1\t67\t3\t0.0100074\t", tokens);
+    REQUIRE(count == 6);
+    REQUIRE(tokens[0] == "312.019");
+    REQUIRE(tokens[5] == "0.0100074");
+}
+
+TEST_CASE("TokenizeDataLine counts tokens beyond storage", "[DigitizedTextParser]") {
+    LineTokens tokens;
+    auto count = TokenizeDataLine("1 2 3 4 5 6 7 8 9 10 11", tokens);
+    REQUIRE(count == 11);
+    REQUIRE(tokens[8] == "9");
+}
+
+TEST_CASE("ParseNumber rejects trailing symbols", "[DigitizedTextParser]") {
+    double value = 0;
+    REQUIRE(ParseNumber("2.05888e-08", value));
+    REQUIRE(value == Catch::Approx(2.05888e-08));
+    REQUIRE_FALSE(ParseNumber("2.0x", value));
+
+    int int_value = 0;
+    REQUIRE(ParseNumber("68", int_value));
+    REQUIRE(int_value == 68);
+    REQUIRE_FALSE(ParseNumber("6.8", int_value));
+}
+
+TEST_CASE("ParseTrackHitTokens detects 6 column layout", "[DigitizedTextParser]") {
+    LineTokens tokens;
+    auto count = TokenizeDataLine("312.855\t2.05888e-08\t0\t68\t3\t0.0100347", tokens);
+    DigitizedReadoutHit hit{};
+    REQUIRE(ParseTrackHitTokens(tokens, count, hit));
+    REQUIRE(hit.time == Catch::Approx(312.855));
+    REQUIRE(hit.ring == 0);
+    REQUIRE(hit.pad == 68);
+    REQUIRE(hit.plane == 3);
+    REQUIRE(std::isnan(hit.true_x));
+}
+
+TEST_CASE("ParseTrackHitTokens detects 9 column layout", "[DigitizedTextParser]") {
+    LineTokens tokens;
+    auto count = TokenizeDataLine("312.8 2e-08 0.01 0.02 0.03 4 5 6 0.7", tokens);
+    DigitizedReadoutHit hit{};
+    REQUIRE(ParseTrackHitTokens(tokens, count, hit));
+    REQUIRE(hit.true_x == Catch::Approx(0.01));
+    REQUIRE(hit.true_z == Catch::Approx(0.03));
+    REQUIRE(hit.ring == 4);
+    REQUIRE(hit.pad == 5);
+    REQUIRE(hit.plane == 6);
+    REQUIRE(hit.zToGem == Catch::Approx(0.7));
+}
+
+TEST_CASE("ParseTrackHitTokens rejects 7 and 8 columns", "[DigitizedTextParser]") {
+    LineTokens tokens;
+    DigitizedReadoutHit hit{};
+    auto count = TokenizeDataLine("1 2 3 4 5 6 7", tokens);
+    REQUIRE_FALSE(ParseTrackHitTokens(tokens, count, hit));
+}
+
+TEST_CASE("TextEventCursor cuts events and keeps line indexes", "[DigitizedTextParser]") {
+    std::string_view text =
+        "Event 200000\n"
+        "0.922362\t89.49\t-156.71\t-0.0605\n"
+        "312.855\t2.05888e-08\t0\t68\t3\t0.0100347\n"
+        "Event 200001\n"
+        "0.5\t45\t10\t0.01\n";
+
+    TextEventCursor cursor(text);
+    TextEventSpan span;
+
+    REQUIRE(cursor.Next(span));
+    REQUIRE(span.file_event_number == 200000);
+    REQUIRE(span.offset == 0);
+    REQUIRE(span.line_index == 0);
+    REQUIRE(span.text.starts_with("0.922362"));
+    REQUIRE(span.text.ends_with("0.0100347\n"));
+
+    REQUIRE(cursor.Next(span));
+    REQUIRE(span.file_event_number == 200001);
+    REQUIRE(span.line_index == 3);
+    REQUIRE(span.text == "0.5\t45\t10\t0.01\n");
+
+    REQUIRE_FALSE(cursor.Next(span));
+}
+
+TEST_CASE("DetectHitLayout uses the first hit line", "[DigitizedTextParser]") {
+    HitLayout layout = HitLayout::WithTruth;
+    REQUIRE(DetectHitLayout("0.9 89.4 -156.7 -0.06\n\n312.8 2e-08 0 68 3 0.01\n", layout));
+    REQUIRE(layout == HitLayout::NoTruth);
+    REQUIRE(DetectHitLayout("0.9 89.4 -156.7 -0.06\n312.8 2e-08 0.01 0.02 0.03 4 5 6 0.7\n", layout));
+    REQUIRE(layout == HitLayout::WithTruth);
+    REQUIRE_FALSE(DetectHitLayout("0.9 89.4 -156.7 -0.06\n", layout));
+}
+
+TEST_CASE("ParseHitLine parses fixed layouts", "[DigitizedTextParser]") {
+    LayoutHit<HitLayout::NoTruth> hit{};
+    REQUIRE(ParseHitLine("\t312.855\t2.05888e-08\t0\t68\t3\t0.0100347\t", hit));
+    REQUIRE(hit.time == Catch::Approx(312.855));
+    REQUIRE(hit.pad == 68);
+    REQUIRE(hit.zToGem == Catch::Approx(0.0100347));
+    REQUIRE_FALSE(ParseHitLine("312.855 2.05888e-08 0 68", hit));
+    REQUIRE_FALSE(ParseHitLine("312.8 2e-08 0.01 0.02 0.03 4 5 6 0.7", hit));
+
+    LayoutHit<HitLayout::WithTruth> truth_hit{};
+    REQUIRE(ParseHitLine("312.8 2e-08 0.01 0.02 0.03 4 5 6 0.7", truth_hit));
+    REQUIRE(truth_hit.true_y == Catch::Approx(0.02));
+    REQUIRE(truth_hit.ring == 4);
+    REQUIRE(truth_hit.plane == 6);
+    REQUIRE(truth_hit.zToGem == Catch::Approx(0.7));
+}
@@ -0,0 +1,68 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <vector>
+
+#include "tracking/DistortionMap.h"
+
+using namespace tdis::tracking;
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("DistortionMap reproduces nodes and interpolates linearly", "[DistortionMap]") {
+    // Nodes r = 50, 100, 150; phi = 0, π/2, π, 3π/2; z = -100, 100
+    DistortionMap map(50, 150, 3, 4, -100, 100, 2);
+    for (size_t r = 0; r < 3; r++) {
+        for (size_t phi = 0; phi < 4; phi++) {
+            for (size_t z = 0; z < 2; z++) {
+                REQUIRE(map.SetNode(r, phi, z, static_cast<float>(r), static_cast<float>(phi), static_cast<float>(z)));
+            }
+        }
+    }
+    REQUIRE_FALSE(map.SetNode(3, 0, 0, 0, 0, 0));
+
+    double dx, dy, dz;
+    map.GetDisplacement(100, M_PI, 100, dx, dy, dz);
+    REQUIRE_THAT(dx, WithinAbs(1, 1e-6));
+    REQUIRE_THAT(dy, WithinAbs(2, 1e-6));
+    REQUIRE_THAT(dz, WithinAbs(1, 1e-6));
+
+    map.GetDisplacement(75, M_PI / 4, 50, dx, dy, dz);
+    REQUIRE_THAT(dx, WithinAbs(0.5, 1e-6));
+    REQUIRE_THAT(dy, WithinAbs(0.5, 1e-6));
+    REQUIRE_THAT(dz, WithinAbs(0.75, 1e-6));
+
+    // The last phi cell goes back to node 0, phi of any turn is the same
+    map.GetDisplacement(100, 7 * M_PI / 4, 0, dx, dy, dz);
+    REQUIRE_THAT(dy, WithinAbs(1.5, 1e-6));
+    map.GetDisplacement(100, -M_PI / 4, 0, dx, dy, dz);
+    REQUIRE_THAT(dy, WithinAbs(1.5, 1e-6));
+
+    // Outside r and z range border values are used
+    map.GetDisplacement(500, 0, -1000, dx, dy, dz);
+    REQUIRE_THAT(dx, WithinAbs(2, 1e-6));
+    REQUIRE_THAT(dz, WithinAbs(0, 1e-6));
+}
+
+TEST_CASE("DistortionMap corrects a batch of points", "[DistortionMap]") {
+    DistortionMap empty;
+    std::vector<double> r = {60, 80, 140}, phi = {0.1, 2.0, -3.0};
+    std::vector<double> x = {1, 2, 3}, y = {4, 5, 6}, z = {-50, 0, 50};
+    empty.Correct(r.size(), r.data(), phi.data(), x.data(), y.data(), z.data());
+    REQUIRE(x == std::vector<double>{1, 2, 3});
+
+    DistortionMap map(50, 150, 2, 3, -100, 100, 2);
+    for (size_t r_index = 0; r_index < 2; r_index++) {
+        for (size_t phi_index = 0; phi_index < 3; phi_index++) {
+            for (size_t z_index = 0; z_index < 2; z_index++) {
+                map.SetNode(r_index, phi_index, z_index, 0.5f, -0.25f, 2.0f);
+            }
+        }
+    }
+    map.Correct(r.size(), r.data(), phi.data(), x.data(), y.data(), z.data());
+    for (size_t i = 0; i < 3; i++) {
+        REQUIRE_THAT(x[i], WithinAbs(i + 1.5, 1e-6));
+        REQUIRE_THAT(y[i], WithinAbs(i + 3.75, 1e-6));
+        REQUIRE_THAT(z[i], WithinAbs(-48.0 + 50.0 * i, 1e-6));
+    }
+
+    REQUIRE_THROWS(DistortionMap(50, 150, 1, 3, -100, 100, 2));
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "tracking/HitFilter.h"
+
+using namespace tdis::tracking;
+
+TEST_CASE("HitFilterMask keeps dead pad bits for all planes", "[HitFilter]") {
+    HitFilterMask mask(10, 21, 122);
+    REQUIRE(mask.GetPadCount() == 25620);
+    REQUIRE(mask.SetDeadPad(0, 0, 0));
+    REQUIRE(mask.SetDeadPad(9, 20, 121));
+    REQUIRE_FALSE(mask.SetDeadPad(10, 0, 0));
+    REQUIRE_FALSE(mask.SetDeadPad(0, -1, 0));
+    REQUIRE(mask.IsDeadPad(9, 20, 121));
+    REQUIRE_FALSE(mask.IsDeadPad(9, 20, 120));
+    REQUIRE(mask.GetDeadPadCount() == 2);
+
+    mask.SetDeadPad(0, 0, 0, false);
+    REQUIRE(mask.GetDeadPadCount() == 1);
+
+    mask.ClearDeadPads();
+    REQUIRE(mask.GetDeadPadCount() == 0);
+}
+
+TEST_CASE("HitFilterMask selects hits passing all cuts", "[HitFilter]") {
+    HitFilterMask mask(10, 21, 122);
+    mask.SetAdcMin(1.0);
+    mask.SetTimeWindow(3, 100, 200);
+    mask.SetDeadPad(2, 5, 7);
+
+    //                              ok   dead  adc  time  time ok  plane ring  pad
+    std::vector<int32_t> plane =   {2,   2,    2,   3,    3,   3,  10,   2,    2};
+    std::vector<int32_t> ring =    {5,   5,    5,   5,    5,   5,  5,    21,   5};
+    std::vector<int32_t> pad =     {6,   7,    8,   1,    1,   1,  1,    1,    -1};
+    std::vector<double> time =     {50,  50,   50,  99,   201, 150, 50,  50,   50};
+    std::vector<double> adc =      {1,   5,    0.5, 5,    5,   1,  5,    5,    5};
+
+    std::vector<uint32_t> selected;
+    auto kept = mask.FilterHits(plane.size(), plane.data(), ring.data(), pad.data(), time.data(), adc.data(), selected);
+    REQUIRE(kept == 2);
+    REQUIRE(selected == std::vector<uint32_t>{0, 5});
+
+    // Open cuts keep every hit in range
+    HitFilterMask open_mask(10, 21, 122);
+    kept = open_mask.FilterHits(plane.size(), plane.data(), ring.data(), pad.data(), time.data(), adc.data(), selected);
+    REQUIRE(kept == 6);
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch_all.hpp>
+#include <Acts/Definitions/Units.hpp>
+#include <random>
+#include <vector>
+
+#include "PadGeometryHelper.hpp"
+#include "tracking/HitPositionKernel.h"
+
+using namespace tdis::tracking;
+
+namespace {
+    const std::vector<double> kPlanePositions = {-249.935, -150.065, -149.935, -50.065, -49.935,
+                                                 49.935, 50.065, 149.935, 150.065, 249.935};
+
+    DigitizedHitBatch MakeHits(size_t count) {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int32_t> plane(0, 9), ring(0, 20), pad(0, 121), bad(-3, 200);
+        std::uniform_real_distribution<double> z_to_gem(0, 0.1);
+        DigitizedHitBatch batch;
+        for (size_t i = 0; i < count; i++) {
+            // Every 7th hit has something out of range
+            if (i % 7 == 3) {
+                batch.push_back(i % 3 ? plane(gen) : bad(gen), i % 3 == 1 ? bad(gen) : ring(gen), i % 3 == 2 ? -999 : pad(gen), z_to_gem(gen));
+            } else {
+                batch.push_back(plane(gen), ring(gen), pad(gen), z_to_gem(gen));
+            }
+        }
+        return batch;
+    }
+}
+
+TEST_CASE("ConvertHitPositions scalar kernel matches pad geometry", "[HitPositionKernel]") {
+    auto tables = HitPositionTables::Build(tdis::getPadGeometryTable(), kPlanePositions);
+    auto batch = MakeHits(101);
+    auto valid_count = ConvertHitPositions(tables, batch, HitPositionKernel::Scalar);
+    REQUIRE(valid_count > 0);
+    REQUIRE(valid_count < batch.size());
+
+    size_t checked = 0;
+    for (size_t i = 0; i < batch.size(); i++) {
+        const int plane = batch.plane[i], ring = batch.ring[i], pad = batch.pad[i];
+        const bool valid = plane >= 0 && plane < 10 && tdis::PadGeometryTable::IsValid(ring, pad);
+        REQUIRE(batch.valid[i] == valid);
+        if (!valid) continue;
+
+        auto [x, y] = tdis::getPadCenter(ring, pad);
+        REQUIRE(batch.x[i] == x);
+        REQUIRE(batch.y[i] == y);
+        REQUIRE(batch.plane_z[i] == kPlanePositions[plane]);
+        REQUIRE(batch.z[i] == kPlanePositions[plane] + (plane % 2 ? -batch.z_to_gem[i] : batch.z_to_gem[i]));
+        REQUIRE(batch.xy_variance[i] == tdis::getPadXYVariance(ring));
+        REQUIRE(batch.cell_id[i] == static_cast<uint32_t>(1'000'000 * plane + 1'000 * ring + pad));
+        checked++;
+    }
+    REQUIRE(checked == valid_count);
+}
+
+TEST_CASE("ConvertHitPositions SIMD kernels give the same results as scalar", "[HitPositionKernel]") {
+    auto tables = HitPositionTables::Build(tdis::getPadGeometryTable(), kPlanePositions);
+    auto expected = MakeHits(1003);     // Not a multiple of the vector width
+    ConvertHitPositions(tables, expected, HitPositionKernel::Scalar);
+
+    for (auto kernel: {HitPositionKernel::Avx2, HitPositionKernel::Avx512}) {
+        if (!IsHitPositionKernelSupported(kernel)) continue;
+        INFO("Kernel " << GetHitPositionKernelName(kernel));
+
+        auto batch = MakeHits(1003);
+        ConvertHitPositions(tables, batch, kernel);
+        REQUIRE(batch.valid == expected.valid);
+        REQUIRE(batch.cell_id == expected.cell_id);
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (!batch.valid[i]) continue;
+            REQUIRE(batch.x[i] == expected.x[i]);
+            REQUIRE(batch.y[i] == expected.y[i]);
+            REQUIRE(batch.z[i] == expected.z[i]);
+            REQUIRE(batch.plane_z[i] == expected.plane_z[i]);
+            REQUIRE(batch.xy_variance[i] == expected.xy_variance[i]);
+        }
+    }
+}
@@ -0,0 +1,175 @@
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "tracking/PadClustering.hpp"
+#include "tracking/PadHitIndex.hpp"
+
+using namespace tdis::tracking;
+using Catch::Approx;
+
+namespace {
+    std::vector<uint32_t> ToVector(std::span<const uint32_t> members) {
+        return {members.begin(), members.end()};
+    }
+
+    /// Clusters with the index built over the measurements
+    size_t FindClusters(PadClusterFinder& finder, PadHitIndex& index,
+                        const std::vector<int32_t>& plane, const std::vector<int32_t>& ring, const std::vector<int32_t>& pad,
+                        const std::vector<double>& time, const std::vector<double>& adc, double time_window) {
+        index.Build(plane.size(), plane.data(), ring.data(), pad.data(), time.data());
+        return finder.FindClusters(index, plane.size(), plane.data(), ring.data(), pad.data(), time.data(), adc.data(), time_window);
+    }
+}
+
+TEST_CASE("PadClusterFinder merges adjacent in-time pads transitively", "[PadClustering]") {
+    PadHitIndex index(10, 21, 122);
+    PadClusterFinder finder;
+
+    //                              0    1    2    3    4    5    6
+    std::vector<int32_t> plane =   {1,   1,   1,   1,   1,   2,   -1};
+    std::vector<int32_t> ring =    {4,   4,   4,   4,   5,   4,   -1};
+    std::vector<int32_t> pad =     {7,   9,   8,   10,  8,   8,   -1};
+    std::vector<double> time =     {10,  25,  18,  40,  18,  18,  18};
+    std::vector<double> adc =      {1,   3,   2,   5,   1,   1,   1};
+    FindClusters(finder, index, plane, ring, pad, time, adc, 10);
+
+    // 7-8-9 chain (7 and 9 are 15 ns apart but both close to 8). 10 is 15 ns after 9. Other ring, plane, no pad - alone
+    REQUIRE(finder.GetClusterCount() == 5);
+    REQUIRE(ToVector(finder.GetMembers(0)) == std::vector<uint32_t>{1, 2, 0});      // Largest ADC first
+    REQUIRE(ToVector(finder.GetMembers(1)) == std::vector<uint32_t>{3});
+    REQUIRE(ToVector(finder.GetMembers(2)) == std::vector<uint32_t>{4});
+    REQUIRE(ToVector(finder.GetMembers(3)) == std::vector<uint32_t>{5});
+    REQUIRE(ToVector(finder.GetMembers(4)) == std::vector<uint32_t>{6});
+
+    const auto weights = finder.GetWeights(0);
+    REQUIRE(weights[0] == Approx(0.5));
+    REQUIRE(weights[1] == Approx(2.0 / 6));
+    REQUIRE(weights[2] == Approx(1.0 / 6));
+}
+
+TEST_CASE("PadClusterFinder merges the last pad with pad 0", "[PadClustering]") {
+    PadHitIndex index(10, 21, 122);
+    PadClusterFinder finder;
+
+    std::vector<int32_t> plane =   {0,   0,   0};
+    std::vector<int32_t> ring =    {3,   3,   3};
+    std::vector<int32_t> pad =     {0,   121, 60};
+    std::vector<double> time =     {5,   8,   5};
+    std::vector<double> adc =      {1,   1,   1};
+    FindClusters(finder, index, plane, ring, pad, time, adc, 10);
+
+    REQUIRE(finder.GetClusterCount() == 2);
+    REQUIRE(ToVector(finder.GetMembers(0)) == std::vector<uint32_t>{0, 1});     // Equal ADC keep the input order
+    REQUIRE(ToVector(finder.GetMembers(1)) == std::vector<uint32_t>{2});
+}
+
+TEST_CASE("PadClusterFinder doesn't merge out of window pads", "[PadClustering]") {
+    PadHitIndex index(10, 21, 122);
+    PadClusterFinder finder;
+
+    std::vector<int32_t> plane =   {0,   0,   0};
+    std::vector<int32_t> ring =    {3,   3,   3};
+    std::vector<int32_t> pad =     {121, 0,   0};
+    std::vector<double> time =     {5,   15.5, 30};
+    std::vector<double> adc =      {1,   1,   1};
+    FindClusters(finder, index, plane, ring, pad, time, adc, 10);
+    REQUIRE(finder.GetClusterCount() == 3);
+
+    // The window is inclusive
+    time[1] = 15;
+    FindClusters(finder, index, plane, ring, pad, time, adc, 10);
+    REQUIRE(finder.GetClusterCount() == 2);
+    REQUIRE(ToVector(finder.GetMembers(0)) == std::vector<uint32_t>{0, 1});
+}
+
+TEST_CASE("PadClusterFinder centroid is averaged across phi = ±π", "[PadClustering]") {
+    PadHitIndex index(10, 21, 122);
+    PadClusterFinder finder;
+    const double radius = 100;
+    const double period = 2 * M_PI * radius;
+
+    // Pads around phi = π: loc0 = R*phi is +πR - 1 and -πR + 3 (which is +πR + 3)
+    std::vector<int32_t> plane =   {0,   0};
+    std::vector<int32_t> ring =    {3,   3};
+    std::vector<int32_t> pad =     {121, 0};
+    std::vector<double> time =     {5,   5};
+    std::vector<double> adc =      {1,   1};
+    std::vector<PadClusterValues> values(2);
+    values[0].loc0 = M_PI * radius - 1;
+    values[1].loc0 = -M_PI * radius + 3;
+    FindClusters(finder, index, plane, ring, pad, time, adc, 10);
+    REQUIRE(finder.GetClusterCount() == 1);
+
+    // Mean is πR + 1, wrapped to -πR + 1
+    const auto centroid = finder.GetCentroid(0, values.data(), period);
+    REQUIRE(centroid.loc0 == Approx(-M_PI * radius + 1));
+
+    // The other way around: mean just below +πR stays there
+    values[1].loc0 = -M_PI * radius + 0.5;
+    REQUIRE(finder.GetCentroid(0, values.data(), period).loc0 == Approx(M_PI * radius - 0.25));
+
+    // Without the period it is a plain average
+    REQUIRE(finder.GetCentroid(0, values.data(), 0).loc0 == Approx(-0.25).margin(1e-9));
+}
+
+TEST_CASE("PadClusterFinder centroid and covariance of a 2 pad cluster with unequal ADC", "[PadClustering]") {
+    PadHitIndex index(10, 21, 122);
+    PadClusterFinder finder;
+
+    std::vector<int32_t> plane =   {0,   0};
+    std::vector<int32_t> ring =    {3,   3};
+    std::vector<int32_t> pad =     {10,  11};
+    std::vector<double> time =     {100, 104};
+    std::vector<double> adc =      {1,   3};
+    std::vector<PadClusterValues> values = {
+        {10, 50, 100, 4, 9, 1, 0.5},
+        {14, 46, 104, 8, 1, 1, -0.5}
+    };
+    FindClusters(finder, index, plane, ring, pad, time, adc, 10);
+    REQUIRE(ToVector(finder.GetMembers(0)) == std::vector<uint32_t>{1, 0});
+
+    // w = 3/4 and 1/4, cov = sum(w^2 * cov)
+    const auto centroid = finder.GetCentroid(0, values.data(), 2 * M_PI * 100);
+    REQUIRE(centroid.loc0 == Approx(13));
+    REQUIRE(centroid.loc1 == Approx(47));
+    REQUIRE(centroid.time == Approx(103));
+    REQUIRE(centroid.cov_xx == Approx(9.0 / 16 * 8 + 1.0 / 16 * 4));
+    REQUIRE(centroid.cov_yy == Approx(9.0 / 16 * 1 + 1.0 / 16 * 9));
+    REQUIRE(centroid.cov_tt == Approx(10.0 / 16));
+    REQUIRE(centroid.cov_xy == Approx(-9.0 / 16 * 0.5 + 1.0 / 16 * 0.5));
+
+    // ADC sum is not positive - equal weights
+    adc = {0, 0};
+    FindClusters(finder, index, plane, ring, pad, time, adc, 10);
+    REQUIRE(ToVector(finder.GetMembers(0)) == std::vector<uint32_t>{0, 1});
+    REQUIRE(finder.GetCentroid(0, values.data(), 0).loc0 == Approx(12));
+    REQUIRE(finder.GetCentroid(0, values.data(), 0).cov_xx == Approx(3));
+}
+
+TEST_CASE("PadClusterFinder finds measurements through the index of their hits", "[PadClustering]") {
+    // Hits 0..4, hit 2 has no measurement (e.g. it is off its ring surface)
+    PadHitIndex index(10, 21, 122);
+    std::vector<int32_t> hit_plane =   {0,   0,   0,   0,   0};
+    std::vector<int32_t> hit_ring =    {3,   3,   3,   3,   3};
+    std::vector<int32_t> hit_pad =     {10,  11,  12,  13,  40};
+    std::vector<double> hit_time =     {5,   5,   5,   5,   5};
+    index.Build(hit_plane.size(), hit_plane.data(), hit_ring.data(), hit_pad.data(), hit_time.data());
+
+    // Measurements are in other order than their hits: 0 - hit 3, 1 - hit 0, 2 - hit 1, 3 - hit 4
+    std::vector<uint32_t> hit_measurement = {1, 2, PadClusterFinder::kNoMeasurement, 0};     // Hit 4 is out of the span
+    std::vector<int32_t> plane =   {0,   0,   0,   0};
+    std::vector<int32_t> ring =    {3,   3,   3,   3};
+    std::vector<int32_t> pad =     {13,  10,  11,  40};
+    std::vector<double> time =     {5,   5,   5,   5};
+    std::vector<double> adc =      {1,   1,   2,   1};
+    PadClusterFinder finder;
+    finder.FindClusters(index, hit_measurement, plane.size(), plane.data(), ring.data(), pad.data(), time.data(), adc.data(), 10);
+
+    // Pad 13 is not merged with 11 as pad 12 has no measurement
+    REQUIRE(finder.GetClusterCount() == 3);
+    REQUIRE(ToVector(finder.GetMembers(0)) == std::vector<uint32_t>{0});
+    REQUIRE(ToVector(finder.GetMembers(1)) == std::vector<uint32_t>{2, 1});
+    REQUIRE(ToVector(finder.GetMembers(2)) == std::vector<uint32_t>{3});
+}
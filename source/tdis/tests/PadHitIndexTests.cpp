@@ -0,0 +1,72 @@
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "tracking/PadHitIndex.hpp"
+
+using namespace tdis::tracking;
+
+namespace {
+    std::vector<uint32_t> ToVector(std::span<const uint32_t> hits) {
+        return {hits.begin(), hits.end()};
+    }
+}
+
+TEST_CASE("PadHitIndex buckets hits by pad sorted by time", "[PadHitIndex]") {
+    PadHitIndex index(10, 21, 122);
+
+    //                              0    1    2    3    4    5    6
+    std::vector<int32_t> plane =   {1,   1,   1,   1,   2,   10,  1};
+    std::vector<int32_t> ring =    {4,   4,   4,   4,   4,   4,   -1};
+    std::vector<int32_t> pad =     {7,   7,   8,   7,   7,   7,   7};
+    std::vector<double> time =     {30,  10,  15,  20,  10,  10,  10};
+    index.Build(plane.size(), plane.data(), ring.data(), pad.data(), time.data());
+
+    REQUIRE(index.size() == 5);
+    REQUIRE(index.GetSkippedCount() == 2);
+    REQUIRE(ToVector(index.GetPadHits(1, 4, 7)) == std::vector<uint32_t>{1, 3, 0});
+    REQUIRE(ToVector(index.GetPadHits(1, 4, 8)) == std::vector<uint32_t>{2});
+    REQUIRE(ToVector(index.GetPadHits(2, 4, 7)) == std::vector<uint32_t>{4});
+    REQUIRE(index.GetPadHits(1, 4, 9).empty());
+    REQUIRE(index.GetPadHits(10, 4, 7).empty());
+
+    // Inclusive time window
+    REQUIRE(ToVector(index.GetPadHits(1, 4, 7, 10, 20)) == std::vector<uint32_t>{1, 3});
+    REQUIRE(ToVector(index.GetPadHits(1, 4, 7, 11, 29)) == std::vector<uint32_t>{3});
+    REQUIRE(index.GetPadHits(1, 4, 7, 31, 40).empty());
+
+    // Rebuild drops the previous event. A copy keeps it
+    const auto copy = index.CopyIndex();
+    index.Build(1, plane.data() + 2, ring.data() + 2, pad.data() + 2, time.data() + 2);
+    REQUIRE(index.GetPadHits(1, 4, 7).empty());
+    REQUIRE(ToVector(index.GetPadHits(1, 4, 8)) == std::vector<uint32_t>{0});
+    REQUIRE(copy.size() == 5);
+    REQUIRE(copy.GetSkippedCount() == 2);
+    REQUIRE(ToVector(copy.GetPadHits(1, 4, 7, 10, 20)) == std::vector<uint32_t>{1, 3});
+}
+
+TEST_CASE("PadHitIndex neighborhood wraps around the ring", "[PadHitIndex]") {
+    PadHitIndex index(10, 21, 122);
+
+    //                              0    1    2    3    4    5
+    std::vector<int32_t> plane =   {0,   0,   0,   0,   0,   0};
+    std::vector<int32_t> ring =    {3,   3,   2,   4,   5,   3};
+    std::vector<int32_t> pad =     {121, 0,   1,   120, 0,   2};
+    std::vector<double> time =     {5,   5,   5,   5,   5,   50};
+    index.Build(plane.size(), plane.data(), ring.data(), pad.data(), time.data());
+
+    REQUIRE(ToVector(index.GetPadHits(0, 3, -1)) == std::vector<uint32_t>{0});
+    REQUIRE(ToVector(index.GetPadHits(0, 3, 122)) == std::vector<uint32_t>{1});
+
+    std::vector<uint32_t> near;
+    index.ForEachHitNear(0, 3, 0, 1, 2, 0, 10, [&](uint32_t hit) { near.push_back(hit); });
+    std::sort(near.begin(), near.end());
+    REQUIRE(near == std::vector<uint32_t>{0, 1, 2, 3});
+
+    // Pad distance larger than the ring visits every pad once
+    near.clear();
+    index.ForEachHitNear(0, 3, 0, 0, 200, 0, 100, [&](uint32_t hit) { near.push_back(hit); });
+    std::sort(near.begin(), near.end());
+    REQUIRE(near == std::vector<uint32_t>{0, 1, 5});
+}
@@ -0,0 +1,94 @@
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "tracking/PadOccupancy.h"
+
+using namespace tdis::tracking;
+
+TEST_CASE("PadOccupancyAccumulator merges shards and finds hot pads", "[PadOccupancy]") {
+    PadOccupancyAccumulator accumulator(2, 3, 10);
+    REQUIRE(accumulator.GetOccupancy() == nullptr);
+
+    auto& shard_1 = accumulator.AddShard();
+    auto& shard_2 = accumulator.AddShard();
+
+    // Every pad of plane 1 ring 2 has 2 hits, pad 7 has 100 more. Out of range hits are ignored
+    std::vector<int32_t> plane, ring, pad;
+    std::vector<double> adc;
+    for (int32_t i = 0; i < 10; i++) {
+        plane.push_back(1); ring.push_back(2); pad.push_back(i); adc.push_back(1.5);
+    }
+    plane.push_back(2); ring.push_back(0); pad.push_back(0); adc.push_back(1);
+    shard_1.Fill(plane.size(), plane.data(), ring.data(), pad.data(), adc.data());
+    shard_2.Fill(plane.size(), plane.data(), ring.data(), pad.data(), adc.data());
+
+    std::vector<int32_t> hot_plane(100, 1), hot_ring(100, 2), hot_pad(100, 7);
+    std::vector<double> hot_adc(100, 0.5);
+    shard_2.Fill(100, hot_plane.data(), hot_ring.data(), hot_pad.data(), hot_adc.data());
+
+    auto occupancy = accumulator.Merge(10, 50);
+    REQUIRE(occupancy == accumulator.GetOccupancy());
+    REQUIRE(occupancy->GetVersion() == 1);
+    REQUIRE(occupancy->GetEventCount() == 3);
+    REQUIRE(occupancy->GetHitCount(1, 2, 0) == 2);
+    REQUIRE(occupancy->GetHitCount(1, 2, 7) == 102);
+    REQUIRE(occupancy->GetAdcSum(1, 2, 7) == 53.0);
+    REQUIRE(occupancy->GetHitCount(0, 2, 7) == 0);
+    REQUIRE(occupancy->IsHotPad(1, 2, 7));
+    REQUIRE_FALSE(occupancy->IsHotPad(1, 2, 6));
+    REQUIRE(occupancy->GetHotPads().size() == 1);
+
+    // Not enough hits to be hot
+    REQUIRE(accumulator.Merge(10, 1000)->GetHotPads().empty());
+    REQUIRE(accumulator.GetOccupancy()->GetVersion() == 2);
+}
+
+TEST_CASE("PadOccupancyAccumulator shards are filled while merging", "[PadOccupancy]") {
+    PadOccupancyAccumulator accumulator(1, 1, 4);
+    const int32_t zero = 0;
+    const double adc = 1;
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 4; i++) {
+        auto& shard = accumulator.AddShard();
+        writers.emplace_back([&shard, &zero, &adc]() {
+            for (int event = 0; event < 10000; event++) {
+                shard.Fill(1, &zero, &zero, &zero, &adc);
+            }
+        });
+    }
+    for (int merge = 0; merge < 100; merge++) {
+        REQUIRE(accumulator.Merge(10, 1)->GetHitCount(0, 0, 0) <= 40000);
+    }
+    for (auto& writer: writers) {
+        writer.join();
+    }
+    REQUIRE(accumulator.Merge(10, 1)->GetHitCount(0, 0, 0) == 40000);
+}
+
+TEST_CASE("PadOccupancyAccumulator doesn't mark every hit pad of a sparse ring as hot", "[PadOccupancy]") {
+    PadOccupancyAccumulator accumulator(1, 1, 122);
+    auto& shard = accumulator.AddShard();
+
+    // Tracks cross 30 of 122 pads with 200 hits each (median is 0), pad 100 is noisy with 5000 hits
+    std::vector<int32_t> plane, ring, pad;
+    std::vector<double> adc;
+    for (int32_t i = 0; i < 30; i++) {
+        for (int hit = 0; hit < 200; hit++) {
+            plane.push_back(0); ring.push_back(0); pad.push_back(i); adc.push_back(1);
+        }
+    }
+    for (int hit = 0; hit < 5000; hit++) {
+        plane.push_back(0); ring.push_back(0); pad.push_back(100); adc.push_back(1);
+    }
+    shard.Fill(plane.size(), plane.data(), ring.data(), pad.data(), adc.data());
+
+    // Mean of the other pads is 89.3 for a track pad and 49.6 for the noisy one
+    auto occupancy = accumulator.Merge(10, 100);
+    REQUIRE_FALSE(occupancy->IsHotPad(0, 0, 0));
+    REQUIRE_FALSE(occupancy->IsHotPad(0, 0, 29));
+    REQUIRE(occupancy->IsHotPad(0, 0, 100));
+    REQUIRE(occupancy->GetHotPads().size() == 1);
+}
@@ -0,0 +1,33 @@
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "tracking/RingMeasurementOrder.hpp"
+
+using namespace tdis::tracking;
+
+TEST_CASE("RingMeasurementOrder sorts by ring then along z", "[RingMeasurementOrder]") {
+    RingMeasurementOrder order(21);
+    order.Add(0, 5, 10);
+    order.Add(1, 0, 30);
+    order.Add(2, 5, -10);
+    order.Add(3, 21, 0);     // Out of range rings go last in input order
+    order.Add(4, 20, 0);
+    order.Add(5, -1, 0);
+    order.Add(6, 0, 20);
+
+    REQUIRE(order.Sort(1.0) == std::vector<uint32_t>{6, 1, 2, 0, 4, 3, 5});
+    REQUIRE(order.Sort(-0.5) == std::vector<uint32_t>{1, 6, 0, 2, 4, 3, 5});
+
+    order.Clear();
+    REQUIRE(order.Sort(1.0).empty());
+}
+
+TEST_CASE("RingMeasurementOrder keeps input order of equal measurements", "[RingMeasurementOrder]") {
+    RingMeasurementOrder order(21);
+    for (uint32_t i = 0; i < 4; i++) {
+        order.Add(i, 3, 1.5);
+    }
+    REQUIRE(order.Sort(1.0) == std::vector<uint32_t>{0, 1, 2, 3});
+    REQUIRE(order.Sort(-1.0) == std::vector<uint32_t>{0, 1, 2, 3});
+}
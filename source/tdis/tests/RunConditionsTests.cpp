@@ -0,0 +1,56 @@
+#include <catch2/catch_all.hpp>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+#include "tracking/RunConditions.hpp"
+
+using namespace tdis::tracking;
+
+namespace {
+    const char* kConditions = R"({
+        "defaults": {"time_error": 2.0, "drift_velocity": 0.005, "pad_gain": 1.5},
+        "runs": [
+            {"first_run": 100, "last_run": 199, "z_variance": 4.0,
+             "pad_gains": [[1, 2, 3, 0.5]], "dead_pads": [[0, 0, 121]]},
+            {"first_run": 150, "drift_velocity": [1, 2, 3], "dead_pads": [[2, 20, 0]]}
+        ]
+    })";
+}
+
+TEST_CASE("RunConditions applies matching run ranges over defaults", "[RunConditions]") {
+    const auto json = nlohmann::json::parse(kConditions);
+
+    auto run_1 = RunConditions::FromJson(json, 1, 3, 21, 122);
+    REQUIRE(run_1->GetRunNumber() == 1);
+    REQUIRE(run_1->GetTimeError() == 2.0);
+    REQUIRE(run_1->GetZVariance() == 10.0);
+    REQUIRE(run_1->GetDriftVelocity(2) == 0.005);
+    REQUIRE(run_1->GetPadGain(1, 2, 3) == 1.5f);
+    REQUIRE(run_1->GetDeadPads().empty());
+
+    auto run_120 = RunConditions::FromJson(json, 120, 3, 21, 122);
+    REQUIRE(run_120->GetZVariance() == 4.0);
+    REQUIRE(run_120->GetPadGain(1, 2, 3) == 0.5f);
+    REQUIRE(run_120->GetPadGain(1, 2, 4) == 1.5f);
+    REQUIRE(run_120->GetDriftVelocity(0) == 0.005);
+    REQUIRE(run_120->GetDeadPads().size() == 1);
+
+    // Both entries, the later overrides drift velocity, dead pads are added
+    auto run_150 = RunConditions::FromJson(json, 150, 3, 21, 122);
+    REQUIRE(run_150->GetDriftVelocity(0) == 1);
+    REQUIRE(run_150->GetDriftVelocity(2) == 3);
+    REQUIRE(run_150->GetDeadPads().size() == 2);
+
+    // Open ended range
+    REQUIRE(RunConditions::FromJson(json, 5000, 3, 21, 122)->GetDeadPads().size() == 1);
+}
+
+TEST_CASE("RunConditions rejects values which don't fit the readout", "[RunConditions]") {
+    REQUIRE(RunConditions::FromJson(nlohmann::json::object(), 1, 10, 21, 122)->GetPadGain(9, 20, 121) == 1.0f);
+    REQUIRE_THROWS_AS(RunConditions::FromJson(nlohmann::json::parse(R"({"defaults": {"drift_velocity": [1, 2]}})"), 1, 3, 21, 122),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(RunConditions::FromJson(nlohmann::json::parse(R"({"runs": [{"dead_pads": [[0, 21, 0]]}]})"), 1, 3, 21, 122),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(RunConditions::FromJson(nlohmann::json::parse(R"({"defaults": {"time_error": "1 ns"}})"), 1, 3, 21, 122),
+                      std::invalid_argument);
+}
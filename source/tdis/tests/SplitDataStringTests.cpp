@@ -1,11 +1,10 @@
-#define CATCH_CONFIG_MAIN
 #include <catch2/catch_all.hpp>
 #include <string>
 #include <vector>
 
+#include "io/DigitizedTextParser.hpp"
 
-// Include the SplitDataString function
-// Assuming it is declared in a header file or above the tests
+using namespace tdis::io;
 
 
 TEST_CASE("SplitDataString splits an empty string", "[SplitDataString]") {
@@ -142,7 +141,7 @@ TEST_CASE("SplitDataString handles trailing whitespace", "[SplitDataString]") {
     REQUIRE(result == expected);
 }
 
-TEST_CASE("SplitDataString handles leading and trailing whitespace", "[SplitDataString]") {
+TEST_CASE("SplitDataString handles leading and trailing whitespace around several words", "[SplitDataString]") {
     std::string line = "   word1 word2 word3   ";
     std::vector<std::string> expected = {"word1", "word2", "word3"};
     auto result = SplitDataString(line);
@@ -14,10 +14,12 @@
 #include <Acts/Definitions/Units.hpp>
 #include <Acts/Plugins/Json/JsonMaterialDecorator.hpp>
 #include <Acts/Plugins/Json/MaterialMapJsonConverter.hpp>
+#include <Acts/Surfaces/CylinderBounds.hpp>
 #include <Acts/Visualization/GeometryView3D.hpp>
 #include <Acts/Visualization/ObjVisualization3D.hpp>
 #include <Acts/Visualization/PlyVisualization3D.hpp>
 #include <Acts/Visualization/ViewConfig.hpp>
+#include <algorithm>
 #include <array>
 #include <exception>
 #include <string>
@@ -387,6 +389,37 @@ void tdis::tracking::ActsGeometryService::Init() {
         m_detector_cylinders     // Detector element store
     );
 
+    // Flat per ring cache of surfaces. Geometry identifiers are set by now
+    uint32_t ring_count = 0;
+    for (const auto& [ring, element]: m_detector_cylinders) {
+        ring_count = std::max(ring_count, ring + 1);
+    }
+    m_ring_surfaces.assign(ring_count, RingSurface{});
+    for (const auto& [ring, element]: m_detector_cylinders) {
+        const auto& surface = element->surface();
+        const auto* cylinder_bounds = dynamic_cast<const Acts::CylinderBounds*>(&surface.bounds());
+        if (!cylinder_bounds) {
+            m_init_log->error("Surface of ring {} doesn't have CylinderBounds", ring);
+            exit(1);    // TODO this is due to JANA2 issue #381. Remove after is fixed
+        }
+        m_ring_surfaces[ring] = RingSurface{
+            &surface,
+            surface.geometryId(),
+            cylinder_bounds->get(Acts::CylinderBounds::eR),
+            cylinder_bounds->get(Acts::CylinderBounds::eHalfLengthZ)
+        };
+        m_init_log->debug("Ring {} surface {}: radius = {:.3f} mm, halfLength = {:.3f} mm",
+                          ring, surface.geometryId().value(), m_ring_surfaces[ring].radius, m_ring_surfaces[ring].half_length);
+    }
+
+    // Hit reconstruction uses surfaces of all rings, a missing one is a geometry error
+    for (uint32_t ring = 0; ring < ring_count; ring++) {
+        if (!m_ring_surfaces[ring].surface) {
+            m_init_log->error("No detector element for ring {} of {} rings", ring, ring_count);
+            exit(1);    // TODO this is due to JANA2 issue #381. Remove after is fixed
+        }
+    }
+
 
     // Visualize ACTS geometry
     const Acts::TrackingVolume& tgVolume = *(gGeometry->highestTrackingVolume());
@@ -9,7 +9,9 @@
 #include <TGeoManager.h>
 #include <spdlog/logger.h>
 
+#include <Acts/Geometry/GeometryIdentifier.hpp>
 #include <Acts/Geometry/TrackingGeometry.hpp>
+#include <Acts/Surfaces/Surface.hpp>
 #include <Acts/Visualization/GeometryView3D.hpp>
 #include <memory>
 #include <mutex>
@@ -20,6 +22,14 @@
 namespace tdis::tracking {
     class ActsGeometryService : public JService {
       public:
+        /// Cylinder surface of one ring. Collected once in Init, so per hit code needs no map lookups, casts or strings
+        struct RingSurface {
+            const Acts::Surface* surface = nullptr;
+            Acts::GeometryIdentifier geometry_id;
+            double radius = 0;          // mm
+            double half_length = 0;     // mm
+        };
+
         explicit ActsGeometryService() : JService() {}
         ~ActsGeometryService() override = default;
 
@@ -44,6 +54,12 @@ namespace tdis::tracking {
             return m_detector_cylinders.at(index);
         }
 
+        /// Ring surfaces indexed by ring. Surfaces are owned by detector elements and live as long as the service
+        const std::vector<RingSurface>& GetRingSurfaces() const { return m_ring_surfaces; }
+
+        /// Ring must be less than GetRingSurfaces().size()
+        const RingSurface& GetRingSurface(size_t ring) const { return m_ring_surfaces[ring]; }
+
         std::shared_ptr<const Acts::TrackingGeometry> GetTrackingGeometry() const {
             return gGeometry;
         }
@@ -75,6 +91,9 @@ namespace tdis::tracking {
         // std::vector<std::shared_ptr<tdis::tracking::MtpcDetectorElement>> m_detector_elements;
         std::unordered_map<uint32_t, std::shared_ptr<MtpcDetectorElement>> m_detector_cylinders;
 
+        /// Flat copy of m_detector_cylinders surfaces data by ring
+        std::vector<RingSurface> m_ring_surfaces;
+
         std::shared_ptr<const Acts::TrackingGeometry> gGeometry;
 
         // Plane positions
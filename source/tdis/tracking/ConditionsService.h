@@ -0,0 +1,97 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  ConditionsService gives per run constants (see RunConditions.hpp for the file format)
+ *
+ *  The file is read and parsed once in Init. A RunConditions snapshot is built on the first request of
+ *  a run and then shared by all factories of all threads. The lock is taken only in GetRunConditions,
+ *  which factories call from ChangeRun, so event processing never waits on it:
+ *
+ *      void ChangeRun(int32_t run_nr) { m_conditions = m_service_conditions->GetRunConditions(run_nr); }
+ *      void Execute(...) { ... m_conditions->GetPadGain(plane, ring, pad) ... }
+ *
+ *  Configuration Parameters
+ *    - conditions:file (std::string, default empty):
+ *        JSON file with run conditions. Empty - defaults for all runs
+ */
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JException.h>
+#include <JANA/Services/JServiceLocator.h>
+#include <spdlog/logger.h>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ActsGeometryService.h"
+#include "PadGeometryHelper.hpp"
+#include "RunConditions.hpp"
+#include "services/LogService.hpp"
+
+namespace tdis::tracking {
+
+    class ConditionsService : public JService {
+    public:
+        explicit ConditionsService() : JService() {}
+        ~ConditionsService() override = default;
+
+        void Init() override {
+            m_log = m_service_log->logger("conditions");
+            m_plane_count = m_service_geometry->GetPlanePositions().size();
+
+            if (m_file().empty()) {
+                m_log->info("conditions:file is not set, default conditions are used for all runs");
+                return;
+            }
+
+            std::ifstream file(m_file());
+            if (!file) {
+                throw JException(fmt::format("Can't open conditions:file '{}'", m_file()));
+            }
+            try {
+                m_json = nlohmann::json::parse(file, nullptr, true, true);     // Allow comments
+            } catch (const nlohmann::json::exception& e) {
+                throw JException(fmt::format("Can't parse conditions:file '{}': {}", m_file(), e.what()));
+            }
+            m_log->info("Conditions are loaded from '{}'", m_file());
+        }
+
+        /// Snapshot of the run conditions. It is built once per run, the same object is returned to all callers
+        std::shared_ptr<const RunConditions> GetRunConditions(int32_t run_number) {
+            std::lock_guard<std::mutex> locker(m_lock);
+            auto& conditions = m_run_conditions[run_number];
+            if (!conditions) {
+                try {
+                    conditions = RunConditions::FromJson(m_json, run_number, m_plane_count, num_rings, num_pads_per_ring);
+                } catch (const std::invalid_argument& e) {
+                    m_run_conditions.erase(run_number);
+                    throw JException(fmt::format("Bad conditions for run {} in '{}': {}", run_number, m_file(), e.what()));
+                }
+                m_log->debug("Run {} conditions: time error {} ns, z variance {} mm^2, {} dead pads",
+                             run_number, conditions->GetTimeError(), conditions->GetZVariance(),
+                             conditions->GetDeadPads().size());
+            }
+            return conditions;
+        }
+
+    private:
+        Parameter<std::string> m_file{this, "conditions:file", "", "JSON file with run conditions. Empty - defaults for all runs"};
+
+        Service<ActsGeometryService> m_service_geometry{this};
+        Service<tdis::services::LogService> m_service_log{this};
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        size_t m_plane_count = 0;
+        nlohmann::json m_json = nlohmann::json::object();
+
+        std::mutex m_lock;
+        std::map<int32_t, std::shared_ptr<const RunConditions>> m_run_conditions;
+    };
+}   // namespace tdis::tracking
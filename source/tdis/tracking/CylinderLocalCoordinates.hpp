@@ -0,0 +1,84 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Closed form global to local conversion for the ring cylinders of buildCylindricalDetector
+ *
+ *  Ring surfaces are cylinders with the identity transform: the axis is the global z axis and the
+ *  center is at the origin. For such a cylinder of radius R, Acts::CylinderSurface::globalToLocal
+ *  of a global point (x, y, z) is exactly
+ *
+ *      loc0 = R * atan2(y, x)      loc1 = z
+ *
+ *  and the point is on the surface if |sqrt(x^2 + y^2) - R| <= tolerance.
+ *
+ *  Here all hits of an event are converted at once, and a point off its surface gets a status code
+ *  instead of a thrown exception (what Result::value() does in Acts), so a miss costs as much as a hit.
+ **/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tdis::tracking {
+
+    enum class LocalCoordinatesStatus : uint8_t {
+        Success = 0,
+        OffSurface = 1      // Distance from the point to the cylinder is more than tolerance
+    };
+
+    /** Points on ring cylinders in structure of arrays. Inputs are (radius, x, y, z), outputs are (loc0, loc1, status)
+     *  Keep an instance between events to reuse allocated memory */
+    struct CylinderPointBatch {
+        std::vector<double> radius;     // mm, radius of the cylinder the point belongs to
+        std::vector<double> x;          // mm
+        std::vector<double> y;          // mm
+        std::vector<double> z;          // mm
+        std::vector<double> loc0;       // mm, R*phi
+        std::vector<double> loc1;       // mm, z
+        std::vector<LocalCoordinatesStatus> status;
+
+        size_t size() const { return radius.size(); }
+
+        void clear() {
+            radius.clear(); x.clear(); y.clear(); z.clear();
+            loc0.clear(); loc1.clear(); status.clear();
+        }
+
+        void push_back(double point_radius, double point_x, double point_y, double point_z) {
+            radius.push_back(point_radius);
+            x.push_back(point_x);
+            y.push_back(point_y);
+            z.push_back(point_z);
+        }
+    };
+
+    /** Local coordinates of one point on a cylinder with the identity transform */
+    inline LocalCoordinatesStatus CylinderGlobalToLocal(double radius, double x, double y, double z, double tolerance,
+                                                        double& loc0, double& loc1) {
+        loc0 = radius * std::atan2(y, x);
+        loc1 = z;
+        const double r = std::sqrt(x * x + y * y);
+        return std::abs(r - radius) <= tolerance ? LocalCoordinatesStatus::Success : LocalCoordinatesStatus::OffSurface;
+    }
+
+    /** Fills loc0, loc1 and status for all points of the batch. Returns the number of points off their surfaces */
+    inline size_t CylinderGlobalToLocal(CylinderPointBatch& batch, double tolerance) {
+        const size_t count = batch.size();
+        batch.loc0.resize(count);
+        batch.loc1.resize(count);
+        batch.status.resize(count);
+
+        size_t off_surface = 0;
+        for (size_t i = 0; i < count; i++) {
+            batch.status[i] = CylinderGlobalToLocal(batch.radius[i], batch.x[i], batch.y[i], batch.z[i], tolerance,
+                                                    batch.loc0[i], batch.loc1[i]);
+            off_surface += batch.status[i] != LocalCoordinatesStatus::Success;
+        }
+        return off_surface;
+    }
+
+}   // namespace tdis::tracking
@@ -0,0 +1,124 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  DistortionCorrectionService loads the drift distortion map (see DistortionMap.h) once and gives it
+ *  to hit reconstruction. Without a map file there is no correction.
+ *
+ *  Map file is text, units are mm. Text after # is a comment. The first line is the grid:
+ *      r_min r_max r_count phi_count z_min z_max z_count
+ *  then r_count * phi_count * z_count lines of node displacements, r index changes slowest and z fastest:
+ *      dx dy dz
+ *  phi nodes are 2π/phi_count apart starting from phi = 0.
+ *
+ *  Configuration Parameters
+ *    - tracking:distortion_map (std::string, default empty):
+ *        Distortion map file. Empty - hit positions are not corrected
+ */
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JException.h>
+#include <JANA/Services/JServiceLocator.h>
+#include <spdlog/logger.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "DistortionMap.h"
+#include "services/LogService.hpp"
+
+namespace tdis::tracking {
+
+    class DistortionCorrectionService : public JService {
+    public:
+        explicit DistortionCorrectionService() : JService() {}
+        ~DistortionCorrectionService() override = default;
+
+        void Init() override {
+            m_log = m_service_log->logger("tracking:distortion");
+            if (m_map_file().empty()) {
+                m_log->info("tracking:distortion_map is not set, hit positions are not corrected for distortions");
+                return;
+            }
+            ReadMap(m_map_file());
+            m_log->info("Distortion map '{}': r {}..{} mm x {} nodes, {} phi nodes, z {}..{} mm x {} nodes",
+                        m_map_file(), m_map.GetRMin(), m_map.GetRMax(), m_map.GetRCount(), m_map.GetPhiCount(),
+                        m_map.GetZMin(), m_map.GetZMax(), m_map.GetZCount());
+        }
+
+        /// True if a map is loaded
+        bool IsEnabled() const { return !m_map.IsEmpty(); }
+
+        const DistortionMap& GetMap() const { return m_map; }
+
+        /// Corrects positions of count points in place. See DistortionMap::Correct
+        void Correct(size_t count, const double* r, const double* phi, double* x, double* y, double* z) const {
+            m_map.Correct(count, r, phi, x, y, z);
+        }
+
+    private:
+        Parameter<std::string> m_map_file{this, "tracking:distortion_map", "",
+            "Drift distortion map file with (r, phi, z) grid of dx dy dz in mm. Empty - no correction"};
+
+        Service<tdis::services::LogService> m_service_log{this};
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        DistortionMap m_map;
+
+        /// Next line without comment, which is not empty. Returns false at the end of the file
+        static bool ReadDataLine(std::ifstream& file, std::string& line, size_t& line_number) {
+            while (std::getline(file, line)) {
+                line_number++;
+                line = line.substr(0, line.find('#'));
+                if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void ReadMap(const std::string& file_name) {
+            std::ifstream file(file_name);
+            if (!file) {
+                throw JException(fmt::format("Can't open tracking:distortion_map '{}'", file_name));
+            }
+
+            std::string line;
+            size_t line_number = 0;
+            double r_min, r_max, z_min, z_max;
+            size_t r_count, phi_count, z_count;
+            std::istringstream grid_tokens(ReadDataLine(file, line, line_number) ? line : "");
+            if (!(grid_tokens >> r_min >> r_max >> r_count >> phi_count >> z_min >> z_max >> z_count)) {
+                throw JException(fmt::format("{}:{} should be 'r_min r_max r_count phi_count z_min z_max z_count', got '{}'",
+                                             file_name, line_number, line));
+            }
+            try {
+                m_map = DistortionMap(r_min, r_max, r_count, phi_count, z_min, z_max, z_count);
+            } catch (const std::invalid_argument& e) {
+                throw JException(fmt::format("{}:{} bad distortion grid: {}", file_name, line_number, e.what()));
+            }
+
+            for (size_t r_index = 0; r_index < r_count; r_index++) {
+                for (size_t phi_index = 0; phi_index < phi_count; phi_index++) {
+                    for (size_t z_index = 0; z_index < z_count; z_index++) {
+                        float dx, dy, dz;
+                        const bool has_line = ReadDataLine(file, line, line_number);
+                        std::istringstream tokens(has_line ? line : "");
+                        if (!(tokens >> dx >> dy >> dz)) {
+                            throw JException(fmt::format("{}:{} should be 'dx dy dz' of node r={} phi={} z={}, got '{}'",
+                                                         file_name, line_number, r_index, phi_index, z_index,
+                                                         has_line ? line : "end of file"));
+                        }
+                        m_map.SetNode(r_index, phi_index, z_index, dx, dy, dz);
+                    }
+                }
+            }
+        }
+    };
+}   // namespace tdis::tracking
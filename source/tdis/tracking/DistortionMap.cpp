@@ -0,0 +1,154 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "DistortionMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__x86_64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define TDIS_DISTORTION_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define TDIS_DISTORTION_CLONES
+#endif
+
+namespace tdis::tracking {
+
+    namespace {
+        /// Everything the loop reads, so it can be a free function with clones
+        struct GridArrays {
+            double r_min;
+            double r_scale;         // Nodes per mm
+            double r_last;          // Index of the last node
+            double phi_scale;       // Nodes per radian
+            double phi_count;
+            double z_min;
+            double z_scale;
+            double z_last;
+            int32_t phi_count_int;
+            int32_t z_cells;
+            const float* cells;
+        };
+
+        /// Node coordinate u to the cell index and the fraction inside it. u is clamped to the grid
+        inline void Locate(double u, double last, int32_t& index, double& fraction) {
+            u = std::min(std::max(u, 0.0), last);
+            index = std::min(static_cast<int32_t>(u), static_cast<int32_t>(last) - 1);
+            fraction = u - index;
+        }
+
+        TDIS_DISTORTION_CLONES
+        void Interpolate(const GridArrays& grid, size_t count,
+                         const double* __restrict r, const double* __restrict phi,
+                         double* __restrict x, double* __restrict y, double* __restrict z) {
+            // Local copies, so the compiler sees they don't change while points are written
+            const double r_min = grid.r_min;
+            const double r_scale = grid.r_scale;
+            const double r_last = grid.r_last;
+            const double phi_scale = grid.phi_scale;
+            const double phi_count = grid.phi_count;
+            const double z_min = grid.z_min;
+            const double z_scale = grid.z_scale;
+            const double z_last = grid.z_last;
+            const int32_t phi_count_int = grid.phi_count_int;
+            const int32_t z_cells = grid.z_cells;
+            const float* __restrict cells = grid.cells;
+
+            for (size_t i = 0; i < count; i++) {
+                int32_t r_index, z_index;
+                double r_fraction, z_fraction;
+                Locate((r[i] - r_min) * r_scale, r_last, r_index, r_fraction);
+                Locate((z[i] - z_min) * z_scale, z_last, z_index, z_fraction);
+
+                // phi wraps: the last cell goes from the last node to node 0. Integer floor, std::floor is not vectorized
+                double phi_u = phi[i] * phi_scale;
+                const double turns = phi_u / phi_count;
+                int32_t whole_turns = static_cast<int32_t>(turns);
+                whole_turns -= (turns < whole_turns) ? 1 : 0;
+                phi_u -= phi_count * whole_turns;
+                const int32_t phi_index = std::min(static_cast<int32_t>(phi_u), phi_count_int - 1);
+                const double phi_fraction = phi_u - phi_index;
+
+                // 32 bit offset, so the corner loads are vectorized as gathers
+                const int32_t cell = ((r_index * phi_count_int + phi_index) * z_cells + z_index) * 24;
+
+                double dx = 0, dy = 0, dz = 0;
+                for (int corner = 0; corner < 8; corner++) {
+                    const double weight = ((corner & 4) ? r_fraction : 1.0 - r_fraction) *
+                                          ((corner & 2) ? phi_fraction : 1.0 - phi_fraction) *
+                                          ((corner & 1) ? z_fraction : 1.0 - z_fraction);
+                    dx += weight * cells[cell + corner];
+                    dy += weight * cells[cell + 8 + corner];
+                    dz += weight * cells[cell + 16 + corner];
+                }
+                x[i] += dx;
+                y[i] += dy;
+                z[i] += dz;
+            }
+        }
+    }   // namespace
+
+    DistortionMap::DistortionMap(double r_min, double r_max, size_t r_count, size_t phi_count,
+                                 double z_min, double z_max, size_t z_count):
+        m_r_count(r_count), m_phi_count(phi_count), m_z_count(z_count),
+        m_r_min(r_min), m_r_max(r_max), m_z_min(z_min), m_z_max(z_max) {
+        if (r_count < 2 || z_count < 2 || phi_count < 1 || !(r_max > r_min) || !(z_max > z_min)) {
+            throw std::invalid_argument("DistortionMap needs at least 2 nodes in r and z, 1 in phi and non empty r and z ranges");
+        }
+        m_cells.assign(GetCellCount() * kCellSize, 0.0f);
+    }
+
+    bool DistortionMap::SetNode(size_t r_index, size_t phi_index, size_t z_index, float dx, float dy, float dz) {
+        if (r_index >= m_r_count || phi_index >= m_phi_count || z_index >= m_z_count) {
+            return false;
+        }
+
+        // The node is a corner of up to 8 cells
+        for (size_t corner = 0; corner < 8; corner++) {
+            const size_t r_shift = (corner >> 2) & 1;
+            const size_t phi_shift = (corner >> 1) & 1;
+            const size_t z_shift = corner & 1;
+            if (r_index < r_shift || r_index - r_shift >= m_r_count - 1) continue;
+            if (z_index < z_shift || z_index - z_shift >= m_z_count - 1) continue;
+            const size_t cell_r = r_index - r_shift;
+            const size_t cell_phi = (phi_index + m_phi_count - phi_shift) % m_phi_count;
+            const size_t cell_z = z_index - z_shift;
+
+            float* cell = m_cells.data() + ((cell_r * m_phi_count + cell_phi) * (m_z_count - 1) + cell_z) * kCellSize;
+            cell[corner] = dx;
+            cell[8 + corner] = dy;
+            cell[16 + corner] = dz;
+        }
+        return true;
+    }
+
+    void DistortionMap::GetDisplacement(double r, double phi, double z, double& dx, double& dy, double& dz) const {
+        double x = 0, y = 0, shifted_z = z;
+        Correct(1, &r, &phi, &x, &y, &shifted_z);
+        dx = x;
+        dy = y;
+        dz = shifted_z - z;
+    }
+
+    void DistortionMap::Correct(size_t count, const double* r, const double* phi, double* x, double* y, double* z) const {
+        if (IsEmpty() || count == 0) {
+            return;
+        }
+
+        GridArrays grid;
+        grid.r_min = m_r_min;
+        grid.r_last = static_cast<double>(m_r_count - 1);
+        grid.r_scale = grid.r_last / (m_r_max - m_r_min);
+        grid.phi_count = static_cast<double>(m_phi_count);
+        grid.phi_scale = grid.phi_count / (2 * M_PI);
+        grid.z_min = m_z_min;
+        grid.z_last = static_cast<double>(m_z_count - 1);
+        grid.z_scale = grid.z_last / (m_z_max - m_z_min);
+        grid.phi_count_int = static_cast<int32_t>(m_phi_count);
+        grid.z_cells = static_cast<int32_t>(m_z_count - 1);
+        grid.cells = m_cells.data();
+        Interpolate(grid, count, r, phi, x, y, z);
+    }
+
+}   // namespace tdis::tracking
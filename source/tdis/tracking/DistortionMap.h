@@ -0,0 +1,75 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Drift distortion (space charge, field non-uniformity) displacements on a (r, phi, z) grid
+ *
+ *  Nodes are r_min..r_max and z_min..z_max with r_count and z_count nodes, and phi_count nodes over
+ *  [0, 2π) which wrap around. Each node has a (dx, dy, dz) displacement in global cartesian coordinates,
+ *  so a correction is position + displacement and needs no trigonometry. Between nodes displacements
+ *  are trilinearly interpolated. Outside r and z range the border values are used.
+ *
+ *  Layout: each grid cell keeps the displacements of its 8 corners together (8 dx, 8 dy, 8 dz floats,
+ *  96 bytes). An interpolation then reads 2 cache lines at one computed address instead of 8 rows
+ *  far apart in a node array. The price is 8 times the memory of node values, which is fine for typical
+ *  maps of tens of nodes per axis.
+ *
+ *  Correct() processes a batch of points with no branches. The loop is vectorized and is built for
+ *  AVX-512, AVX2 and baseline with the best one selected at load time (as HitFilterMask).
+ **/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tdis::tracking {
+
+    class DistortionMap {
+    public:
+        /// Empty map, IsEmpty() is true
+        DistortionMap() = default;
+
+        /// All displacements are 0. r_count and z_count must be >= 2, phi_count >= 1, r_max > r_min, z_max > z_min
+        DistortionMap(double r_min, double r_max, size_t r_count, size_t phi_count, double z_min, double z_max, size_t z_count);
+
+        bool IsEmpty() const { return m_cells.empty(); }
+
+        size_t GetRCount() const { return m_r_count; }
+        size_t GetPhiCount() const { return m_phi_count; }
+        size_t GetZCount() const { return m_z_count; }
+        double GetRMin() const { return m_r_min; }
+        double GetRMax() const { return m_r_max; }
+        double GetZMin() const { return m_z_min; }
+        double GetZMax() const { return m_z_max; }
+
+        /// Sets displacement of node (r_index, phi_index, z_index). Returns false if the node is out of the grid
+        bool SetNode(size_t r_index, size_t phi_index, size_t z_index, float dx, float dy, float dz);
+
+        /// Interpolated displacement at one point. phi in radians, any range
+        void GetDisplacement(double r, double phi, double z, double& dx, double& dy, double& dz) const;
+
+        /// Adds displacements at (r[i], phi[i], z[i]) to x[i], y[i], z[i] of count points. r and phi are
+        /// cylindrical coordinates of the uncorrected point (e.g. pad center), given to avoid atan2 per point
+        void Correct(size_t count, const double* r, const double* phi, double* x, double* y, double* z) const;
+
+    private:
+        static constexpr size_t kCellSize = 24;     // 8 corners x (dx, dy, dz)
+
+        size_t GetCellCount() const { return (m_r_count - 1) * m_phi_count * (m_z_count - 1); }
+
+        size_t m_r_count = 0;
+        size_t m_phi_count = 0;
+        size_t m_z_count = 0;
+        double m_r_min = 0;
+        double m_r_max = 0;
+        double m_z_min = 0;
+        double m_z_max = 0;
+
+        // Cell (r, phi, z) is at ((r * phi_count + phi) * (z_count - 1) + z) * kCellSize. Corner k = 4*dr + 2*dphi + dz
+        // of the cell has dx at k, dy at 8 + k and dz at 16 + k
+        std::vector<float> m_cells;
+    };
+
+}   // namespace tdis::tracking
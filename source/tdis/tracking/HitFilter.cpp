@@ -0,0 +1,141 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "HitFilter.h"
+
+#include <bit>
+
+#if defined(__x86_64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define TDIS_HIT_FILTER_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define TDIS_HIT_FILTER_CLONES
+#endif
+
+namespace tdis::tracking {
+
+    namespace {
+        /// Everything the loop reads, so it can be a free function with clones
+        struct FilterArrays {
+            uint32_t plane_count;
+            uint32_t ring_count;
+            uint32_t pads_per_ring;
+            double adc_min;
+            const double* time_min;
+            const double* time_max;
+            const uint32_t* dead_pads;
+        };
+
+        /// Writes 1 for kept and 0 for rejected hits. No loop carried dependencies, so the loop is vectorized
+        TDIS_HIT_FILTER_CLONES
+        void EvaluateCuts(const FilterArrays& cuts, size_t count,
+                          const int32_t* __restrict plane, const int32_t* __restrict ring, const int32_t* __restrict pad,
+                          const double* __restrict time, const double* __restrict adc, uint32_t* __restrict keep) {
+            // Local copies, so the compiler sees they don't change while keep is written
+            const uint32_t plane_count = cuts.plane_count;
+            const uint32_t ring_count = cuts.ring_count;
+            const uint32_t pads_per_ring = cuts.pads_per_ring;
+            const double adc_min = cuts.adc_min;
+            const double* __restrict time_min = cuts.time_min;
+            const double* __restrict time_max = cuts.time_max;
+            const uint32_t* __restrict dead_pads = cuts.dead_pads;
+
+            for (size_t i = 0; i < count; i++) {
+                const auto hit_plane = static_cast<uint32_t>(plane[i]);
+                const auto hit_ring = static_cast<uint32_t>(ring[i]);
+                const auto hit_pad = static_cast<uint32_t>(pad[i]);
+
+                // Negative indexes become huge unsigned values and fail the range check
+                const uint32_t in_range = (hit_plane < plane_count) & (hit_ring < ring_count) & (hit_pad < pads_per_ring);
+                const uint32_t index_mask = 0u - in_range;      // All ones if in range, out of range indexes become 0
+                const uint32_t safe_plane = hit_plane & index_mask;
+                const uint32_t bit = ((hit_plane * ring_count + hit_ring) * pads_per_ring + hit_pad) & index_mask;
+                const double hit_time = time[i];
+                const double window_min = time_min[safe_plane];
+                const double window_max = time_max[safe_plane];
+                const uint32_t dead_word = dead_pads[bit >> 5];
+
+                // Each cut is turned to 0/1 separately, a single && or & chain is compiled to branches
+                uint32_t keep_hit = in_range;
+                keep_hit &= (adc[i] >= adc_min) ? 1u : 0u;
+                keep_hit &= (hit_time >= window_min) ? 1u : 0u;
+                keep_hit &= (hit_time <= window_max) ? 1u : 0u;
+                keep_hit &= ~(dead_word >> (bit & 31)) & 1u;
+                keep[i] = keep_hit;
+            }
+        }
+
+        /// Replaces keep flags with indexes of kept hits. Every index is written, the position advances by the flag
+        size_t CompactSelected(size_t count, uint32_t* selected) {
+            size_t kept = 0;
+            for (size_t i = 0; i < count; i++) {
+                const uint32_t keep = selected[i];      // kept <= i, so the flag is read before it is overwritten
+                selected[kept] = static_cast<uint32_t>(i);
+                kept += keep;
+            }
+            return kept;
+        }
+    }   // namespace
+
+    HitFilterMask::HitFilterMask(size_t plane_count, size_t ring_count, size_t pads_per_ring):
+        m_ring_count(ring_count),
+        m_pads_per_ring(pads_per_ring),
+        m_time_min(plane_count, -std::numeric_limits<double>::infinity()),
+        m_time_max(plane_count, std::numeric_limits<double>::infinity()),
+        m_dead_pads((plane_count * ring_count * pads_per_ring + 31) / 32 + 1, 0) {
+    }
+
+    bool HitFilterMask::SetDeadPad(int plane, int ring, int pad, bool is_dead) {
+        if (static_cast<size_t>(plane) >= GetPlaneCount() || static_cast<size_t>(ring) >= m_ring_count ||
+            static_cast<size_t>(pad) >= m_pads_per_ring) {
+            return false;
+        }
+        const size_t bit = (plane * m_ring_count + ring) * m_pads_per_ring + pad;
+        if (is_dead) {
+            m_dead_pads[bit >> 5] |= uint32_t{1} << (bit & 31);
+        } else {
+            m_dead_pads[bit >> 5] &= ~(uint32_t{1} << (bit & 31));
+        }
+        return true;
+    }
+
+    bool HitFilterMask::IsDeadPad(int plane, int ring, int pad) const {
+        if (static_cast<size_t>(plane) >= GetPlaneCount() || static_cast<size_t>(ring) >= m_ring_count ||
+            static_cast<size_t>(pad) >= m_pads_per_ring) {
+            return false;
+        }
+        const size_t bit = (plane * m_ring_count + ring) * m_pads_per_ring + pad;
+        return (m_dead_pads[bit >> 5] >> (bit & 31)) & 1;
+    }
+
+    size_t HitFilterMask::GetDeadPadCount() const {
+        size_t dead_count = 0;
+        for (auto word: m_dead_pads) {
+            dead_count += std::popcount(word);
+        }
+        return dead_count;
+    }
+
+    size_t HitFilterMask::FilterHits(size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad,
+                                     const double* time, const double* adc, std::vector<uint32_t>& selected) const {
+        if (m_time_min.empty()) {
+            selected.clear();
+            return 0;
+        }
+
+        selected.resize(count);
+        const FilterArrays cuts{
+            static_cast<uint32_t>(GetPlaneCount()),
+            static_cast<uint32_t>(m_ring_count),
+            static_cast<uint32_t>(m_pads_per_ring),
+            m_adc_min,
+            m_time_min.data(),
+            m_time_max.data(),
+            m_dead_pads.data()
+        };
+        EvaluateCuts(cuts, count, plane, ring, pad, time, adc, selected.data());
+        const size_t kept = CompactSelected(count, selected.data());
+        selected.resize(kept);
+        return kept;
+    }
+
+}   // namespace tdis::tracking
@@ -0,0 +1,72 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Early selection of digitized hits before reconstruction
+ *
+ *  A hit is kept if all is true:
+ *      - plane, ring and pad are in range
+ *      - adc >= adc_min
+ *      - time_min[plane] <= time <= time_max[plane]
+ *      - the pad is not in the dead (or noisy) pad mask
+ *
+ *  The mask is one bit per (plane, ring, pad), all planes x num_rings x num_pads_per_ring pads
+ *  (25,620 for 10 planes), so it fits L1 cache. FilterHits has no data dependent branches. The first
+ *  pass evaluates all cuts with bitwise ands, with out of range indexes masked to 0. It has
+ *  no loop carried dependencies, so it is vectorized, and it is built for AVX-512, AVX2 and baseline
+ *  with the best one selected at load time. The second pass writes the index of every hit and advances
+ *  the output position by the keep flag.
+ **/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace tdis::tracking {
+
+    class HitFilterMask {
+    public:
+        HitFilterMask() = default;
+
+        /// All cuts open: no dead pads, any ADC and time
+        HitFilterMask(size_t plane_count, size_t ring_count, size_t pads_per_ring);
+
+        size_t GetPlaneCount() const { return m_time_min.size(); }
+        size_t GetRingCount() const { return m_ring_count; }
+        size_t GetPadsPerRing() const { return m_pads_per_ring; }
+        size_t GetPadCount() const { return GetPlaneCount() * m_ring_count * m_pads_per_ring; }
+
+        void SetAdcMin(double adc_min) { m_adc_min = adc_min; }
+        double GetAdcMin() const { return m_adc_min; }
+
+        /// Plane must be less than GetPlaneCount()
+        void SetTimeWindow(size_t plane, double time_min, double time_max) {
+            m_time_min[plane] = time_min;
+            m_time_max[plane] = time_max;
+        }
+
+        /// Returns false if plane, ring or pad is out of range
+        bool SetDeadPad(int plane, int ring, int pad, bool is_dead = true);
+        bool IsDeadPad(int plane, int ring, int pad) const;
+        void ClearDeadPads() { std::fill(m_dead_pads.begin(), m_dead_pads.end(), 0u); }
+        size_t GetDeadPadCount() const;
+
+        /// Selects hits which pass the cuts. Indexes of kept hits are written to selected (resized to their count).
+        /// All arrays have count elements. Returns the number of kept hits
+        size_t FilterHits(size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad,
+                          const double* time, const double* adc, std::vector<uint32_t>& selected) const;
+
+    private:
+        size_t m_ring_count = 0;
+        size_t m_pads_per_ring = 0;
+        double m_adc_min = -std::numeric_limits<double>::infinity();
+        std::vector<double> m_time_min;
+        std::vector<double> m_time_max;
+        std::vector<uint32_t> m_dead_pads;     // Bit (plane * ring_count + ring) * pads_per_ring + pad. 32 bit words are gathered by SIMD
+    };
+
+}   // namespace tdis::tracking
@@ -0,0 +1,213 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Drops noise and out of time digitized hits before hit reconstruction
+ *
+ *  Output is a subset collection of DigitizedMtpcMcHit, so hits keep their ids and relations
+ *  to tracks. Cuts are done by HitFilterMask (see HitFilter.h). Hits after the pad == -999 end marker
+ *  are not taken, as in ReconstructedHitFactory.
+ *
+ *  Configuration Parameters
+ *    - tracking:hit_filter:adc_min (double, default 0):
+ *        Minimal hit ADC
+ *
+ *    - tracking:hit_filter:time_min, tracking:hit_filter:time_max (std::vector<double>, default - no cut):
+ *        ns, drift time window. One value is used for all planes, or a comma separated value for each plane
+ *
+ *    - tracking:hit_filter:dead_pads_file (std::string, default empty):
+ *        Text file with "plane ring pad" of dead or noisy pads per line. Text after # is a comment
+ *
+ *    - tracking:hit_filter:hot_pads (bool, default false):
+ *        Fill online occupancy with all input hits and mask hot pads it finds (see PadOccupancyService).
+ *        The mask is updated on every occupancy merge
+ *
+ *  Dead pads of the run conditions (see ConditionsService) are added to the dead_pads_file ones in ChangeRun.
+ *  Hot pads are added when a new occupancy is merged.
+ *
+ *  The factory is wired in tdis_main.cpp if tracking:hit_filter=true. ReconstructedHitFactory then reads
+ *  FilteredDigitizedMtpcMcHit.
+ **/
+
+#pragma once
+
+#include <JANA/Components/JOmniFactory.h>
+#include <JANA/JException.h>
+#include <JANA/JFactory.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ActsGeometryService.h"
+#include "ConditionsService.h"
+#include "HitFilter.h"
+#include "PadGeometryHelper.hpp"
+#include "PadOccupancyService.h"
+#include "podio_model/DigitizedMtpcMcHit.h"
+#include "podio_model/DigitizedMtpcMcHitCollection.h"
+#include "services/LogService.hpp"
+
+namespace tdis::tracking {
+
+    struct HitFilterFactory : public JOmniFactory<HitFilterFactory> {
+        PodioInput<tdis::DigitizedMtpcMcHit>  m_mc_hits_in{this, {"DigitizedMtpcMcHit"}};
+        PodioOutput<tdis::DigitizedMtpcMcHit> m_mc_hits_out{this, "FilteredDigitizedMtpcMcHit"};
+
+        Service<ActsGeometryService> m_service_geometry{this};
+        Service<services::LogService> m_service_log{this};
+        Service<ConditionsService> m_service_conditions{this};
+        Service<PadOccupancyService> m_service_occupancy{this};
+
+        Parameter<double> m_cfg_adc_min{this, "tracking:hit_filter:adc_min", 0.0, "Minimal hit ADC"};
+        Parameter<std::vector<double>> m_cfg_time_min{this, "tracking:hit_filter:time_min", {},
+            "ns, hit time window start. One value for all planes or a value per plane. Empty - no cut"};
+        Parameter<std::vector<double>> m_cfg_time_max{this, "tracking:hit_filter:time_max", {},
+            "ns, hit time window end. One value for all planes or a value per plane. Empty - no cut"};
+        Parameter<std::string> m_cfg_dead_pads_file{this, "tracking:hit_filter:dead_pads_file", "",
+            "Text file with 'plane ring pad' of dead or noisy pads per line"};
+        Parameter<bool> m_cfg_hot_pads{this, "tracking:hit_filter:hot_pads", false,
+            "Accumulate pad occupancy and mask hot pads found in it"};
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        HitFilterMask m_mask;
+        std::vector<std::tuple<int, int, int>> m_file_dead_pads;    // From tracking:hit_filter:dead_pads_file
+        std::shared_ptr<const RunConditions> m_conditions;
+        PadOccupancyAccumulator::Shard* m_occupancy_shard = nullptr;    // This factory counters, if hot_pads is on
+        std::shared_ptr<const PadOccupancy> m_occupancy;                // Occupancy which hot pads are in the mask
+
+        // SoA columns of the event hits, reused between events
+        std::vector<int32_t> m_plane;
+        std::vector<int32_t> m_ring;
+        std::vector<int32_t> m_pad;
+        std::vector<double> m_time;
+        std::vector<double> m_adc;
+        std::vector<uint32_t> m_selected;
+
+        void Configure() {
+            m_log = m_service_log->logger("tracking:hit_filter");
+
+            const size_t plane_count = m_service_geometry->GetPlanePositions().size();
+            m_mask = HitFilterMask(plane_count, num_rings, num_pads_per_ring);
+            m_mask.SetAdcMin(m_cfg_adc_min());
+
+            const auto& time_min = m_cfg_time_min();
+            const auto& time_max = m_cfg_time_max();
+            for (const auto* window: {&time_min, &time_max}) {
+                if (window->size() > 1 && window->size() != plane_count) {
+                    throw JException(fmt::format("tracking:hit_filter:time_min and time_max should have 1 or {} values, got {}",
+                                                 plane_count, window->size()));
+                }
+            }
+            for (size_t plane = 0; plane < plane_count; plane++) {
+                const double plane_min = time_min.empty() ? -std::numeric_limits<double>::infinity() : time_min[time_min.size() > 1 ? plane : 0];
+                const double plane_max = time_max.empty() ? std::numeric_limits<double>::infinity() : time_max[time_max.size() > 1 ? plane : 0];
+                m_mask.SetTimeWindow(plane, plane_min, plane_max);
+            }
+
+            if (!m_cfg_dead_pads_file().empty()) {
+                ReadDeadPads(m_cfg_dead_pads_file());
+            }
+
+            if (m_cfg_hot_pads()) {
+                m_occupancy_shard = &m_service_occupancy->AddShard();
+            }
+
+            m_log->info("Hit filter: adc >= {}, {} time windows, {} dead pads of {}",
+                        m_mask.GetAdcMin(), time_min.size() + time_max.size() ? "with" : "no",
+                        m_mask.GetDeadPadCount(), m_mask.GetPadCount());
+        }
+
+        void ReadDeadPads(const std::string& file_name) {
+            std::ifstream file(file_name);
+            if (!file) {
+                throw JException(fmt::format("Can't open tracking:hit_filter:dead_pads_file '{}'", file_name));
+            }
+
+            std::string line;
+            size_t line_number = 0;
+            while (std::getline(file, line)) {
+                line_number++;
+                line = line.substr(0, line.find('#'));
+
+                std::istringstream tokens(line);
+                int plane, ring, pad;
+                if (!(tokens >> plane)) {
+                    continue;   // Empty or comment line
+                }
+                if (!(tokens >> ring >> pad) || !m_mask.SetDeadPad(plane, ring, pad)) {
+                    throw JException(fmt::format("{}:{} should be 'plane ring pad' of an existing pad, got '{}'",
+                                                 file_name, line_number, line));
+                }
+                m_file_dead_pads.emplace_back(plane, ring, pad);
+            }
+        }
+
+        /// Dead pads of the mask are dead_pads_file + run conditions + hot pads
+        void UpdateDeadPads() {
+            m_mask.ClearDeadPads();
+            for (const auto& [plane, ring, pad]: m_file_dead_pads) {
+                m_mask.SetDeadPad(plane, ring, pad);
+            }
+            for (const auto& [plane, ring, pad]: m_conditions->GetDeadPads()) {
+                m_mask.SetDeadPad(plane, ring, pad);
+            }
+            if (m_occupancy) {
+                for (const auto& [plane, ring, pad]: m_occupancy->GetHotPads()) {
+                    m_mask.SetDeadPad(plane, ring, pad);
+                }
+            }
+        }
+
+        void ChangeRun(int32_t run_nr) {
+            m_conditions = m_service_conditions->GetRunConditions(run_nr);
+            UpdateDeadPads();
+            m_log->debug("Run {}: {} dead pads", run_nr, m_mask.GetDeadPadCount());
+        }
+
+        void Execute(int32_t /*run_nr*/, uint64_t event_index) {
+            const auto& mc_hits = *m_mc_hits_in();
+
+            m_plane.clear();
+            m_ring.clear();
+            m_pad.clear();
+            m_time.clear();
+            m_adc.clear();
+            for (auto mc_hit: mc_hits) {
+                if (mc_hit.pad() == -999) break;
+                m_plane.push_back(mc_hit.plane());
+                m_ring.push_back(mc_hit.ring());
+                m_pad.push_back(mc_hit.pad());
+                m_time.push_back(mc_hit.time());
+                m_adc.push_back(mc_hit.adc());
+            }
+
+            if (m_occupancy_shard) {
+                m_occupancy_shard->Fill(m_plane.size(), m_plane.data(), m_ring.data(), m_pad.data(), m_adc.data());
+                m_service_occupancy->CountEvent();
+
+                // Pointer comparison, the mask is rebuilt only after a merge
+                auto occupancy = m_service_occupancy->GetOccupancy();
+                if (occupancy != m_occupancy) {
+                    m_occupancy = std::move(occupancy);
+                    UpdateDeadPads();
+                    m_log->debug("Event {}: {} hot pads are masked", event_index, m_occupancy->GetHotPads().size());
+                }
+            }
+
+            m_mask.FilterHits(m_plane.size(), m_plane.data(), m_ring.data(), m_pad.data(), m_time.data(), m_adc.data(), m_selected);
+
+            auto filtered = std::make_unique<DigitizedMtpcMcHitCollection>();
+            filtered->setSubsetCollection();
+            for (auto index: m_selected) {
+                filtered->push_back(mc_hits[index]);
+            }
+
+            m_log->debug("Event {}: {} of {} hits passed", event_index, m_selected.size(), mc_hits.size());
+            m_mc_hits_out() = std::move(filtered);
+        }
+    };
+}  // namespace tdis::tracking
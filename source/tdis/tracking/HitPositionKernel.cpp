@@ -0,0 +1,248 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "HitPositionKernel.h"
+
+#include <Acts/Definitions/Units.hpp>
+#include <algorithm>
+
+#include "PadGeometryHelper.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TDIS_HIT_KERNEL_X86 1
+#endif
+
+namespace tdis::tracking {
+
+    static_assert(HitPositionTables::kRings == num_rings && HitPositionTables::kPadsPerRing == num_pads_per_ring,
+                  "HitPositionTables sizes must match PadGeometryHelper.hpp");
+
+    HitPositionTables HitPositionTables::Build(const PadGeometryTable& pad_table, const std::vector<double>& plane_positions) {
+        HitPositionTables tables;
+        for (size_t i = 0; i < pad_table.pads.size(); i++) {
+            tables.pad_x[i] = pad_table.pads[i].x;
+            tables.pad_y[i] = pad_table.pads[i].y;
+        }
+        for (size_t ring = 0; ring < pad_table.rings.size(); ring++) {
+            tables.ring_xy_variance[ring] = pad_table.rings[ring].xy_variance;
+        }
+        tables.plane_z = plane_positions;
+        return tables;
+    }
+
+    namespace {
+
+        using Kernel = void (*)(const HitPositionTables&, DigitizedHitBatch&, size_t begin, size_t end);
+
+        void ConvertScalar(const HitPositionTables& tables, DigitizedHitBatch& batch, size_t begin, size_t end) {
+            const auto plane_count = static_cast<uint32_t>(tables.plane_z.size());
+            for (size_t i = begin; i < end; i++) {
+                const int32_t plane = batch.plane[i];
+                const int32_t ring = batch.ring[i];
+                const int32_t pad = batch.pad[i];
+                const bool valid = static_cast<uint32_t>(plane) < plane_count &&
+                                   static_cast<uint32_t>(ring) < HitPositionTables::kRings &&
+                                   static_cast<uint32_t>(pad) < HitPositionTables::kPadsPerRing;
+
+                // Invalid hits read the first table entries, so there is no branch on data
+                const int32_t safe_plane = valid ? plane : 0;
+                const int32_t safe_ring = valid ? ring : 0;
+                const int32_t pad_index = valid ? ring * HitPositionTables::kPadsPerRing + pad : 0;
+
+                const double plane_z = tables.plane_z[safe_plane];
+                const double z_to_gem = batch.z_to_gem[i];
+                batch.x[i] = tables.pad_x[pad_index];
+                batch.y[i] = tables.pad_y[pad_index];
+                batch.z[i] = plane_z + ((plane & 1) ? -z_to_gem : z_to_gem);
+                batch.plane_z[i] = plane_z;
+                batch.xy_variance[i] = tables.ring_xy_variance[safe_ring];
+                batch.cell_id[i] = 1'000'000u * static_cast<uint32_t>(plane) + 1'000u * static_cast<uint32_t>(ring) + static_cast<uint32_t>(pad);
+                batch.valid[i] = valid;
+            }
+        }
+
+#ifdef TDIS_HIT_KERNEL_X86
+
+        /// Lanes where 0 <= value < limit
+        __attribute__((target("avx2")))
+        inline __m128i InRange4(__m128i value, int32_t limit) {
+            return _mm_and_si128(_mm_cmpgt_epi32(value, _mm_set1_epi32(-1)), _mm_cmpgt_epi32(_mm_set1_epi32(limit), value));
+        }
+
+        __attribute__((target("avx2")))
+        void ConvertAvx2(const HitPositionTables& tables, DigitizedHitBatch& batch, size_t begin, size_t end) {
+            const auto plane_count = static_cast<int32_t>(tables.plane_z.size());
+            const __m128i pads_per_ring = _mm_set1_epi32(HitPositionTables::kPadsPerRing);
+            const __m128i one = _mm_set1_epi32(1);
+            const __m256d sign_bit = _mm256_set1_pd(-0.0);
+
+            size_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                const __m128i plane = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.plane[i]));
+                const __m128i ring = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.ring[i]));
+                const __m128i pad = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.pad[i]));
+
+                const __m128i valid = _mm_and_si128(InRange4(plane, plane_count),
+                                      _mm_and_si128(InRange4(ring, HitPositionTables::kRings),
+                                                    InRange4(pad, HitPositionTables::kPadsPerRing)));
+
+                // Invalid lanes are masked out of the gathers and get zeros
+                const __m256d gather_mask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(valid));
+                const __m256d zero = _mm256_setzero_pd();
+                const __m128i pad_index = _mm_add_epi32(_mm_mullo_epi32(ring, pads_per_ring), pad);
+
+                const __m256d x = _mm256_mask_i32gather_pd(zero, tables.pad_x.data(), pad_index, gather_mask, 8);
+                const __m256d y = _mm256_mask_i32gather_pd(zero, tables.pad_y.data(), pad_index, gather_mask, 8);
+                const __m256d variance = _mm256_mask_i32gather_pd(zero, tables.ring_xy_variance.data(), ring, gather_mask, 8);
+                const __m256d plane_z = _mm256_mask_i32gather_pd(zero, tables.plane_z.data(), plane, gather_mask, 8);
+
+                // Odd planes subtract zToGem: flip its sign bit
+                const __m128i odd = _mm_cmpeq_epi32(_mm_and_si128(plane, one), one);
+                const __m256d odd_sign = _mm256_and_pd(_mm256_castsi256_pd(_mm256_cvtepi32_epi64(odd)), sign_bit);
+                const __m256d z_to_gem = _mm256_xor_pd(_mm256_loadu_pd(&batch.z_to_gem[i]), odd_sign);
+
+                _mm256_storeu_pd(&batch.x[i], x);
+                _mm256_storeu_pd(&batch.y[i], y);
+                _mm256_storeu_pd(&batch.z[i], _mm256_add_pd(plane_z, z_to_gem));
+                _mm256_storeu_pd(&batch.plane_z[i], plane_z);
+                _mm256_storeu_pd(&batch.xy_variance[i], variance);
+
+                const __m128i cell_id = _mm_add_epi32(_mm_mullo_epi32(plane, _mm_set1_epi32(1'000'000)),
+                                        _mm_add_epi32(_mm_mullo_epi32(ring, _mm_set1_epi32(1'000)), pad));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&batch.cell_id[i]), cell_id);
+
+                const int valid_bits = _mm_movemask_ps(_mm_castsi128_ps(valid));
+                for (int lane = 0; lane < 4; lane++) {
+                    batch.valid[i + lane] = (valid_bits >> lane) & 1;
+                }
+            }
+            ConvertScalar(tables, batch, i, end);
+        }
+
+        __attribute__((target("avx512f,avx2")))
+        inline __m256i InRange8(__m256i value, int32_t limit) {
+            return _mm256_and_si256(_mm256_cmpgt_epi32(value, _mm256_set1_epi32(-1)), _mm256_cmpgt_epi32(_mm256_set1_epi32(limit), value));
+        }
+
+        __attribute__((target("avx512f,avx2")))
+        void ConvertAvx512(const HitPositionTables& tables, DigitizedHitBatch& batch, size_t begin, size_t end) {
+            const auto plane_count = static_cast<int32_t>(tables.plane_z.size());
+            const __m256i pads_per_ring = _mm256_set1_epi32(HitPositionTables::kPadsPerRing);
+            const __m256i one = _mm256_set1_epi32(1);
+
+            size_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                const __m256i plane = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.plane[i]));
+                const __m256i ring = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.ring[i]));
+                const __m256i pad = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.pad[i]));
+
+                const __m256i valid = _mm256_and_si256(InRange8(plane, plane_count),
+                                      _mm256_and_si256(InRange8(ring, HitPositionTables::kRings),
+                                                       InRange8(pad, HitPositionTables::kPadsPerRing)));
+
+                // Invalid lanes are masked out of the gathers and get zeros
+                const int valid_bits = _mm256_movemask_ps(_mm256_castsi256_ps(valid));
+                const auto gather_mask = static_cast<__mmask8>(valid_bits);
+                const __m512d zero = _mm512_setzero_pd();
+                const __m256i pad_index = _mm256_add_epi32(_mm256_mullo_epi32(ring, pads_per_ring), pad);
+
+                const __m512d x = _mm512_mask_i32gather_pd(zero, gather_mask, pad_index, tables.pad_x.data(), 8);
+                const __m512d y = _mm512_mask_i32gather_pd(zero, gather_mask, pad_index, tables.pad_y.data(), 8);
+                const __m512d variance = _mm512_mask_i32gather_pd(zero, gather_mask, ring, tables.ring_xy_variance.data(), 8);
+                const __m512d plane_z = _mm512_mask_i32gather_pd(zero, gather_mask, plane, tables.plane_z.data(), 8);
+
+                // Odd planes subtract zToGem
+                const __m256i odd = _mm256_cmpeq_epi32(_mm256_and_si256(plane, one), one);
+                const auto odd_mask = static_cast<__mmask8>(_mm256_movemask_ps(_mm256_castsi256_ps(odd)));
+                const __m512d z_to_gem = _mm512_loadu_pd(&batch.z_to_gem[i]);
+                const __m512d z = _mm512_mask_sub_pd(_mm512_add_pd(plane_z, z_to_gem), odd_mask, plane_z, z_to_gem);
+
+                _mm512_storeu_pd(&batch.x[i], x);
+                _mm512_storeu_pd(&batch.y[i], y);
+                _mm512_storeu_pd(&batch.z[i], z);
+                _mm512_storeu_pd(&batch.plane_z[i], plane_z);
+                _mm512_storeu_pd(&batch.xy_variance[i], variance);
+
+                const __m256i cell_id = _mm256_add_epi32(_mm256_mullo_epi32(plane, _mm256_set1_epi32(1'000'000)),
+                                        _mm256_add_epi32(_mm256_mullo_epi32(ring, _mm256_set1_epi32(1'000)), pad));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&batch.cell_id[i]), cell_id);
+
+                for (int lane = 0; lane < 8; lane++) {
+                    batch.valid[i + lane] = (valid_bits >> lane) & 1;
+                }
+            }
+            ConvertScalar(tables, batch, i, end);
+        }
+
+#endif  // TDIS_HIT_KERNEL_X86
+
+        Kernel GetKernel(HitPositionKernel kernel) {
+            if (kernel == HitPositionKernel::Auto || !IsHitPositionKernelSupported(kernel)) {
+                kernel = GetBestHitPositionKernel();
+            }
+#ifdef TDIS_HIT_KERNEL_X86
+            if (kernel == HitPositionKernel::Avx512) return &ConvertAvx512;
+            if (kernel == HitPositionKernel::Avx2) return &ConvertAvx2;
+#endif
+            return &ConvertScalar;
+        }
+    }   // namespace
+
+    bool IsHitPositionKernelSupported(HitPositionKernel kernel) {
+#ifdef TDIS_HIT_KERNEL_X86
+        switch (kernel) {
+            case HitPositionKernel::Scalar: return true;
+            case HitPositionKernel::Avx2:   return __builtin_cpu_supports("avx2");
+            case HitPositionKernel::Avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2");
+            default: return false;
+        }
+#else
+        return kernel == HitPositionKernel::Scalar;
+#endif
+    }
+
+    HitPositionKernel GetBestHitPositionKernel() {
+        static const HitPositionKernel best = [] {
+            if (IsHitPositionKernelSupported(HitPositionKernel::Avx512)) return HitPositionKernel::Avx512;
+            if (IsHitPositionKernelSupported(HitPositionKernel::Avx2)) return HitPositionKernel::Avx2;
+            return HitPositionKernel::Scalar;
+        }();
+        return best;
+    }
+
+    std::string_view GetHitPositionKernelName(HitPositionKernel kernel) {
+        switch (kernel) {
+            case HitPositionKernel::Scalar: return "scalar";
+            case HitPositionKernel::Avx2:   return "avx2";
+            case HitPositionKernel::Avx512: return "avx512";
+            default:                        return "auto";
+        }
+    }
+
+    size_t ConvertHitPositions(const HitPositionTables& tables, DigitizedHitBatch& batch, HitPositionKernel kernel) {
+        const size_t count = batch.size();
+        batch.x.resize(count);
+        batch.y.resize(count);
+        batch.z.resize(count);
+        batch.plane_z.resize(count);
+        batch.xy_variance.resize(count);
+        batch.cell_id.resize(count);
+        batch.valid.resize(count);
+
+        // Without planes every hit is invalid, and there is nothing to gather from
+        if (tables.plane_z.empty()) {
+            std::fill(batch.valid.begin(), batch.valid.end(), 0);
+            return 0;
+        }
+
+        GetKernel(kernel)(tables, batch, 0, count);
+
+        size_t valid_count = 0;
+        for (auto valid: batch.valid) {
+            valid_count += valid;
+        }
+        return valid_count;
+    }
+
+}   // namespace tdis::tracking
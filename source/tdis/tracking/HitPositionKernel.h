@@ -0,0 +1,95 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Batch conversion of digitized hits (plane, ring, pad, zToGem) to 3D positions
+ *
+ *  ReconstructedHitFactory fills a DigitizedHitBatch with all hits of an event and calls
+ *  ConvertHitPositions once. Each hit gets:
+ *      x, y        - pad center
+ *      z           - plane_z + zToGem for even planes and plane_z - zToGem for odd ones
+ *      plane_z     - z of the plane (readout) position
+ *      xy_variance - ring variance of x and y (getPadXYVariance)
+ *      cell_id     - 1'000'000 * plane + 1'000 * ring + pad
+ *      valid       - 0 if plane, ring or pad is out of range. Other outputs of such hit are not meaningful
+ *
+ *  The same arithmetic is done for every hit, so the kernel works on structure of arrays with
+ *  AVX-512 (8 hits), AVX2 (4 hits) or plain scalar code. The best one the CPU supports is selected
+ *  at runtime, the binary is still built for the baseline architecture.
+ **/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace tdis {
+    struct PadGeometryTable;
+}
+
+namespace tdis::tracking {
+
+    /** Flat lookup tables for the kernel. Pad arrays are indexed by ring * num_pads_per_ring + pad */
+    struct HitPositionTables {
+        static constexpr int32_t kRings = 21;
+        static constexpr int32_t kPadsPerRing = 122;
+
+        std::array<double, kRings * kPadsPerRing> pad_x{};
+        std::array<double, kRings * kPadsPerRing> pad_y{};
+        std::array<double, kRings> ring_xy_variance{};
+        std::vector<double> plane_z;
+
+        static HitPositionTables Build(const PadGeometryTable& pad_table, const std::vector<double>& plane_positions);
+    };
+
+    /** Hits of one event in structure of arrays. Keep an instance between events to reuse allocated memory */
+    struct DigitizedHitBatch {
+        // Inputs
+        std::vector<int32_t> plane;
+        std::vector<int32_t> ring;
+        std::vector<int32_t> pad;
+        std::vector<double> z_to_gem;       // mm
+
+        // Outputs of ConvertHitPositions
+        std::vector<double> x;              // mm
+        std::vector<double> y;
+        std::vector<double> z;
+        std::vector<double> plane_z;
+        std::vector<double> xy_variance;    // mm^2
+        std::vector<uint32_t> cell_id;
+        std::vector<uint8_t> valid;
+
+        size_t size() const { return plane.size(); }
+
+        void clear() {
+            plane.clear(); ring.clear(); pad.clear(); z_to_gem.clear();
+        }
+
+        void push_back(int32_t hit_plane, int32_t hit_ring, int32_t hit_pad, double hit_z_to_gem) {
+            plane.push_back(hit_plane);
+            ring.push_back(hit_ring);
+            pad.push_back(hit_pad);
+            z_to_gem.push_back(hit_z_to_gem);
+        }
+    };
+
+    enum class HitPositionKernel { Auto, Scalar, Avx2, Avx512 };
+
+    /// Scalar is always supported, Auto never
+    bool IsHitPositionKernelSupported(HitPositionKernel kernel);
+
+    /// The best kernel supported by this CPU (never returns Auto)
+    HitPositionKernel GetBestHitPositionKernel();
+
+    /// "scalar", "avx2", "avx512" or "auto"
+    std::string_view GetHitPositionKernelName(HitPositionKernel kernel);
+
+    /** Fills outputs for all hits of the batch. Returns the number of valid hits.
+     *  Requesting a kernel which the CPU doesn't support falls back to the best supported one */
+    size_t ConvertHitPositions(const HitPositionTables& tables, DigitizedHitBatch& batch,
+                               HitPositionKernel kernel = HitPositionKernel::Auto);
+
+}   // namespace tdis::tracking
@@ -6,6 +6,7 @@
 
 #include "ActsLogHeplers.h"
 #include "ConfiguredKalmanFitter.h"
+#include "PadGeometryHelper.hpp"
 #include "podio_model/DigitizedMtpcMcTrack.h"
 #include "podio_model/DigitizedMtpcMcTrackCollection.h"
 #include "podio_model/Measurement2DCollection.h"
@@ -34,6 +35,8 @@ void KalmanFittingFactory::Configure() {
 
     m_logger = m_log_svc->logger("tracking/kf");
 
+    m_measurement_order = RingMeasurementOrder(num_rings);
+
 
     // ---------- CSV ----------
     m_csv.open(m_csv_out(), std::ios::out | std::ios::trunc);
@@ -116,8 +119,8 @@ void KalmanFittingFactory::Execute(int32_t run_number, uint64_t event_number) {
         double track_start_y = 0;
         double track_start_z = 0;
 
-        // Collect SourceLinks for this track's measurements
-        std::vector<Acts::SourceLink> sourceLinks;
+        // Find this track's measurements. They are fitted in ring order, not in the order of hits
+        m_measurement_order.Clear();
         m_logger->info("Track id={} colId={} Hits:", mcTrack.id().index, mcTrack.id().collectionID);
         for (const auto& mcHit : mcTrack.hits()) {
             for (size_t i = 0; i < measurements.size(); ++i) {
@@ -145,43 +148,55 @@ void KalmanFittingFactory::Execute(int32_t run_number, uint64_t event_number) {
                         mcHit.plane(), mcHit.ring(), mcHit.pad(),
                         x, y, z, measurement.surface());
 
-                    // This is a test that surfaces we think we have, are in tracking geometry
-                    auto surfaceFromTrkGeo = geometry->findSurface(Acts::GeometryIdentifier(measurement.surface()));
-                    auto surfaceGeoId = surfaceFromTrkGeo->geometryId();
-                    if (!surfaceFromTrkGeo) {
-                        auto msg = fmt::format("For ring = {}, we can't find back the surface with id = {}. It is trackingGeometry->findSurface==NULL. Track fitting will fail soon (!)", mcHit.ring(), surfaceGeoId.volume());
-                        m_logger->critical(msg);
-                        throw std::runtime_error(msg);
-                    }
+                    m_measurement_order.Add(i, mcHit.ring(), reconstructedHit.position().z);
+                    break;
+                 }
+            }
+        }
 
-                    ActsExamples::IndexSourceLink sourceLink(surfaceGeoId, i);
+        // Innermost ring first, within a ring along the track z direction, so the navigator goes outward in one pass
+        const double z_direction = std::cos(mcTrack.theta() * Acts::UnitConstants::degree);
 
-                    sourceLinks.emplace_back(sourceLink);
+        // Collect SourceLinks for this track's measurements
+        std::vector<Acts::SourceLink> sourceLinks;
+        for (auto i : m_measurement_order.Sort(z_direction)) {
+            const auto& measurement = measurements[i];
+
+            // This is a test that surfaces we think we have, are in tracking geometry
+            auto surfaceFromTrkGeo = geometry->findSurface(Acts::GeometryIdentifier(measurement.surface()));
+            if (!surfaceFromTrkGeo) {
+                auto msg = fmt::format("We can't find back the surface with id = {}. It is trackingGeometry->findSurface==NULL. Track fitting will fail soon (!)", measurement.surface());
+                m_logger->critical(msg);
+                throw std::runtime_error(msg);
+            }
+            auto surfaceGeoId = surfaceFromTrkGeo->geometryId();
 
+            // Source link index is the index in actsMeasurements (see MeasurementCalibrator)
+            ActsExamples::IndexSourceLink sourceLink(surfaceGeoId, sourceLinks.size());
 
-                    // 1) Prepare the data vector (size=2)
-                    Acts::Vector2 loc2D = Acts::Vector2::Zero();
-                    loc2D[Acts::eBoundLoc0] = measurement.loc().a;
-                    loc2D[Acts::eBoundLoc1] = measurement.loc().b;
+            sourceLinks.emplace_back(sourceLink);
 
-                    // 2) Prepare the 2x2 covariance
-                    Acts::SquareMatrix2 cov2D = Acts::SquareMatrix2::Zero();
-                    cov2D(0, 0) = measurement.covariance().xx;
-                    cov2D(1, 1) = measurement.covariance().yy;
-                    cov2D(0, 1) = measurement.covariance().xy;
-                    cov2D(1, 0) = measurement.covariance().xy;
 
-                    //auto actsMeasurement = actsMeasurements->makeMeasurement<Acts::eBoundSize>(geoId);
+            // 1) Prepare the data vector (size=2)
+            Acts::Vector2 loc2D = Acts::Vector2::Zero();
+            loc2D[Acts::eBoundLoc0] = measurement.loc().a;
+            loc2D[Acts::eBoundLoc1] = measurement.loc().b;
 
-                    actsMeasurements->emplaceMeasurement<2>(
-                        surfaceGeoId,
-                        std::array{Acts::eBoundLoc0, Acts::eBoundLoc1},  // Subspace indices FIRST
-                        loc2D,                                    // Parameters vector
-                        cov2D                                     // Covariance matrix
-                    );
-                    break;
-                 }
-            }
+            // 2) Prepare the 2x2 covariance
+            Acts::SquareMatrix2 cov2D = Acts::SquareMatrix2::Zero();
+            cov2D(0, 0) = measurement.covariance().xx;
+            cov2D(1, 1) = measurement.covariance().yy;
+            cov2D(0, 1) = measurement.covariance().xy;
+            cov2D(1, 0) = measurement.covariance().xy;
+
+            //auto actsMeasurement = actsMeasurements->makeMeasurement<Acts::eBoundSize>(geoId);
+
+            actsMeasurements->emplaceMeasurement<2>(
+                surfaceGeoId,
+                std::array{Acts::eBoundLoc0, Acts::eBoundLoc1},  // Subspace indices FIRST
+                loc2D,                                    // Parameters vector
+                cov2D                                     // Covariance matrix
+            );
         }
 
 
@@ -14,6 +14,7 @@
 
 #include "ActsGeometryService.h"
 #include "ConfiguredFitter.hpp"
+#include "RingMeasurementOrder.hpp"
 #include "podio_model/DigitizedMtpcMcHitCollection.h"
 #include "podio_model/DigitizedMtpcMcTrack.h"
 #include "podio_model/DigitizedMtpcMcTrackCollection.h"
@@ -67,6 +68,7 @@ namespace tdis::tracking {
         std::shared_ptr<Propagator> m_propagator;
         std::shared_ptr<KF> m_kalman_fitter;
         std::ofstream m_csv;
+        RingMeasurementOrder m_measurement_order;   // Fitting order of the current track measurements
     };
 
 } // namespace tdis::tracking
\ No newline at end of file
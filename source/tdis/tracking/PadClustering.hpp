@@ -0,0 +1,210 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Finds clusters of neighboring pad measurements and their ADC weighted centroids
+ *
+ *  Measurements of the same plane and ring are merged if their pads are adjacent (pad 0 and the last pad
+ *  of a ring are adjacent too) and their times differ by no more than the time window. Merging is
+ *  transitive (union-find), so a cluster can be wider than two pads. Measurements with plane, ring or
+ *  pad out of range are single measurement clusters.
+ *
+ *  Neighbors are looked up in a PadHitIndex built by the caller: over the measurements themselves, or over
+ *  their hits (PadHitIndexFactory index of TrackerHit) with a map from hit to measurement.
+ *
+ *  Clusters are numbered in the order of their first measurement in the input. Members of a cluster go
+ *  with the largest ADC first (the seed), equal ADC keep the input order. Each member has weight w_i/W:
+ *  ADC over the cluster ADC sum, or 1/n for all members if the ADC sum is not positive.
+ *
+ *  Centroid of a cluster:
+ *      loc    = sum(w_i * loc_i),        loc0 = R*phi is averaged across phi = ±π with the loc0 period 2πR
+ *      time   = sum(w_i * time_i)
+ *      cov    = sum(w_i^2 * cov_i)       (uncorrelated pad measurements, each with its own covariance)
+ *
+ *  Usage:
+ *      PadClusterFinder finder;
+ *      finder.FindClusters(index, hit_measurement, count, plane, ring, pad, time, adc, time_window);
+ *      for (size_t cluster = 0; cluster < finder.GetClusterCount(); cluster++) {
+ *          auto centroid = finder.GetCentroid(cluster, values, loc0_period);
+ *          for (auto member: finder.GetMembers(cluster)) { ... }
+ *      }
+ **/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "PadHitIndex.hpp"
+
+namespace tdis::tracking {
+
+    /// Local position, time and covariance of a pad measurement or a cluster
+    struct PadClusterValues {
+        double loc0 = 0;        // R*phi
+        double loc1 = 0;        // z
+        double time = 0;
+        double cov_xx = 0;
+        double cov_yy = 0;
+        double cov_tt = 0;
+        double cov_xy = 0;
+    };
+
+    class PadClusterFinder {
+    public:
+        /// hit_measurement value of a hit without measurement
+        static constexpr uint32_t kNoMeasurement = UINT32_MAX;
+
+        /// Clusters measurements 0..count-1 with index built over the same measurements.
+        /// All arrays have count elements. Returns the number of clusters
+        size_t FindClusters(const PadHitIndex& index, size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad,
+                            const double* time, const double* adc, double time_window) {
+            return BuildClusters(index, {}, true, count, plane, ring, pad, time, adc, time_window);
+        }
+
+        /// Clusters measurements 0..count-1 with index built over their hits. hit_measurement[hit] is the measurement
+        /// of the index hit, kNoMeasurement or out of the span if it has none. Plane, ring, pad and time are of the hits
+        size_t FindClusters(const PadHitIndex& index, std::span<const uint32_t> hit_measurement,
+                            size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad,
+                            const double* time, const double* adc, double time_window) {
+            return BuildClusters(index, hit_measurement, false, count, plane, ring, pad, time, adc, time_window);
+        }
+
+        size_t GetClusterCount() const { return m_cluster_count; }
+
+        /// Measurement indexes of the cluster, the seed first
+        std::span<const uint32_t> GetMembers(size_t cluster) const {
+            return {m_members.data() + m_offsets[cluster], m_members.data() + m_offsets[cluster + 1]};
+        }
+
+        /// w_i/W of GetMembers(cluster)
+        std::span<const double> GetWeights(size_t cluster) const {
+            return {m_weights.data() + m_offsets[cluster], m_weights.data() + m_offsets[cluster + 1]};
+        }
+
+        /// Centroid of the cluster from values of all measurements (indexed as FindClusters input).
+        /// loc0_period is 2πR of the ring, 0 - loc0 is averaged without wrapping
+        PadClusterValues GetCentroid(size_t cluster, const PadClusterValues* values, double loc0_period) const {
+            const auto members = GetMembers(cluster);
+            const auto weights = GetWeights(cluster);
+            const auto& seed = values[members.front()];
+
+            // loc0 is averaged as a difference to the seed, which is short across phi = ±π too
+            PadClusterValues centroid;
+            for (size_t i = 0; i < members.size(); i++) {
+                const auto& value = values[members[i]];
+                const double weight = weights[i];
+
+                double d_loc0 = value.loc0 - seed.loc0;
+                if (loc0_period > 0) {
+                    d_loc0 -= loc0_period * std::round(d_loc0 / loc0_period);
+                }
+                centroid.loc0 += weight * d_loc0;
+                centroid.loc1 += weight * value.loc1;
+                centroid.time += weight * value.time;
+
+                const double weight2 = weight * weight;
+                centroid.cov_xx += weight2 * value.cov_xx;
+                centroid.cov_yy += weight2 * value.cov_yy;
+                centroid.cov_tt += weight2 * value.cov_tt;
+                centroid.cov_xy += weight2 * value.cov_xy;
+            }
+            centroid.loc0 += seed.loc0;
+            if (loc0_period > 0 && std::abs(centroid.loc0) > loc0_period / 2) {
+                centroid.loc0 -= loc0_period * std::round(centroid.loc0 / loc0_period);
+            }
+            return centroid;
+        }
+
+    private:
+        size_t BuildClusters(const PadHitIndex& index, std::span<const uint32_t> hit_measurement, bool is_measurement_index,
+                            size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad,
+                            const double* time, const double* adc, double time_window) {
+            // Merge each measurement with in-time ones on the same and the next pad (the index wraps the last pad to 0).
+            // The previous pad is covered by its own lookup
+            m_parent.resize(count);
+            std::iota(m_parent.begin(), m_parent.end(), 0u);
+            for (size_t i = 0; i < count; i++) {
+                for (int next_pad: {pad[i], pad[i] + 1}) {
+                    for (auto hit: index.GetPadHits(plane[i], ring[i], next_pad, time[i] - time_window, time[i] + time_window)) {
+                        const uint32_t j = is_measurement_index ? hit : (hit < hit_measurement.size() ? hit_measurement[hit] : kNoMeasurement);
+                        if (j < count) {
+                            Merge(static_cast<uint32_t>(i), j);
+                        }
+                    }
+                }
+            }
+
+            // Number clusters by the first member. Roots are the smallest index of a cluster, so a root is seen first
+            m_cluster_count = 0;
+            m_cluster_of.resize(count);
+            m_offsets.assign(count + 1, 0);
+            for (size_t i = 0; i < count; i++) {
+                const uint32_t root = FindRoot(static_cast<uint32_t>(i));
+                m_cluster_of[i] = (root == i) ? static_cast<uint32_t>(m_cluster_count++) : m_cluster_of[root];
+                m_offsets[m_cluster_of[i] + 1]++;
+            }
+            m_offsets.resize(m_cluster_count + 1);
+            for (size_t cluster = 1; cluster <= m_cluster_count; cluster++) {
+                m_offsets[cluster] += m_offsets[cluster - 1];
+            }
+
+            m_members.resize(count);
+            m_fill.assign(m_offsets.begin(), m_offsets.end() - 1);
+            for (size_t i = 0; i < count; i++) {
+                m_members[m_fill[m_cluster_of[i]]++] = static_cast<uint32_t>(i);
+            }
+
+            // Seed first and member weights
+            m_weights.resize(count);
+            for (size_t cluster = 0; cluster < m_cluster_count; cluster++) {
+                const auto begin = m_members.begin() + m_offsets[cluster];
+                const auto end = m_members.begin() + m_offsets[cluster + 1];
+                std::stable_sort(begin, end, [adc](uint32_t a, uint32_t b) { return adc[a] > adc[b]; });
+
+                double adc_sum = 0;
+                for (auto member = begin; member != end; ++member) {
+                    adc_sum += adc[*member];
+                }
+                const bool use_adc = adc_sum > 0;
+                const double weight_sum = use_adc ? adc_sum : static_cast<double>(end - begin);
+                for (uint32_t position = m_offsets[cluster]; position < m_offsets[cluster + 1]; position++) {
+                    m_weights[position] = (use_adc ? adc[m_members[position]] : 1.0) / weight_sum;
+                }
+            }
+            return m_cluster_count;
+        }
+
+        uint32_t FindRoot(uint32_t index) {
+            while (m_parent[index] != index) {
+                m_parent[index] = m_parent[m_parent[index]];
+                index = m_parent[index];
+            }
+            return index;
+        }
+
+        void Merge(uint32_t a, uint32_t b) {
+            a = FindRoot(a);
+            b = FindRoot(b);
+            if (a != b) {
+                m_parent[std::max(a, b)] = std::min(a, b);
+            }
+        }
+
+        size_t m_cluster_count = 0;
+        std::vector<uint32_t> m_offsets = std::vector<uint32_t>(1, 0);   // Members of cluster c are [m_offsets[c], m_offsets[c+1])
+        std::vector<uint32_t> m_members;
+        std::vector<double> m_weights;      // w_i/W of m_members
+
+        // Work arrays
+        std::vector<uint32_t> m_parent;     // Union-find forest over measurements
+        std::vector<uint32_t> m_cluster_of;
+        std::vector<uint32_t> m_fill;
+    };
+
+}   // namespace tdis::tracking
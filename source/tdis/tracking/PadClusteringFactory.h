@@ -0,0 +1,152 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Merges single pad measurements into clusters of neighboring pads
+ *
+ *  Measurements of the same plane and ring are merged if their pads are adjacent (pad 0 and the last pad
+ *  of a ring are adjacent too) and their times differ by no more than the time window. Clusters and
+ *  their ADC (TrackerHit edep) weighted centroids are found by PadClusterFinder (see PadClustering.hpp).
+ *  Neighbors are looked up in the PadHitIndex of TrackerHit (PadHitIndexFactory), which is built once per
+ *  event for all stages. Measurements are found from the index hits by their first hit.
+ *
+ *  A cluster becomes one Measurement2D with the centroid position, time and covariance. Measurement2D
+ *  hits and weights keep all hits of the cluster with w_i/W weights. The hit with the largest ADC goes first,
+ *  so code which looks only at hits().at(0) (KalmanFittingFactory) sees the cluster seed.
+ *  A single pad cluster gives the same measurement as the input one.
+ *
+ *  Configuration Parameters
+ *    - tracking:cluster_time_window (double, default 10):
+ *        ns, maximal time difference of adjacent pads which are merged
+ *
+ *  The factory is wired in tdis_main.cpp if tracking:pad_clustering=true. ReconstructedHitFactory
+ *  output is then renamed to UnclusteredMeasurement2D and clusters are Measurement2D.
+ **/
+
+#pragma once
+
+#include <JANA/Components/JOmniFactory.h>
+#include <JANA/JFactory.h>
+
+#include <cmath>
+#include <tuple>
+#include <vector>
+
+#include "ActsGeometryService.h"
+#include "PadClustering.hpp"
+#include "PadGeometryHelper.hpp"
+#include "PadHitIndex.hpp"
+#include "podio_model/Measurement2D.h"
+#include "podio_model/Measurement2DCollection.h"
+#include "podio_model/TrackerHit.h"
+#include "services/LogService.hpp"
+
+namespace tdis::tracking {
+
+    struct PadClusteringFactory : public JOmniFactory<PadClusteringFactory> {
+        PodioInput<edm4eic::Measurement2D>  m_measurements_in{this, {"UnclusteredMeasurement2D"}};
+        Input<PadHitIndex> m_hit_index_in{this, {"PadHitIndex"}};
+        PodioOutput<edm4eic::Measurement2D> m_clusters_out{this, "Measurement2D"};
+
+        Service<ActsGeometryService> m_service_geometry{this};
+        Service<services::LogService> m_service_log{this};
+
+        Parameter<double> m_cfg_time_window{
+            this,
+            "tracking:cluster_time_window",
+            10.0,
+            "ns, maximal time difference of adjacent pads merged to one cluster"
+        };
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        // Per event work arrays, reused between events. Plane, ring and pad are -1 for measurements without hits
+        std::vector<int32_t> m_plane;
+        std::vector<int32_t> m_ring;
+        std::vector<int32_t> m_pad;
+        std::vector<double> m_time;
+        std::vector<double> m_adc;
+        std::vector<PadClusterValues> m_values;
+        std::vector<uint32_t> m_hit_measurement;    // Measurement of TrackerHit by its index in the collection
+        PadClusterFinder m_finder;
+
+        void Configure() {
+            m_service_geometry();
+            m_log = m_service_log->logger("tracking:pad_clustering");
+        }
+
+        void ChangeRun(int32_t /*run_nr*/) {
+        }
+
+        void Execute(int32_t /*run_nr*/, uint64_t event_index) {
+            auto clusters_out = std::make_unique<edm4eic::Measurement2DCollection>();
+            const auto& measurements = *m_measurements_in();
+            const size_t count = measurements.size();
+
+            // Plane, ring and pad come from cellID of the first hit, ADC is the sum over hits
+            m_plane.assign(count, -1);
+            m_ring.assign(count, -1);
+            m_pad.assign(count, -1);
+            m_time.resize(count);
+            m_adc.assign(count, 0);
+            m_values.resize(count);
+            m_hit_measurement.clear();
+            for (size_t i = 0; i < count; i++) {
+                const auto measurement = measurements[i];
+                if (!measurement.hits().empty()) {
+                    const auto hit = measurement.hits().at(0);
+                    std::tie(m_plane[i], m_ring[i], m_pad[i]) = PadGeometryTable::DecodeCellId(hit.cellID());
+
+                    const auto tracker_hit_index = static_cast<size_t>(hit.id().index);
+                    if (tracker_hit_index >= m_hit_measurement.size()) {
+                        m_hit_measurement.resize(tracker_hit_index + 1, PadClusterFinder::kNoMeasurement);
+                    }
+                    m_hit_measurement[tracker_hit_index] = static_cast<uint32_t>(i);
+                }
+                for (const auto& hit: measurement.hits()) {
+                    m_adc[i] += hit.edep();
+                }
+                m_time[i] = measurement.time();
+                m_values[i] = {measurement.loc().a, measurement.loc().b, measurement.time(),
+                               measurement.covariance().xx, measurement.covariance().yy,
+                               measurement.covariance().zz, measurement.covariance().xy};
+            }
+
+            const auto& pad_hit_index = *m_hit_index_in().at(0);
+            const size_t cluster_count = m_finder.FindClusters(pad_hit_index, m_hit_measurement, count, m_plane.data(), m_ring.data(), m_pad.data(),
+                                                               m_time.data(), m_adc.data(), m_cfg_time_window());
+
+            for (size_t cluster_index = 0; cluster_index < cluster_count; cluster_index++) {
+                const auto members = m_finder.GetMembers(cluster_index);
+                const auto weights = m_finder.GetWeights(cluster_index);
+                const auto seed = measurements[members.front()];
+                const int ring = m_ring[members.front()];
+
+                // Period of loc0 = R*phi to average across phi = ±π
+                const double loc0_period = ring >= 0 && static_cast<size_t>(ring) < m_service_geometry->GetRingSurfaces().size()
+                                           ? 2 * M_PI * m_service_geometry->GetRingSurface(ring).radius
+                                           : 0;
+                const auto centroid = m_finder.GetCentroid(cluster_index, m_values.data(), loc0_period);
+
+                auto cluster = clusters_out->create();
+                cluster.surface(seed.surface());
+                cluster.loc({static_cast<float>(centroid.loc0), static_cast<float>(centroid.loc1)});
+                cluster.time(static_cast<float>(centroid.time));
+                cluster.covariance({static_cast<float>(centroid.cov_xx), static_cast<float>(centroid.cov_yy),
+                                    static_cast<float>(centroid.cov_tt), static_cast<float>(centroid.cov_xy)});
+
+                for (size_t i = 0; i < members.size(); i++) {
+                    const auto measurement = measurements[members[i]];
+                    for (size_t hit_index = 0; hit_index < measurement.hits().size(); hit_index++) {
+                        const double hit_weight = hit_index < measurement.weights().size() ? measurement.weights().at(hit_index) : 1.0;
+                        cluster.addweights(static_cast<float>(weights[i] * hit_weight));
+                        cluster.addhits(measurement.hits().at(hit_index));
+                    }
+                }
+            }
+
+            m_log->debug("Event {}: {} measurements are merged into {} clusters", event_index, count, cluster_count);
+            m_clusters_out() = std::move(clusters_out);
+        }
+    };
+}  // namespace tdis::tracking
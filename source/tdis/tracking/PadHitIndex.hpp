@@ -0,0 +1,169 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Per event index of hits by (plane, ring, pad)
+ *
+ *  Dense grid of all pads of all planes with a bucket of hit indexes per pad. Buckets are sorted by
+ *  hit time, so "hits of a pad" and "hits of a pad within a time window" are a lookup and a binary
+ *  search instead of a scan over the whole collection. Pads wrap around phi: pad -1 is the last pad of
+ *  the ring and pad pads_per_ring is pad 0.
+ *
+ *  Buckets are stored as CSR: offsets by pad cell and one array of hit indexes (with their times),
+ *  built by a counting sort in O(hits + pads). An instance can be rebuilt for every event to reuse memory.
+ *
+ *  Usage:
+ *      PadHitIndex index(plane_count, num_rings, num_pads_per_ring);
+ *      index.Build(count, plane, ring, pad, time);
+ *      for (auto hit: index.GetPadHits(plane, ring, pad - 1, time - 10, time + 10)) { ... }
+ *      index.ForEachHitNear(plane, ring, pad, 1, 2, time_min, time_max, [&](uint32_t hit) { ... });
+ **/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace tdis::tracking {
+
+    class PadHitIndex {
+    public:
+        PadHitIndex() = default;
+
+        PadHitIndex(int plane_count, int ring_count, int pads_per_ring):
+            m_plane_count(plane_count), m_ring_count(ring_count), m_pads_per_ring(pads_per_ring),
+            m_offsets(static_cast<size_t>(plane_count) * ring_count * pads_per_ring + 1, 0) {}
+
+        int GetPlaneCount() const { return m_plane_count; }
+        int GetRingCount() const { return m_ring_count; }
+        int GetPadsPerRing() const { return m_pads_per_ring; }
+
+        /// Number of indexed hits
+        size_t size() const { return m_hits.size(); }
+
+        /// Hits with plane, ring or pad out of range which are not in the index
+        size_t GetSkippedCount() const { return m_skipped_count; }
+
+        /// Indexes hits 0..count-1. All arrays have count elements
+        void Build(size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad, const double* time) {
+            std::fill(m_offsets.begin(), m_offsets.end(), 0);
+            m_cells.resize(count);
+            m_skipped_count = 0;
+
+            // Counts per cell, shifted by one for the prefix sum
+            for (size_t i = 0; i < count; i++) {
+                const bool in_range = static_cast<uint32_t>(plane[i]) < static_cast<uint32_t>(m_plane_count) &&
+                                      static_cast<uint32_t>(ring[i]) < static_cast<uint32_t>(m_ring_count) &&
+                                      static_cast<uint32_t>(pad[i]) < static_cast<uint32_t>(m_pads_per_ring);
+                if (!in_range) {
+                    m_cells[i] = kNoCell;
+                    m_skipped_count++;
+                    continue;
+                }
+                m_cells[i] = GetCell(plane[i], ring[i], pad[i]);
+                m_offsets[m_cells[i] + 1]++;
+            }
+            for (size_t cell = 1; cell < m_offsets.size(); cell++) {
+                m_offsets[cell] += m_offsets[cell - 1];
+            }
+
+            // Scatter in input order, then sort each bucket by time. Buckets are a few hits, insertion sort is the fastest
+            const size_t indexed_count = count - m_skipped_count;
+            m_hits.resize(indexed_count);
+            m_times.resize(indexed_count);
+            m_fill.assign(m_offsets.begin(), m_offsets.end() - 1);
+            for (size_t i = 0; i < count; i++) {
+                if (m_cells[i] == kNoCell) continue;
+                const uint32_t position = m_fill[m_cells[i]]++;
+                m_hits[position] = static_cast<uint32_t>(i);
+                m_times[position] = time[i];
+
+                for (uint32_t j = position; j > m_offsets[m_cells[i]] && m_times[j - 1] > m_times[j]; j--) {
+                    std::swap(m_times[j - 1], m_times[j]);
+                    std::swap(m_hits[j - 1], m_hits[j]);
+                }
+            }
+        }
+
+        /// Copy of the index without Build work arrays, to publish the index and keep this instance for rebuilding
+        PadHitIndex CopyIndex() const {
+            PadHitIndex copy;
+            copy.m_plane_count = m_plane_count;
+            copy.m_ring_count = m_ring_count;
+            copy.m_pads_per_ring = m_pads_per_ring;
+            copy.m_skipped_count = m_skipped_count;
+            copy.m_offsets = m_offsets;
+            copy.m_hits = m_hits;
+            copy.m_times = m_times;
+            return copy;
+        }
+
+        /// Hits of the pad sorted by time. Out of range plane or ring gives no hits, pad wraps around the ring
+        std::span<const uint32_t> GetPadHits(int plane, int ring, int pad) const {
+            if (!IsValid(plane, ring)) return {};
+            const uint32_t cell = GetCell(plane, ring, WrapPad(pad));
+            return {m_hits.data() + m_offsets[cell], m_hits.data() + m_offsets[cell + 1]};
+        }
+
+        /// Hits of the pad with time_min <= time <= time_max
+        std::span<const uint32_t> GetPadHits(int plane, int ring, int pad, double time_min, double time_max) const {
+            if (!IsValid(plane, ring)) return {};
+            const uint32_t cell = GetCell(plane, ring, WrapPad(pad));
+            const auto times_begin = m_times.begin() + m_offsets[cell];
+            const auto times_end = m_times.begin() + m_offsets[cell + 1];
+            const auto first = std::lower_bound(times_begin, times_end, time_min);
+            const auto last = std::upper_bound(first, times_end, time_max);
+            return {m_hits.data() + (first - m_times.begin()), m_hits.data() + (last - m_times.begin())};
+        }
+
+        /// Calls callback(hit_index) for hits within ring_distance rings and pad_distance pads (wrapping around
+        /// the ring) of the same plane with time_min <= time <= time_max. Each pad is visited once
+        template <typename Callback>
+        void ForEachHitNear(int plane, int ring, int pad, int ring_distance, int pad_distance,
+                            double time_min, double time_max, Callback&& callback) const {
+            const int first_pad = pad - pad_distance;
+            const int pad_count = std::min(2 * pad_distance + 1, m_pads_per_ring);
+            for (int near_ring = std::max(ring - ring_distance, 0); near_ring <= std::min(ring + ring_distance, m_ring_count - 1); near_ring++) {
+                for (int pad_offset = 0; pad_offset < pad_count; pad_offset++) {
+                    for (auto hit: GetPadHits(plane, near_ring, first_pad + pad_offset, time_min, time_max)) {
+                        callback(hit);
+                    }
+                }
+            }
+        }
+
+    private:
+        static constexpr uint32_t kNoCell = UINT32_MAX;
+
+        bool IsValid(int plane, int ring) const {
+            return static_cast<uint32_t>(plane) < static_cast<uint32_t>(m_plane_count) &&
+                   static_cast<uint32_t>(ring) < static_cast<uint32_t>(m_ring_count);
+        }
+
+        int WrapPad(int pad) const {
+            pad %= m_pads_per_ring;
+            return pad < 0 ? pad + m_pads_per_ring : pad;
+        }
+
+        uint32_t GetCell(int plane, int ring, int pad) const {
+            return static_cast<uint32_t>((plane * m_ring_count + ring) * m_pads_per_ring + pad);
+        }
+
+        int m_plane_count = 0;
+        int m_ring_count = 0;
+        int m_pads_per_ring = 0;
+        size_t m_skipped_count = 0;
+
+        std::vector<uint32_t> m_offsets = std::vector<uint32_t>(1, 0);   // Bucket of cell c is [m_offsets[c], m_offsets[c+1])
+        std::vector<uint32_t> m_hits;       // Hit indexes by cell, each bucket sorted by time
+        std::vector<double> m_times;        // Times of m_hits
+
+        // Build work arrays
+        std::vector<uint32_t> m_cells;
+        std::vector<uint32_t> m_fill;
+    };
+
+}   // namespace tdis::tracking
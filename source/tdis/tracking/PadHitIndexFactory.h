@@ -0,0 +1,80 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Builds PadHitIndex of reconstructed hits once per event
+ *
+ *  Hit indexes of the PadHitIndex are indexes in the TrackerHit collection. Plane, ring and pad
+ *  are taken from cellID (PadGeometryTable::DecodeCellId). JANA runs the factory only if some
+ *  stage asks for PadHitIndex, e.g.
+ *
+ *      Input<PadHitIndex> m_hit_index_in{this, {"PadHitIndex"}};
+ *      const auto& index = *m_hit_index_in().at(0);
+ *      index.ForEachHitNear(plane, ring, pad, 0, 1, time - window, time + window, [&](uint32_t hit_index) {
+ *          auto hit = (*m_tracker_hits_in())[hit_index];
+ *      });
+ **/
+
+#pragma once
+
+#include <JANA/Components/JOmniFactory.h>
+#include <JANA/JFactory.h>
+
+#include <tuple>
+#include <vector>
+
+#include "ActsGeometryService.h"
+#include "PadGeometryHelper.hpp"
+#include "PadHitIndex.hpp"
+#include "podio_model/TrackerHit.h"
+#include "podio_model/TrackerHitCollection.h"
+#include "services/LogService.hpp"
+
+namespace tdis::tracking {
+
+    struct PadHitIndexFactory : public JOmniFactory<PadHitIndexFactory> {
+        PodioInput<edm4eic::TrackerHit> m_tracker_hits_in{this, {"TrackerHit"}};
+        Output<PadHitIndex> m_hit_index_out{this, "PadHitIndex"};
+
+        Service<ActsGeometryService> m_service_geometry{this};
+        Service<services::LogService> m_service_log{this};
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        // SoA columns of the event hits, reused between events
+        std::vector<int32_t> m_plane;
+        std::vector<int32_t> m_ring;
+        std::vector<int32_t> m_pad;
+        std::vector<double> m_time;
+        PadHitIndex m_index;        // Rebuilt every event, JANA gets a copy of the index arrays
+
+        void Configure() {
+            m_log = m_service_log->logger("tracking:hit_index");
+            m_index = PadHitIndex(static_cast<int>(m_service_geometry->GetPlanePositions().size()), num_rings, num_pads_per_ring);
+        }
+
+        void ChangeRun(int32_t /*run_nr*/) {
+        }
+
+        void Execute(int32_t /*run_nr*/, uint64_t event_index) {
+            const auto& hits = *m_tracker_hits_in();
+            m_plane.resize(hits.size());
+            m_ring.resize(hits.size());
+            m_pad.resize(hits.size());
+            m_time.resize(hits.size());
+            for (size_t i = 0; i < hits.size(); i++) {
+                const auto hit = hits[i];
+                std::tie(m_plane[i], m_ring[i], m_pad[i]) = PadGeometryTable::DecodeCellId(hit.cellID());
+                m_time[i] = hit.time();
+            }
+
+            m_index.Build(hits.size(), m_plane.data(), m_ring.data(), m_pad.data(), m_time.data());
+            if (m_index.GetSkippedCount()) {
+                m_log->warn("Event {}: {} hits with cellID out of the readout are not indexed", event_index, m_index.GetSkippedCount());
+            }
+
+            // JANA owns the copy after this
+            m_hit_index_out().push_back(new PadHitIndex(m_index.CopyIndex()));
+        }
+    };
+}  // namespace tdis::tracking
@@ -0,0 +1,86 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "PadOccupancy.h"
+
+#include <algorithm>
+
+namespace tdis::tracking {
+
+    void PadOccupancyAccumulator::Shard::Fill(size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad, const double* adc) {
+        for (size_t i = 0; i < count; i++) {
+            const auto hit_plane = static_cast<uint32_t>(plane[i]);
+            const auto hit_ring = static_cast<uint32_t>(ring[i]);
+            const auto hit_pad = static_cast<uint32_t>(pad[i]);
+            if (hit_plane >= m_plane_count || hit_ring >= m_ring_count || hit_pad >= m_pads_per_ring) {
+                continue;
+            }
+
+            // The only writer, so load + store instead of fetch_add
+            const size_t cell = (hit_plane * m_ring_count + hit_ring) * m_pads_per_ring + hit_pad;
+            auto& hit_count = m_hit_counts[cell];
+            auto& adc_sum = m_adc_sums[cell];
+            hit_count.store(hit_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            adc_sum.store(adc_sum.load(std::memory_order_relaxed) + adc[i], std::memory_order_relaxed);
+        }
+        m_event_count.store(m_event_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    PadOccupancyAccumulator::PadOccupancyAccumulator(size_t plane_count, size_t ring_count, size_t pads_per_ring):
+        m_plane_count(plane_count), m_ring_count(ring_count), m_pads_per_ring(pads_per_ring) {}
+
+    PadOccupancyAccumulator::Shard& PadOccupancyAccumulator::AddShard() {
+        auto shard = std::make_unique<Shard>(m_plane_count * m_ring_count * m_pads_per_ring);
+        shard->m_plane_count = static_cast<uint32_t>(m_plane_count);
+        shard->m_ring_count = static_cast<uint32_t>(m_ring_count);
+        shard->m_pads_per_ring = static_cast<uint32_t>(m_pads_per_ring);
+
+        std::lock_guard<std::mutex> locker(m_shards_lock);
+        m_shards.push_back(std::move(shard));
+        return *m_shards.back();
+    }
+
+    std::shared_ptr<const PadOccupancy> PadOccupancyAccumulator::Merge(double hot_factor, uint64_t min_hits) {
+        auto occupancy = std::make_shared<PadOccupancy>(m_plane_count, m_ring_count, m_pads_per_ring);
+
+        std::lock_guard<std::mutex> locker(m_shards_lock);
+        for (const auto& shard: m_shards) {
+            for (size_t cell = 0; cell < occupancy->m_hit_counts.size(); cell++) {
+                occupancy->m_hit_counts[cell] += shard->m_hit_counts[cell].load(std::memory_order_relaxed);
+                occupancy->m_adc_sums[cell] += shard->m_adc_sums[cell].load(std::memory_order_relaxed);
+            }
+            occupancy->m_event_count += shard->m_event_count.load(std::memory_order_relaxed);
+        }
+        occupancy->m_version = ++m_merge_count;
+
+        // Hot pads by the median of their ring
+        std::vector<uint64_t> ring_counts(m_pads_per_ring);
+        for (size_t plane = 0; plane < m_plane_count; plane++) {
+            for (size_t ring = 0; ring < m_ring_count; ring++) {
+                const auto ring_begin = occupancy->m_hit_counts.begin() + occupancy->GetCell(plane, ring, 0);
+                std::copy(ring_begin, ring_begin + m_pads_per_ring, ring_counts.begin());
+                std::nth_element(ring_counts.begin(), ring_counts.begin() + m_pads_per_ring / 2, ring_counts.end());
+                const double median = static_cast<double>(ring_counts[m_pads_per_ring / 2]);
+                uint64_t ring_sum = 0;
+                for (size_t pad = 0; pad < m_pads_per_ring; pad++) {
+                    ring_sum += ring_begin[pad];
+                }
+
+                for (size_t pad = 0; pad < m_pads_per_ring; pad++) {
+                    const uint64_t hit_count = ring_begin[pad];
+
+                    // The median of a sparse ring is 0. The pad itself is not in the mean, so it can't hide a hot pad
+                    const double others_mean = m_pads_per_ring > 1 ? static_cast<double>(ring_sum - hit_count) / static_cast<double>(m_pads_per_ring - 1) : 0;
+                    if (hit_count >= min_hits && hit_count > hot_factor * std::max(median, others_mean)) {
+                        occupancy->m_is_hot[occupancy->GetCell(plane, ring, pad)] = 1;
+                        occupancy->m_hot_pads.emplace_back(plane, ring, pad);
+                    }
+                }
+            }
+        }
+
+        m_occupancy.store(occupancy, std::memory_order_release);
+        return occupancy;
+    }
+
+}   // namespace tdis::tracking
@@ -0,0 +1,110 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Online per pad hit counts and ADC sums with noisy (hot) pad detection
+ *
+ *  Every writer (e.g. each HitFilterFactory instance) gets its own Shard and fills it without locks or
+ *  atomic read-modify-write: a shard has one writer at a time, so a counter is a relaxed load and store.
+ *  Relaxed atomics only make concurrent reads of Merge well defined. Merge sums all shards into an immutable
+ *  PadOccupancy snapshot and publishes it with an atomic shared_ptr, readers take it with GetOccupancy.
+ *
+ *  A pad is hot if it has at least min_hits hits and more than hot_factor times the median count of the
+ *  pads of its (plane, ring). Rings are compared separately as occupancy falls with radius. In a sparse ring
+ *  the median is 0, so the reference is at least the mean count of the other pads of the ring.
+ **/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace tdis::tracking {
+
+    /// Merged occupancy. Never changes after Merge publishes it
+    class PadOccupancy {
+    public:
+        PadOccupancy(size_t plane_count, size_t ring_count, size_t pads_per_ring):
+            m_plane_count(plane_count), m_ring_count(ring_count), m_pads_per_ring(pads_per_ring),
+            m_hit_counts(plane_count * ring_count * pads_per_ring, 0),
+            m_adc_sums(plane_count * ring_count * pads_per_ring, 0),
+            m_is_hot(plane_count * ring_count * pads_per_ring, 0) {}
+
+        /// Number of merges including this one (1 for the first snapshot)
+        uint64_t GetVersion() const { return m_version; }
+        uint64_t GetEventCount() const { return m_event_count; }
+
+        /// Plane, ring and pad must be in range
+        uint64_t GetHitCount(size_t plane, size_t ring, size_t pad) const { return m_hit_counts[GetCell(plane, ring, pad)]; }
+        double GetAdcSum(size_t plane, size_t ring, size_t pad) const { return m_adc_sums[GetCell(plane, ring, pad)]; }
+        bool IsHotPad(size_t plane, size_t ring, size_t pad) const { return m_is_hot[GetCell(plane, ring, pad)]; }
+
+        /// (plane, ring, pad) of hot pads
+        const std::vector<std::tuple<int, int, int>>& GetHotPads() const { return m_hot_pads; }
+
+    private:
+        friend class PadOccupancyAccumulator;
+
+        size_t GetCell(size_t plane, size_t ring, size_t pad) const { return (plane * m_ring_count + ring) * m_pads_per_ring + pad; }
+
+        size_t m_plane_count;
+        size_t m_ring_count;
+        size_t m_pads_per_ring;
+        uint64_t m_version = 0;
+        uint64_t m_event_count = 0;
+        std::vector<uint64_t> m_hit_counts;
+        std::vector<double> m_adc_sums;
+        std::vector<uint8_t> m_is_hot;
+        std::vector<std::tuple<int, int, int>> m_hot_pads;
+    };
+
+    class PadOccupancyAccumulator {
+    public:
+        /// Counters of one writer. Fill must not be called from two threads at the same time
+        class Shard {
+        public:
+            explicit Shard(size_t cell_count): m_hit_counts(cell_count), m_adc_sums(cell_count) {}
+
+            /// Adds hits of one event. Hits with plane, ring or pad out of range are ignored
+            void Fill(size_t count, const int32_t* plane, const int32_t* ring, const int32_t* pad, const double* adc);
+
+        private:
+            friend class PadOccupancyAccumulator;
+
+            uint32_t m_ring_count = 0;
+            uint32_t m_pads_per_ring = 0;
+            uint32_t m_plane_count = 0;
+            std::atomic<uint64_t> m_event_count{0};
+            std::vector<std::atomic<uint64_t>> m_hit_counts;
+            std::vector<std::atomic<double>> m_adc_sums;
+        };
+
+        PadOccupancyAccumulator(size_t plane_count, size_t ring_count, size_t pads_per_ring);
+
+        /// New shard for a writer. The shard lives as long as the accumulator
+        Shard& AddShard();
+
+        /// Sums all shards, finds hot pads and publishes the result. Can be called while shards are filled
+        std::shared_ptr<const PadOccupancy> Merge(double hot_factor, uint64_t min_hits);
+
+        /// Last merged occupancy, nullptr before the first Merge
+        std::shared_ptr<const PadOccupancy> GetOccupancy() const { return m_occupancy.load(std::memory_order_acquire); }
+
+    private:
+        size_t m_plane_count;
+        size_t m_ring_count;
+        size_t m_pads_per_ring;
+
+        std::mutex m_shards_lock;       // AddShard and Merge only, writers never take it
+        std::vector<std::unique_ptr<Shard>> m_shards;
+        uint64_t m_merge_count = 0;
+
+        std::atomic<std::shared_ptr<const PadOccupancy>> m_occupancy;
+    };
+
+}   // namespace tdis::tracking
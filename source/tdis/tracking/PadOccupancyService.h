@@ -0,0 +1,87 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  PadOccupancyService accumulates pad occupancy of the run online (see PadOccupancy.h)
+ *
+ *  Writers take a shard once in Configure and fill it every event, then call CountEvent. Every
+ *  tracking:occupancy:merge_events events one of them merges the shards and publishes a new occupancy with
+ *  hot pads. If a merge is already running, the others don't wait. HitFilterFactory is the writer and the
+ *  hot pad mask user (tracking:hit_filter:hot_pads=true).
+ *
+ *  Configuration Parameters
+ *    - tracking:occupancy:merge_events (uint64, default 1000):
+ *        Events between merges of per thread counters
+ *
+ *    - tracking:occupancy:hot_factor (double, default 10):
+ *        A pad is hot if it has more hits than hot_factor times the median of its ring
+ *        (or the mean of the other pads of the ring if it is larger, e.g. in sparse rings)
+ *
+ *    - tracking:occupancy:min_hits (uint64, default 100):
+ *        Minimal hits of a hot pad, so pads are not masked on low statistics
+ */
+
+#pragma once
+
+#include <JANA/JApplication.h>
+#include <JANA/JException.h>
+#include <JANA/Services/JServiceLocator.h>
+#include <spdlog/logger.h>
+
+#include <atomic>
+#include <memory>
+
+#include "ActsGeometryService.h"
+#include "PadGeometryHelper.hpp"
+#include "PadOccupancy.h"
+#include "services/LogService.hpp"
+
+namespace tdis::tracking {
+
+    class PadOccupancyService : public JService {
+    public:
+        explicit PadOccupancyService() : JService() {}
+        ~PadOccupancyService() override = default;
+
+        void Init() override {
+            m_log = m_service_log->logger("tracking:occupancy");
+            if (m_merge_events() == 0) {
+                throw JException("tracking:occupancy:merge_events must be > 0");
+            }
+            m_accumulator = std::make_unique<PadOccupancyAccumulator>(m_service_geometry->GetPlanePositions().size(),
+                                                                      num_rings, num_pads_per_ring);
+        }
+
+        /// Counters for one writer. See PadOccupancyAccumulator::Shard
+        PadOccupancyAccumulator::Shard& AddShard() { return m_accumulator->AddShard(); }
+
+        /// Call after a shard is filled with an event. Merges shards every merge_events events
+        void CountEvent() {
+            const uint64_t event_count = m_event_count.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (event_count % m_merge_events() != 0 || m_is_merging.test_and_set(std::memory_order_acquire)) {
+                return;
+            }
+
+            auto occupancy = m_accumulator->Merge(m_hot_factor(), m_min_hits());
+            m_is_merging.clear(std::memory_order_release);
+            m_log->debug("Occupancy of {} events is merged, {} hot pads", occupancy->GetEventCount(), occupancy->GetHotPads().size());
+        }
+
+        /// Last merged occupancy, nullptr before the first merge
+        std::shared_ptr<const PadOccupancy> GetOccupancy() const { return m_accumulator->GetOccupancy(); }
+
+    private:
+        Parameter<uint64_t> m_merge_events{this, "tracking:occupancy:merge_events", 1000, "Events between merges of per thread pad counters"};
+        Parameter<double> m_hot_factor{this, "tracking:occupancy:hot_factor", 10.0, "A pad is hot if it has more hits than hot_factor times the median of its ring"};
+        Parameter<uint64_t> m_min_hits{this, "tracking:occupancy:min_hits", 100, "Minimal hits of a hot pad"};
+
+        Service<ActsGeometryService> m_service_geometry{this};
+        Service<tdis::services::LogService> m_service_log{this};
+
+        std::shared_ptr<spdlog::logger> m_log;
+
+        std::unique_ptr<PadOccupancyAccumulator> m_accumulator;
+        std::atomic<uint64_t> m_event_count{0};
+        std::atomic_flag m_is_merging;
+    };
+}   // namespace tdis::tracking
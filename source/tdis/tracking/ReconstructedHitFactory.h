@@ -3,10 +3,12 @@
 #include <JANA/Components/JOmniFactory.h>
 #include <JANA/JFactory.h>
 
-// Needed so that the dynamic_cast to CylinderBounds sees the full definition:
-#include <Acts/Surfaces/CylinderBounds.hpp>
 #include <Acts/Surfaces/Surface.hpp>
 
+#include "ConditionsService.h"
+#include "CylinderLocalCoordinates.hpp"
+#include "DistortionCorrectionService.h"
+#include "HitPositionKernel.h"
 #include "PadGeometryHelper.hpp"
 #include "podio_model/DigitizedMtpcMcHit.h"
 #include "podio_model/Measurement2D.h"
@@ -15,18 +17,6 @@
 #include "podio_model/TrackerHit.h"
 #include "podio_model/TrackerHitCollection.h"
 
-namespace {
-    inline double get_resolution(const double pixel_size) {
-        // 1 / sqrt(12) to approximate uniform distribution RMS
-        constexpr const double sqrt_12 = 3.4641016151;
-        return pixel_size / sqrt_12;
-    }
-    inline double get_variance(const double pixel_size) {
-        const double res = get_resolution(pixel_size);
-        return res * res;
-    }
-}  // namespace
-
 namespace tdis::tracking {
 
     struct ReconstructedHitFactory : public JOmniFactory<ReconstructedHitFactory> {
@@ -37,6 +27,8 @@ namespace tdis::tracking {
 
         Service<ActsGeometryService> m_service_geometry{this};
         Service<services::LogService> m_service_log{this};
+        Service<DistortionCorrectionService> m_service_distortion{this};
+        Service<ConditionsService> m_service_conditions{this};
 
         Parameter<bool> m_cfg_use_true_pos{
             this,
@@ -45,17 +37,93 @@ namespace tdis::tracking {
             "Use true hits xyz instead of digitized one"
         };
 
+        Parameter<std::string> m_cfg_hit_kernel{
+            this,
+            "tracking:hit_position_kernel",
+            "auto",
+            "Digitized hit to position conversion kernel: auto, avx512, avx2 or scalar. auto - the best supported by CPU"
+        };
+
         std::shared_ptr<spdlog::logger> m_log;
 
+        /// Gains, drift velocities and resolutions of the current run. Replaced only in ChangeRun
+        std::shared_ptr<const RunConditions> m_conditions;
+
+        /// Pad centers, radii and covariances by (ring, pad)
+        const PadGeometryTable* m_pad_table = nullptr;
+
+        /// Lookup tables and SoA hits of the event for the vectorized position conversion
+        HitPositionTables m_hit_tables;
+        DigitizedHitBatch m_hit_batch;
+        HitPositionKernel m_hit_kernel = HitPositionKernel::Auto;
+
+        /// Pad center r and phi of the batch hits for the distortion correction
+        std::vector<double> m_hit_r;
+        std::vector<double> m_hit_phi;
+
+        /// Hit positions on ring surfaces for the batch local coordinates conversion. Reused between events
+        CylinderPointBatch m_local_points;
+        std::vector<edm4eic::MutableTrackerHit> m_local_hits;
+        std::vector<const ActsGeometryService::RingSurface*> m_local_surfaces;
+
         void Configure() {
             // Ensure geometry is available, then set up logging
             m_service_geometry();
             m_log = m_service_log->logger("tracking:hit_reco");
+            m_pad_table = &getPadGeometryTable();
+
+            if (m_service_geometry->GetRingSurfaces().size() < num_rings) {
+                throw JException(fmt::format("Geometry has {} ring surfaces while there are {} pad rings",
+                                             m_service_geometry->GetRingSurfaces().size(), num_rings));
+            }
+
+            m_hit_tables = HitPositionTables::Build(*m_pad_table, m_service_geometry->GetPlanePositions());
+            const std::string& kernel_name = m_cfg_hit_kernel();
+            if (kernel_name == "auto") {
+                m_hit_kernel = GetBestHitPositionKernel();
+            } else if (kernel_name == "avx512") {
+                m_hit_kernel = HitPositionKernel::Avx512;
+            } else if (kernel_name == "avx2") {
+                m_hit_kernel = HitPositionKernel::Avx2;
+            } else if (kernel_name == "scalar") {
+                m_hit_kernel = HitPositionKernel::Scalar;
+            } else {
+                throw JException(fmt::format("Unknown tracking:hit_position_kernel='{}'. Use auto, avx512, avx2 or scalar", kernel_name));
+            }
+            if (!IsHitPositionKernelSupported(m_hit_kernel)) {
+                m_log->warn("Hit position kernel '{}' is not supported by this CPU, '{}' is used",
+                            kernel_name, GetHitPositionKernelName(GetBestHitPositionKernel()));
+                m_hit_kernel = GetBestHitPositionKernel();
+            }
+            m_log->debug("Hit position kernel: {}", GetHitPositionKernelName(m_hit_kernel));
+
+            // Local coordinates are computed in closed form, which is right only for cylinders around z axis
+            for (size_t ring = 0; ring < num_rings; ring++) {
+                const auto& ring_surface = m_service_geometry->GetRingSurface(ring);
+                if (!ring_surface.surface->transform(Acts::GeometryContext()).isApprox(Acts::Transform3::Identity())) {
+                    throw JException(fmt::format("Surface of ring {} is not a cylinder centered on z axis", ring));
+                }
+            }
 
         }
 
-        void ChangeRun(int32_t /*run_nr*/) {
-            // No-op for this example
+        void ChangeRun(int32_t run_nr) {
+            m_conditions = m_service_conditions->GetRunConditions(run_nr);
+        }
+
+        /// Shifts x, y and z of the batch hits by the drift distortion at their pad centers
+        void CorrectDistortions() {
+            const size_t count = m_hit_batch.size();
+            m_hit_r.resize(count);
+            m_hit_phi.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                // Hits outside of the readout are skipped later, any r and phi are fine for them
+                const bool valid = m_hit_batch.valid[i];
+                m_hit_r[i] = valid ? m_pad_table->GetRing(m_hit_batch.ring[i]).radius : 0;
+                m_hit_phi[i] = valid ? m_pad_table->GetPad(m_hit_batch.ring[i], m_hit_batch.pad[i]).phi : 0;
+            }
+            m_service_distortion->Correct(count, m_hit_r.data(), m_hit_phi.data(),
+                                          m_hit_batch.x.data(), m_hit_batch.y.data(), m_hit_batch.z.data());
         }
 
         void Execute(int32_t /*run_nr*/, uint64_t event_index) {
@@ -64,42 +132,61 @@ namespace tdis::tracking {
             auto rec_hits     = std::make_unique<edm4eic::TrackerHitCollection>();
             auto measurements = std::make_unique<edm4eic::Measurement2DCollection>();
 
-            // Retrieve plane Z-positions from geometry
-            auto plane_positions = m_service_geometry->GetPlanePositions();
-
             m_log->trace("ReconstructedHitFactory, reconstructing event: {}", event_index);
 
-            for (auto mc_hit : *m_mc_hits_in()) {
+            m_local_points.clear();
+            m_local_hits.clear();
+            m_local_surfaces.clear();
+
+            // Positions, covariances and cell ids of all hits of the event in one vectorized pass
+            const auto& mc_hits = *m_mc_hits_in();
+            m_hit_batch.clear();
+            for (auto mc_hit : mc_hits) {
+                if (mc_hit.pad() == -999) break;
+                // Drift distance from the time if the run has drift velocity of the plane, zToGem from digitization otherwise
+                const bool is_known_plane = static_cast<size_t>(mc_hit.plane()) < m_conditions->GetPlaneCount();
+                const double drift_velocity = is_known_plane ? m_conditions->GetDriftVelocity(mc_hit.plane()) : 0;
+                const double z_to_gem = drift_velocity > 0 ? mc_hit.time() * drift_velocity : mc_hit.zToGem();
+                m_hit_batch.push_back(mc_hit.plane(), mc_hit.ring(), mc_hit.pad(), z_to_gem);
+            }
+            ConvertHitPositions(m_hit_tables, m_hit_batch, m_hit_kernel);
+            if (m_service_distortion->IsEnabled()) {
+                CorrectDistortions();
+            }
+
+            for (size_t i = 0; i < m_hit_batch.size(); i++) {
+                auto mc_hit = mc_hits[i];
 
                 // Basic geometry indices
-                const int plane = mc_hit.plane();
-                const int ring  = mc_hit.ring();
-                const int pad   = mc_hit.pad();
-                const double z_to_gem = mc_hit.zToGem();
-
-                if (pad == -999) break;
-                // Convert ring+pad to (x,y)
-                auto [pad_x, pad_y] = getPadCenter(ring, pad);
-                double plane_z = plane_positions[plane];
-                double ring_radius = getRingCenterRadius(ring);
-
-                // Adjust sign for “even vs odd plane”
-                double calc_z = plane_z + (plane % 2 ? -z_to_gem : z_to_gem);
-
-                double pad_center_r = std::sqrt(pad_x * pad_x + pad_y * pad_y);
-
-                m_log->trace(
-                    "Plane {}, ring {}, pad {}, ring_r {:.2f} pad_r {:.2f} "
-                    "pad_x {:.2f} true_x {:.2f} pad_y {:.2f} true_y {:.2f} "
-                    "plane_z {:.2f} z_to_gem {:.2f} calc_z {:.2f} true_z {:.2f}",
-                    plane, ring, pad, ring_radius, pad_center_r,
-                    pad_x, mc_hit.truePosition().x,
-                    pad_y, mc_hit.truePosition().y,
-                    plane_z, z_to_gem, calc_z, mc_hit.truePosition().z);
+                const int plane = m_hit_batch.plane[i];
+                const int ring  = m_hit_batch.ring[i];
+                const int pad   = m_hit_batch.pad[i];
+
+                if (!m_hit_batch.valid[i]) {
+                    m_log->warn("Hit with plane {} ring {} pad {} is outside of the readout. Skipped", plane, ring, pad);
+                    continue;
+                }
+
+                const double pad_x = m_hit_batch.x[i];
+                const double pad_y = m_hit_batch.y[i];
+                const double plane_z = m_hit_batch.plane_z[i];
+                const double calc_z = m_hit_batch.z[i];     // plane_z +/- zToGem for even/odd planes
+
+                if (m_log->level() <= spdlog::level::trace) {
+                    m_log->trace(
+                        "Plane {}, ring {}, pad {}, ring_r {:.2f} pad_phi {:.3f} "
+                        "pad_x {:.2f} true_x {:.2f} pad_y {:.2f} true_y {:.2f} "
+                        "plane_z {:.2f} z_to_gem {:.2f} calc_z {:.2f} true_z {:.2f}",
+                        plane, ring, pad, m_pad_table->GetRing(ring).radius, m_pad_table->GetPad(ring, pad).phi,
+                        pad_x, mc_hit.truePosition().x,
+                        pad_y, mc_hit.truePosition().y,
+                        plane_z, m_hit_batch.z_to_gem[i], calc_z, mc_hit.truePosition().z);
+                }
 
                 // Choose position: either true or digitized
                 edm4hep::Vector3f position;
-                if (m_cfg_use_true_pos() && !std::isnan(mc_hit.truePosition().x)) {
+                const bool use_true_position = m_cfg_use_true_pos() && !std::isnan(mc_hit.truePosition().x);
+                if (use_true_position) {
                     position.x = mc_hit.truePosition().x;
                     position.y = mc_hit.truePosition().y;
                     position.z = mc_hit.truePosition().z;
@@ -110,128 +197,77 @@ namespace tdis::tracking {
                 }
 
                 // Covariance estimate
-                double max_dimension = std::max(getPadApproxWidth(ring), getPadHight());
-                double xy_variance   = get_variance(max_dimension);
+                double xy_variance   = m_hit_batch.xy_variance[i];
 
-                // For now, put some placeholder 1 cm^2 in z
+                // z variance of the run conditions
                 edm4eic::CovDiag3f cov{static_cast<float>(xy_variance),
                                        static_cast<float>(xy_variance),
-                                       static_cast<float>(1_cm)};
+                                       static_cast<float>(m_conditions->GetZVariance())};
 
-                uint32_t cell_id = 1'000'000 * mc_hit.plane() + 1'000 * mc_hit.ring() + mc_hit.pad();
+                uint32_t cell_id = m_hit_batch.cell_id[i];
 
                 auto hit = rec_hits->create(
                     cell_id,
                     position,
                     cov,
                     static_cast<float>(mc_hit.time()),
-                    static_cast<float>(1_ns),   // Time resolution (placeholder)
-                    static_cast<float>(mc_hit.adc()),
+                    static_cast<float>(m_conditions->GetTimeError() * 1_ns),
+                    static_cast<float>(mc_hit.adc() * m_conditions->GetPadGain(plane, ring, pad)),
                     0.0F
                 );
                 hit.rawHit(mc_hit);
 
-                // Retrieve the geometry element (Acts cylinder) for this ring
-                auto acts_det_element = m_service_geometry().GetDetectorCylinder(mc_hit.ring());
-                auto& surfaceRef      = acts_det_element->surface();
-                auto geometryId = surfaceRef.geometryId().value();
-
-                // ----------------------------------------------------------------------
-                // Print or log the surface type
-                // In ACTS v37.4.0, surface->type() returns Acts::RegularSurface::SurfaceType
-                // ----------------------------------------------------------------------
-                Acts::RegularSurface::SurfaceType sType = surfaceRef.type();
-
-                // Convert enumerator to string
-                std::string sTypeStr = "UnknownSurfaceType";
-
-                // Since the largest enumerator is 'Other' = 7, let's check
-                size_t idx = static_cast<size_t>(sType);
-                if (idx < static_cast<size_t>(Acts::RegularSurface::SurfaceType::Other)) {
-                    switch (sType) {
-                    case Acts::RegularSurface::SurfaceType::Cone:
-                        sTypeStr = "Cone";
-                        break;
-                    case Acts::RegularSurface::SurfaceType::Cylinder:
-                        sTypeStr = "Cylinder";
-                        break;
-                    case Acts::RegularSurface::SurfaceType::Disc:
-                        sTypeStr = "Disc";
-                        break;
-                    case Acts::RegularSurface::SurfaceType::Perigee:
-                        sTypeStr = "Perigee";
-                        break;
-                    case Acts::RegularSurface::SurfaceType::Plane:
-                        sTypeStr = "Plane";
-                        break;
-                    case Acts::RegularSurface::SurfaceType::Straw:
-                        sTypeStr = "Straw";
-                        break;
-                    case Acts::RegularSurface::SurfaceType::Curvilinear:
-                        sTypeStr = "Curvilinear";
-                        break;
-                    default:
-                        sTypeStr = "Other";
-                        break;
-                    }
-                }
-
-                m_log->trace("Surface type for ring {} = {}", ring, sTypeStr);
-
-                // If this surface is a cylinder, log cylinder parameters
-                if (sType == Acts::RegularSurface::SurfaceType::Cylinder) {
-                    auto& surfBounds = surfaceRef.bounds();
-
-                    // Downcast to CylinderBounds (make sure we've included
-                    // <Acts/Surfaces/CylinderBounds.hpp>)
-                    if (const auto* cylBounds
-                        = dynamic_cast<const Acts::CylinderBounds*>(&surfBounds)) {
-                        double radius     = cylBounds->get(Acts::CylinderBounds::eR);
-                        double halfLength = cylBounds->get(Acts::CylinderBounds::eHalfLengthZ);
-                        m_log->trace("  Cylinder radius     = {} mm", radius);
-                        m_log->trace("  Cylinder halfLength = {} mm", halfLength);
-                    } else {
-                        m_log->trace("  [Error] Bounds are not CylinderBounds!");
-                    }
+                // Cylinder surface of this ring from the flat per ring cache of the geometry service
+                const auto& ring_surface = m_service_geometry->GetRingSurface(ring);
+                m_log->trace("  Ring {} cylinder radius = {} mm, halfLength = {} mm", ring, ring_surface.radius, ring_surface.half_length);
+
+                // Local coordinates are computed for all hits of the event at once below
+                // Global position for the surface is (x,y,plane_z)
+                const auto& hit_pos = hit.position();
+                double surface_x = hit_pos.x;
+                double surface_y = hit_pos.y;
+                if (m_service_distortion->IsEnabled() && !use_true_position) {
+                    // Corrected position is off the pad ring in r. The measurement is on the ring surface, so only phi is taken
+                    const double scale = ring_surface.radius / std::hypot(surface_x, surface_y);
+                    surface_x *= scale;
+                    surface_y *= scale;
                 }
+                m_local_points.push_back(ring_surface.radius, surface_x, surface_y, plane_z);
+                m_local_hits.push_back(hit);
+                m_local_surfaces.push_back(&ring_surface);
+            }
 
-                // ----------------------------------------------------------------------
-                // Attempt to find local 2D measurement coordinates on the surface
-                // ----------------------------------------------------------------------
-                const auto& hit_pos = hit.position();  // 3D position from above
-                Acts::Vector2 loc   = Acts::Vector2::Zero();
+            // ----------------------------------------------------------------------
+            // Local 2D measurement coordinates on the ring cylinders
+            // ----------------------------------------------------------------------
+            // Acts tolerance for checking if a point is close to surface
+            const double onSurfaceTolerance = 1 * Acts::UnitConstants::mm;
+            size_t off_surface_count = CylinderGlobalToLocal(m_local_points, onSurfaceTolerance);
+            if (off_surface_count) {
+                m_log->debug("Event {}: {} hits are off their ring surfaces", event_index, off_surface_count);
+            }
 
-                // Acts tolerance for checking if a point is close to surface
-                auto onSurfaceTolerance = 1 * Acts::UnitConstants::mm;
-
-                try {
-                    // Convert global position (x,y,plane_z) to local coords
-                    // geometry context is empty by default
-                    Acts::Vector2 pos = surfaceRef
-                        .globalToLocal(
-                            Acts::GeometryContext(),
-                            {hit_pos.x, hit_pos.y, plane_z},
-                            Acts::Vector3::Zero(),
-                            onSurfaceTolerance
-                        )
-                        .value();
-
-                    // Fill in loc
-                    loc[Acts::eBoundLoc0] = pos[0];
-                    loc[Acts::eBoundLoc1] = pos[1];
-
-                } catch (std::exception& ex) {
-                    auto message = fmt::format("Can't convert globalToLocal for hit: plane={} ring={} pad={} "
-                        "RecoHit x={} y={} z={}. Reason: {}",
-                        mc_hit.plane(), mc_hit.ring(), mc_hit.pad(),
-                        hit_pos.x, hit_pos.y, hit_pos.z, ex.what());
-                    m_log->warn(message);
+            for (size_t i = 0; i < m_local_points.size(); i++) {
+                const auto& hit = m_local_hits[i];
+                const auto& ring_surface = *m_local_surfaces[i];
+                const auto& hit_pos = hit.position();
+
+                if (m_local_points.status[i] != LocalCoordinatesStatus::Success) {
+                    auto raw_hit = hit.rawHit();
+                    m_log->warn("Can't convert globalToLocal for hit: plane={} ring={} pad={} "
+                        "RecoHit x={} y={} z={}. Reason: point is {:.3f} mm away from the surface with R={:.3f} mm",
+                        raw_hit.plane(), raw_hit.ring(), raw_hit.pad(), hit_pos.x, hit_pos.y, hit_pos.z,
+                        std::hypot(m_local_points.x[i], m_local_points.y[i]) - ring_surface.radius, ring_surface.radius);
                     continue;
                 }
 
+                Acts::Vector2 loc   = Acts::Vector2::Zero();
+                loc[Acts::eBoundLoc0] = m_local_points.loc0[i];
+                loc[Acts::eBoundLoc1] = m_local_points.loc1[i];
+
                 // If needed, we can log the center of the surface in global coords
                 if (m_log->level() <= spdlog::level::trace) {
-                    auto surf_center = surfaceRef.center(Acts::GeometryContext());
+                    auto surf_center = ring_surface.surface->center(Acts::GeometryContext());
                     m_log->trace(
                         "   Hit position     : {:>10.2f} {:>10.2f} {:>10.2f}",
                         hit_pos.x, hit_pos.y, hit_pos.z
@@ -249,11 +285,12 @@ namespace tdis::tracking {
                 // Create a new measurement2D
                 auto meas2D = measurements->create();
 
-                meas2D.surface(surfaceRef.geometryId().value());
+                meas2D.surface(ring_surface.geometry_id.value());
                 meas2D.loc({static_cast<float>(loc[0]), static_cast<float>(loc[1])});
                 meas2D.time(hit.time());
 
                 // Covariance on local coords (no off-diagonal for now), plus time
+                const auto& cov = hit.positionError();
                 meas2D.covariance({
                     cov(0, 0),
                     cov(1, 1),
@@ -0,0 +1,94 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Orders measurements of one track for the fitter: by ring (innermost ring first), then within a ring
+ *  by z along the track direction. With this order the navigator crosses ring cylinders outward in a
+ *  single pass instead of going back and forth as measurements come in hit order.
+ *
+ *  Ring is a small integer, so it is a counting sort in O(measurements + rings). Buckets are one or
+ *  a few measurements, they are sorted by z with insertion sort. The sort is stable, measurements with
+ *  the same ring and z keep the input order. Measurements with ring out of range go last in input order.
+ *
+ *  Usage:
+ *      RingMeasurementOrder order(num_rings);
+ *      order.Clear();
+ *      order.Add(measurement_index, ring, z);
+ *      for (auto index: order.Sort(cos_theta >= 0 ? 1 : -1)) { ... }
+ **/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace tdis::tracking {
+
+    class RingMeasurementOrder {
+    public:
+        explicit RingMeasurementOrder(int ring_count = 0): m_ring_count(ring_count) {}
+
+        void Clear() {
+            m_indexes.clear();
+            m_rings.clear();
+            m_z.clear();
+        }
+
+        size_t size() const { return m_indexes.size(); }
+
+        /// index is any user index of the measurement, e.g. its index in the collection
+        void Add(uint32_t index, int ring, double z) {
+            m_indexes.push_back(index);
+            m_rings.push_back(static_cast<uint32_t>(ring) < static_cast<uint32_t>(m_ring_count) ? ring : m_ring_count);
+            m_z.push_back(z);
+        }
+
+        /// Returns indexes of added measurements in fitting order. z_direction > 0 - z increases along the
+        /// track, z_direction < 0 - decreases. The result is valid until the next Add or Sort
+        const std::vector<uint32_t>& Sort(double z_direction) {
+            // Out of range rings are counted in the extra last bucket
+            m_offsets.assign(m_ring_count + 2, 0);
+            for (auto ring: m_rings) {
+                m_offsets[ring + 1]++;
+            }
+            for (size_t ring = 1; ring < m_offsets.size(); ring++) {
+                m_offsets[ring] += m_offsets[ring - 1];
+            }
+
+            const double direction = z_direction < 0 ? -1.0 : 1.0;
+            m_sorted.resize(m_indexes.size());
+            m_sorted_z.resize(m_indexes.size());
+            m_fill.assign(m_offsets.begin(), m_offsets.end() - 1);
+            for (size_t i = 0; i < m_indexes.size(); i++) {
+                const int ring = m_rings[i];
+                uint32_t position = m_fill[ring]++;
+                m_sorted[position] = m_indexes[i];
+                m_sorted_z[position] = direction * m_z[i];
+
+                // The extra bucket keeps the input order
+                if (ring == m_ring_count) continue;
+                for (; position > m_offsets[ring] && m_sorted_z[position - 1] > m_sorted_z[position]; position--) {
+                    std::swap(m_sorted_z[position - 1], m_sorted_z[position]);
+                    std::swap(m_sorted[position - 1], m_sorted[position]);
+                }
+            }
+            return m_sorted;
+        }
+
+    private:
+        int m_ring_count = 0;
+
+        std::vector<uint32_t> m_indexes;
+        std::vector<int> m_rings;
+        std::vector<double> m_z;
+
+        // Sort work arrays
+        std::vector<uint32_t> m_offsets;
+        std::vector<uint32_t> m_fill;
+        std::vector<uint32_t> m_sorted;
+        std::vector<double> m_sorted_z;
+    };
+
+}   // namespace tdis::tracking
@@ -0,0 +1,157 @@
+// Created by Dmitry Romanov, somewhere in 2024
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+/**
+ *  Constants of one run: per pad gains, per plane drift velocity, dead pads and hit resolutions
+ *
+ *  An object is built once per run (see ConditionsService) and published as shared_ptr<const RunConditions>.
+ *  It never changes after that, so factories take a snapshot in ChangeRun and read it in Execute from
+ *  any thread without locks.
+ *
+ *  JSON format (units: ns, mm, mm/ns):
+ *      {
+ *        "defaults": {
+ *          "time_error": 1.0,          // Hit time resolution
+ *          "z_variance": 10.0,         // Hit z variance
+ *          "drift_velocity": 0.0,      // Number for all planes or array by plane. 0 - zToGem of hits is used
+ *          "pad_gain": 1.0             // Gain of pads which are not in pad_gains
+ *        },
+ *        "runs": [
+ *          {
+ *            "first_run": 1000, "last_run": 1099,
+ *            "drift_velocity": [0.0052, 0.0052, ...],
+ *            "pad_gains": [[plane, ring, pad, gain], ...],
+ *            "dead_pads": [[plane, ring, pad], ...]
+ *          }
+ *        ]
+ *      }
+ *  Every "runs" entry with first_run <= run <= last_run is applied over defaults in the file order, so a later
+ *  entry overrides values of an earlier one. Dead pads of all matching entries are added. All keys are optional.
+ **/
+
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace tdis::tracking {
+
+    class RunConditions {
+    public:
+        RunConditions(int32_t run_number, size_t plane_count, size_t ring_count, size_t pads_per_ring):
+            m_run_number(run_number), m_plane_count(plane_count), m_ring_count(ring_count), m_pads_per_ring(pads_per_ring),
+            m_drift_velocities(plane_count, 0.0),
+            m_pad_gains(plane_count * ring_count * pads_per_ring, 1.0f) {}
+
+        int32_t GetRunNumber() const { return m_run_number; }
+        size_t GetPlaneCount() const { return m_plane_count; }
+        size_t GetRingCount() const { return m_ring_count; }
+        size_t GetPadsPerRing() const { return m_pads_per_ring; }
+
+        /// ns
+        double GetTimeError() const { return m_time_error; }
+
+        /// mm^2
+        double GetZVariance() const { return m_z_variance; }
+
+        /// mm/ns. 0 - not known, zToGem of hits should be used. Plane must be less than GetPlaneCount()
+        double GetDriftVelocity(size_t plane) const { return m_drift_velocities[plane]; }
+
+        /// Plane, ring and pad must be in range
+        float GetPadGain(size_t plane, size_t ring, size_t pad) const {
+            return m_pad_gains[(plane * m_ring_count + ring) * m_pads_per_ring + pad];
+        }
+
+        /// (plane, ring, pad) of dead pads
+        const std::vector<std::tuple<int, int, int>>& GetDeadPads() const { return m_dead_pads; }
+
+        /// Conditions of the run from the JSON described above. Throws std::invalid_argument on bad values
+        static std::shared_ptr<const RunConditions> FromJson(const nlohmann::json& json, int32_t run_number,
+                                                             size_t plane_count, size_t ring_count, size_t pads_per_ring) {
+            auto conditions = std::make_shared<RunConditions>(run_number, plane_count, ring_count, pads_per_ring);
+            if (json.contains("defaults")) {
+                conditions->Apply(json["defaults"], "defaults");
+            }
+            if (json.contains("runs")) {
+                for (size_t i = 0; i < json["runs"].size(); i++) {
+                    const auto& entry = json["runs"][i];
+                    const auto first_run = entry.value("first_run", INT32_MIN);
+                    const auto last_run = entry.value("last_run", INT32_MAX);
+                    if (run_number >= first_run && run_number <= last_run) {
+                        conditions->Apply(entry, "runs[" + std::to_string(i) + "]");
+                    }
+                }
+            }
+            return conditions;
+        }
+
+    private:
+        bool IsPad(int plane, int ring, int pad) const {
+            return static_cast<size_t>(plane) < m_plane_count && static_cast<size_t>(ring) < m_ring_count &&
+                   static_cast<size_t>(pad) < m_pads_per_ring;
+        }
+
+        void Apply(const nlohmann::json& entry, const std::string& where) {
+            try {
+                if (entry.contains("time_error")) m_time_error = entry["time_error"].get<double>();
+                if (entry.contains("z_variance")) m_z_variance = entry["z_variance"].get<double>();
+                if (entry.contains("pad_gain")) {
+                    m_pad_gains.assign(m_pad_gains.size(), entry["pad_gain"].get<float>());
+                }
+
+                if (entry.contains("drift_velocity")) {
+                    const auto& velocity = entry["drift_velocity"];
+                    if (velocity.is_number()) {
+                        m_drift_velocities.assign(m_plane_count, velocity.get<double>());
+                    } else if (velocity.size() == m_plane_count) {
+                        m_drift_velocities = velocity.get<std::vector<double>>();
+                    } else {
+                        throw std::invalid_argument("drift_velocity should be a number or " + std::to_string(m_plane_count) + " numbers");
+                    }
+                }
+
+                if (entry.contains("pad_gains")) {
+                    for (const auto& pad_gain: entry["pad_gains"]) {
+                        const auto [plane, ring, pad, gain] = pad_gain.get<std::tuple<int, int, int, float>>();
+                        if (!IsPad(plane, ring, pad)) {
+                            throw std::invalid_argument("pad_gains has a pad out of the readout: " + pad_gain.dump());
+                        }
+                        m_pad_gains[(plane * m_ring_count + ring) * m_pads_per_ring + pad] = gain;
+                    }
+                }
+
+                if (entry.contains("dead_pads")) {
+                    for (const auto& dead_pad: entry["dead_pads"]) {
+                        const auto [plane, ring, pad] = dead_pad.get<std::tuple<int, int, int>>();
+                        if (!IsPad(plane, ring, pad)) {
+                            throw std::invalid_argument("dead_pads has a pad out of the readout: " + dead_pad.dump());
+                        }
+                        m_dead_pads.emplace_back(plane, ring, pad);
+                    }
+                }
+            } catch (const nlohmann::json::exception& e) {
+                throw std::invalid_argument(where + ": " + e.what());
+            } catch (const std::invalid_argument& e) {
+                throw std::invalid_argument(where + ": " + e.what());
+            }
+        }
+
+        int32_t m_run_number;
+        size_t m_plane_count;
+        size_t m_ring_count;
+        size_t m_pads_per_ring;
+        double m_time_error = 1.0;          // ns
+        double m_z_variance = 10.0;         // mm^2
+        std::vector<double> m_drift_velocities;
+        std::vector<float> m_pad_gains;     // By (plane * ring_count + ring) * pads_per_ring + pad
+        std::vector<std::tuple<int, int, int>> m_dead_pads;
+    };
+
+}   // namespace tdis::tracking